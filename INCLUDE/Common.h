@@ -1,3 +1,5 @@
+#pragma once
+
 typedef unsigned short ComponentHndl;
 
 struct Fixed16
@@ -7,6 +7,7 @@
 // ============================================================================================
 
 #include "BeehiveToLuminary.h"
+#include "Parallel.h"
 #include "Tags.h"
 
 #include <ion/core/utils/STL.h>
@@ -15,7 +16,75 @@ namespace luminary
 {
 	namespace beehive
 	{
-		const Actor* FindActorInComponent(const TActorMap& actors, const GameObjectType& gameObjectType, const GameObject* gameObject, const GameObjectType::PrefabChild* prefabChild, const GameObjectArchetype* archetype, int componentIdx)
+		ActorIndex::ActorIndex(const TActorMap& actors, bool indexed)
+			: m_actorMap(actors)
+		{
+			m_indexed = indexed;
+
+			if (m_indexed)
+			{
+				m_actors.reserve(actors.size());
+
+				//First actor with a name wins, as with a linear search
+				for (TActorMap::const_iterator it = actors.begin(), end = actors.end(); it != end; ++it)
+				{
+					m_actors.emplace(ion::string::ToLower(it->second.GetName()), &it->second);
+				}
+			}
+		}
+
+		const Actor* ActorIndex::FindActor(const std::string& name) const
+		{
+			if (m_indexed)
+			{
+				std::unordered_map<std::string, const Actor*>::const_iterator it = m_actors.find(ion::string::ToLower(name));
+				return (it != m_actors.end()) ? it->second : nullptr;
+			}
+
+			for (TActorMap::const_iterator it = m_actorMap.begin(), end = m_actorMap.end(); it != end; ++it)
+			{
+				if (ion::string::CompareNoCase(it->second.GetName(), name))
+				{
+					return &it->second;
+				}
+			}
+
+			return nullptr;
+		}
+
+		const std::string& ActorIndex::GetSpriteSheetLabel(const Actor& actor, const SpriteSheet& spriteSheet)
+		{
+			LabelKey key = std::make_tuple(&actor, &spriteSheet, nullptr);
+
+			std::lock_guard<std::mutex> lock(m_labelsMutex);
+			TLabelMap::const_iterator it = m_labels.find(key);
+			if (it == m_labels.end())
+			{
+				std::stringstream stream;
+				stream << "actor_" << actor.GetName() << "_spritesheet_" << spriteSheet.GetName();
+				it = m_labels.insert(std::make_pair(key, stream.str())).first;
+			}
+
+			return it->second;
+		}
+
+		const std::string& ActorIndex::GetSpriteAnimLabel(const Actor& actor, const SpriteSheet& spriteSheet, const SpriteAnimation& spriteAnim)
+		{
+			LabelKey key = std::make_tuple(&actor, &spriteSheet, &spriteAnim);
+
+			std::lock_guard<std::mutex> lock(m_labelsMutex);
+			TLabelMap::const_iterator it = m_labels.find(key);
+			if (it == m_labels.end())
+			{
+				std::stringstream stream;
+				stream << "actor_" << actor.GetName() << "_sheet_" << spriteSheet.GetName() << "_anim_" << spriteAnim.GetName();
+				it = m_labels.insert(std::make_pair(key, stream.str())).first;
+			}
+
+			return it->second;
+		}
+
+		const Actor* FindActorInComponent(const ActorIndex& actors, const GameObjectType& gameObjectType, const GameObject* gameObject, const GameObjectType::PrefabChild* prefabChild, const GameObjectArchetype* archetype, int componentIdx)
 		{
 			const GameObjectVariable* actorVar = gameObject ? gameObject->FindVariableByTag(luminary::tags::GetTagName(luminary::tags::TagType::SpriteActor), componentIdx) : nullptr;
 
@@ -39,27 +108,19 @@ namespace luminary
 
 			if (actorVar)
 			{
-				for (TActorMap::const_iterator it = actors.begin(), end = actors.end(); it != end && !actor; ++it)
-				{
-					if (ion::string::CompareNoCase(it->second.GetName(), actorVar->m_value))
-					{
-						actor = &it->second;
-					}
-				}
+				actor = actors.FindActor(actorVar->m_value);
 			}
 
 			return actor;
 		}
 
-		const SpriteSheet* FindSpriteSheetInComponent(const TActorMap& actors, const GameObjectType& gameObjectType, const GameObject* gameObject, const GameObjectType::PrefabChild* prefabChild, const GameObjectArchetype* archetype, int componentIdx, std::string& actorName)
+		const SpriteSheet* FindSpriteSheetInComponent(const ActorIndex& actors, const GameObjectType& gameObjectType, const GameObject* gameObject, const GameObjectType::PrefabChild* prefabChild, const GameObjectArchetype* archetype, int componentIdx, const Actor*& actor)
 		{
 			//Get actor
-			const Actor* actor = FindActorInComponent(actors, gameObjectType, gameObject, prefabChild, archetype, componentIdx);
+			actor = FindActorInComponent(actors, gameObjectType, gameObject, prefabChild, archetype, componentIdx);
 			if (!actor)
 				return nullptr;
 
-			actorName = actor->GetName();
-
 			const SpriteSheet* spriteSheet = nullptr;
 
 			//From game object
@@ -83,43 +144,29 @@ namespace luminary
 			return spriteSheet;
 		}
 
-		const Actor* FindSpriteActor(const TActorMap& actors, const std::string& name)
+		const Actor* FindSpriteActor(const ActorIndex& actors, const std::string& name)
 		{
-			const Actor* actor = nullptr;
-
-			for (TActorMap::const_iterator it = actors.begin(), end = actors.end(); it != end && !actor; ++it)
-			{
-				if (ion::string::CompareNoCase(it->second.GetName(), name))
-				{
-					actor = &it->second;
-				}
-			}
-
-			return actor;
+			return actors.FindActor(name);
 		}
 
-		const SpriteSheet* FindSpriteSheet(const TActorMap& actors, const GameObjectType& gameObjectType, const GameObject* gameObject, const GameObjectType::PrefabChild* prefabChild, const GameObjectArchetype* archetype, const std::string& name, int componentIdx, std::string& actorName)
+		const SpriteSheet* FindSpriteSheet(const ActorIndex& actors, const GameObjectType& gameObjectType, const GameObject* gameObject, const GameObjectType::PrefabChild* prefabChild, const GameObjectArchetype* archetype, const std::string& name, int componentIdx, const Actor*& actor)
 		{
 			//Get actor
-			const Actor* actor = FindActorInComponent(actors, gameObjectType, gameObject, prefabChild, archetype, componentIdx);
+			actor = FindActorInComponent(actors, gameObjectType, gameObject, prefabChild, archetype, componentIdx);
 			if (!actor)
 				return nullptr;
 
-			actorName = actor->GetName();
-
 			//Sprite sheet from variable
 			return actor->FindSpriteSheet(name);
 		}
 
-		const SpriteAnimation* FindSpriteAnim(const TActorMap& actors, const GameObjectType& gameObjectType, const GameObject* gameObject, const GameObjectType::PrefabChild* prefabChild, const GameObjectArchetype* archetype, const std::string& name, int componentIdx, std::string& actorName, std::string& sheetName)
+		const SpriteAnimation* FindSpriteAnim(const ActorIndex& actors, const GameObjectType& gameObjectType, const GameObject* gameObject, const GameObjectType::PrefabChild* prefabChild, const GameObjectArchetype* archetype, const std::string& name, int componentIdx, const Actor*& actor, const SpriteSheet*& spriteSheet)
 		{
 			//Get sprite sheet
-			const SpriteSheet* spriteSheet = FindSpriteSheetInComponent(actors, gameObjectType, gameObject, prefabChild, archetype, componentIdx, actorName);
+			spriteSheet = FindSpriteSheetInComponent(actors, gameObjectType, gameObject, prefabChild, archetype, componentIdx, actor);
 			if (!spriteSheet)
 				return nullptr;
 
-			sheetName = spriteSheet->GetName();
-
 			//Sprite anim from variable
 			return spriteSheet->FindAnimation(name);
 		}
@@ -137,21 +184,67 @@ namespace luminary
 			variable.m_tags.push_back(luminary::tags::GetTagName(luminary::tags::TagType::PrefabData));
 		}
 
+		//Tag precedence when converting a variable with several tags
+		static const luminary::tags::TagType s_convertTagOrder[] =
+		{
+			luminary::tags::TagType::EntityDesc,
+			luminary::tags::TagType::EntityArchetype,
+			luminary::tags::TagType::PositionX,
+			luminary::tags::TagType::PositionY,
+			luminary::tags::TagType::SpriteActor,
+			luminary::tags::TagType::SpriteSheet,
+			luminary::tags::TagType::SpriteAnimation,
+			luminary::tags::TagType::ScriptData,
+			luminary::tags::TagType::PrefabData,
+			luminary::tags::TagType::ScriptFunc,
+			luminary::tags::TagType::ScriptGlobal,
+		};
+
+		luminary::tags::TagType FindConvertTag(const luminary::tags::TagSet& tagSet)
+		{
+			if (tagSet.mask)
+			{
+				for (int i = 0; i < sizeof(s_convertTagOrder) / sizeof(s_convertTagOrder[0]); i++)
+				{
+					if (tagSet.HasTag(s_convertTagOrder[i]))
+					{
+						return s_convertTagOrder[i];
+					}
+				}
+			}
+
+			return (luminary::tags::TagType)-1;
+		}
+
 		void ConvertParam(luminary::Param& param, const GameObjectVariable& variable, const GameObjectType& gameObjectType, const GameObjectArchetype* archetype, const GameObject* gameObject, const GameObjectType::PrefabChild* prefabChild, const TActorMap& actors, const luminary::ScriptAddressMap& scriptAddresses)
+		{
+			ActorIndex actorIndex(actors, false);
+			ConvertParam(param, variable, gameObjectType, archetype, gameObject, prefabChild, actorIndex, scriptAddresses);
+		}
+
+		void ConvertParam(luminary::Param& param, const GameObjectVariable& variable, const GameObjectType& gameObjectType, const GameObjectArchetype* archetype, const GameObject* gameObject, const GameObjectType::PrefabChild* prefabChild, ActorIndex& actors, const luminary::ScriptAddressMap& scriptAddresses)
+		{
+			ConvertParam(param, variable, luminary::tags::ParseTags(variable.m_tags), gameObjectType, archetype, gameObject, prefabChild, actors, scriptAddresses);
+		}
+
+		void ConvertParam(luminary::Param& param, const GameObjectVariable& variable, const luminary::tags::TagSet& tagSet, const GameObjectType& gameObjectType, const GameObjectArchetype* archetype, const GameObject* gameObject, const GameObjectType::PrefabChild* prefabChild, ActorIndex& actors, const luminary::ScriptAddressMap& scriptAddresses)
 		{
 			param.name = variable.m_name;
 			param.value = "0";
 
 			std::string scriptAddress;
 
-			//Search for supported tags
-			if (variable.HasTag(luminary::tags::GetTagName(luminary::tags::TagType::EntityDesc)))
+			//Switch on highest precedence supported tag
+			switch (FindConvertTag(tagSet))
+			{
+			case luminary::tags::TagType::EntityDesc:
 			{
 				std::stringstream stream;
 				stream << variable.m_value << "_TypeDesc";
 				param.value = stream.str();
+				break;
 			}
-			else if (variable.HasTag(luminary::tags::GetTagName(luminary::tags::TagType::EntityArchetype)))
+			case luminary::tags::TagType::EntityArchetype:
 			{
 				if (variable.m_value == "0")
 				{
@@ -183,87 +276,78 @@ namespace luminary
 					stream << "Archetype_" << entityTypeName << "_" << variable.m_value;
 					param.value = stream.str();
 				}
+				break;
 			}
-			else if (variable.HasTag(luminary::tags::GetTagName(luminary::tags::TagType::PositionX)))
+			case luminary::tags::TagType::PositionX:
 			{
 				if (gameObject)
 					param.value = std::to_string(gameObject->GetPosition().x + GameObject::spriteSheetBorderX);
+				break;
 			}
-			else if (variable.HasTag(luminary::tags::GetTagName(luminary::tags::TagType::PositionY)))
+			case luminary::tags::TagType::PositionY:
 			{
 				if (gameObject)
 					param.value = std::to_string(gameObject->GetPosition().y + GameObject::spriteSheetBorderY);
+				break;
 			}
-			else if (variable.HasTag(luminary::tags::GetTagName(luminary::tags::TagType::SpriteActor)))
+			case luminary::tags::TagType::SpriteActor:
 			{
 				//Unused
 				param.value = "0";
+				break;
 			}
-			else if (variable.HasTag(luminary::tags::GetTagName(luminary::tags::TagType::SpriteSheet)))
+			case luminary::tags::TagType::SpriteSheet:
 			{
-				std::string actorName;
-				if (const SpriteSheet* spriteSheet = FindSpriteSheet(actors, gameObjectType, gameObject, prefabChild, archetype, variable.m_value, variable.m_componentIdx, actorName))
+				const Actor* actor = nullptr;
+				if (const SpriteSheet* spriteSheet = FindSpriteSheet(actors, gameObjectType, gameObject, prefabChild, archetype, variable.m_value, variable.m_componentIdx, actor))
 				{
-					std::stringstream stream;
-					stream << "actor_" << actorName << "_spritesheet_" << spriteSheet->GetName();
-					param.value = stream.str();
+					param.value = actors.GetSpriteSheetLabel(*actor, *spriteSheet);
 				}
+				break;
 			}
-			else if (variable.HasTag(luminary::tags::GetTagName(luminary::tags::TagType::SpriteAnimation)))
+			case luminary::tags::TagType::SpriteAnimation:
 			{
-				std::string actorName;
-				std::string sheetName;
-				if (const SpriteAnimation* spriteAnim = FindSpriteAnim(actors, gameObjectType, gameObject, prefabChild, archetype, variable.m_value, variable.m_componentIdx, actorName, sheetName))
+				const Actor* actor = nullptr;
+				const SpriteSheet* spriteSheet = nullptr;
+				if (const SpriteAnimation* spriteAnim = FindSpriteAnim(actors, gameObjectType, gameObject, prefabChild, archetype, variable.m_value, variable.m_componentIdx, actor, spriteSheet))
 				{
-					std::stringstream stream;
-					stream << "actor_" << actorName << "_sheet_" << sheetName << "_anim_" << spriteAnim->GetName();
-
-					param.value = stream.str();
+					param.value = actors.GetSpriteAnimLabel(*actor, *spriteSheet, *spriteAnim);
 				}
+				break;
 			}
-			else if (variable.HasTag(luminary::tags::GetTagName(luminary::tags::TagType::ScriptData)))
+			case luminary::tags::TagType::ScriptData:
 			{
 				param.value = std::string("scriptdata_") + gameObjectType.GetName();
+				break;
 			}
-			else if (variable.HasTag(luminary::tags::GetTagName(luminary::tags::TagType::PrefabData)))
+			case luminary::tags::TagType::PrefabData:
 			{
 				param.value = std::string("prefabdata_") + gameObjectType.GetPrefabName();
+				break;
 			}
-			else if (variable.FindTagValue("SCRIPTFUNC", scriptAddress))
-			{
-				ScriptAddressMap::const_iterator it = scriptAddresses.find(gameObjectType.GetName());
-				if (it != scriptAddresses.end())
-				{
-					for (auto address : it->second)
-					{
-						if (address.name == scriptAddress)
-						{
-							std::stringstream stream;
-							stream << "0x" << SSTREAM_HEX4(address.address);
-							param.value = stream.str();
-							break;
-						}
-					}
-				}
-			}
-			else if (variable.FindTagValue("SCRIPTGLOBAL", scriptAddress))
+			case luminary::tags::TagType::ScriptFunc:
+			case luminary::tags::TagType::ScriptGlobal:
 			{
-				ScriptAddressMap::const_iterator it = scriptAddresses.find(gameObjectType.GetName());
-				if (it != scriptAddresses.end())
+				if (tagSet.FindTagValue(luminary::tags::TagType::ScriptFunc, scriptAddress) || tagSet.FindTagValue(luminary::tags::TagType::ScriptGlobal, scriptAddress))
 				{
-					for (auto address : it->second)
+					ScriptAddressMap::const_iterator it = scriptAddresses.find(gameObjectType.GetName());
+					if (it != scriptAddresses.end())
 					{
-						if (address.name == scriptAddress)
+						for (auto address : it->second)
 						{
-							std::stringstream stream;
-							stream << "0x" << SSTREAM_HEX4(address.address);
-							param.value = stream.str();
-							break;
+							if (address.name == scriptAddress)
+							{
+								std::stringstream stream;
+								stream << "0x" << SSTREAM_HEX4(address.address);
+								param.value = stream.str();
+								break;
+							}
 						}
 					}
 				}
+				break;
 			}
-			else
+			default:
 			{
 				param.value = variable.m_value;
 
@@ -275,6 +359,8 @@ namespace luminary
 						param.value = overriddenVar->m_value;
 					}
 				}
+				break;
+			}
 			}
 
 			switch (variable.m_size)
@@ -292,6 +378,12 @@ namespace luminary
 		}
 
 		void ConvertArchetype(const Project& project, const GameObjectArchetype& srcArchetype, const luminary::ScriptAddressMap& scriptAddresses, luminary::Archetype& archetype)
+		{
+			ActorIndex actorIndex(project.GetActors(), false);
+			ConvertArchetype(project, srcArchetype, scriptAddresses, actorIndex, archetype);
+		}
+
+		void ConvertArchetype(const Project& project, const GameObjectArchetype& srcArchetype, const luminary::ScriptAddressMap& scriptAddresses, ActorIndex& actors, luminary::Archetype& archetype)
 		{
 			if (const GameObjectType* gameObjectType = project.GetGameObjectType(srcArchetype.typeId))
 			{
@@ -340,12 +432,18 @@ namespace luminary
 						param = &archetype.components[componentIdx].spawnData.params[paramIdx];
 					}
 
-					ConvertParam(*param, *variable, *gameObjectType, &srcArchetype, nullptr, nullptr, project.GetActors(), scriptAddresses);
+					ConvertParam(*param, *variable, *gameObjectType, &srcArchetype, nullptr, nullptr, actors, scriptAddresses);
 				}
 			}
 		}
 
 		void ConvertPrefabType(const Project& project, const GameObjectType& gameObjectType, luminary::Prefab& prefab)
+		{
+			ActorIndex actorIndex(project.GetActors(), false);
+			ConvertPrefabType(project, gameObjectType, actorIndex, prefab);
+		}
+
+		void ConvertPrefabType(const Project& project, const GameObjectType& gameObjectType, ActorIndex& actors, luminary::Prefab& prefab)
 		{
 			prefab.name = gameObjectType.GetPrefabName();
 			prefab.id = gameObjectType.GetId() & 0xFFFF;
@@ -356,7 +454,7 @@ namespace luminary
 				if (const GameObjectType* childType = project.GetGameObjectType(child.typeId))
 				{
 					luminary::Entity entity;
-					luminary::beehive::ConvertPrefabChild(project, *childType, child, entity);
+					luminary::beehive::ConvertPrefabChild(project, *childType, child, actors, entity);
 					entity.id = child.instanceId;
 					entity.spawnData.positionX = child.relativePos.x;
 					entity.spawnData.positionY = child.relativePos.y;
@@ -379,9 +477,15 @@ namespace luminary
 		}
 
 		void ConvertPrefabChild(const Project& project, const GameObjectType& gameObjectType, const GameObjectType::PrefabChild& prefabChild, luminary::Entity& entity)
+		{
+			ActorIndex actorIndex(project.GetActors(), false);
+			ConvertPrefabChild(project, gameObjectType, prefabChild, actorIndex, entity);
+		}
+
+		void ConvertPrefabChild(const Project& project, const GameObjectType& gameObjectType, const GameObjectType::PrefabChild& prefabChild, ActorIndex& actors, luminary::Entity& entity)
 		{
 			//Convert base type
-			ConvertEntityType(project, gameObjectType, entity);
+			ConvertEntityType(project, gameObjectType, actors, entity);
 
 			entity.spawnData.name = prefabChild.name;
 
@@ -431,11 +535,17 @@ namespace luminary
 					param = &entity.components[componentIdx].spawnData.params[paramIdx];
 				}
 
-				ConvertParam(*param, *variable, gameObjectType, nullptr, nullptr, &prefabChild, project.GetActors(), scriptAddresses);
+				ConvertParam(*param, *variable, gameObjectType, nullptr, nullptr, &prefabChild, actors, scriptAddresses);
 			}
 		}
 
 		void ConvertEntityType(const Project& project, const GameObjectType& gameObjectType, luminary::Entity& entity)
+		{
+			ActorIndex actorIndex(project.GetActors(), false);
+			ConvertEntityType(project, gameObjectType, actorIndex, entity);
+		}
+
+		void ConvertEntityType(const Project& project, const GameObjectType& gameObjectType, ActorIndex& actors, luminary::Entity& entity)
 		{
 			//Entity name and id
 			entity.typeName = gameObjectType.GetName();
@@ -484,7 +594,7 @@ namespace luminary
 					param = &entity.components[componentIdx].spawnData.params[paramIdx];
 				}
 
-				ConvertParam(*param, *variable, gameObjectType, nullptr, nullptr, nullptr, project.GetActors(), scriptAddresses);
+				ConvertParam(*param, *variable, gameObjectType, nullptr, nullptr, nullptr, actors, scriptAddresses);
 			}
 
 			//Convert entity/component script functions
@@ -512,6 +622,12 @@ namespace luminary
 		}
 
 		void ConvertEntityInstance(const Project& project, const GameObjectType& gameObjectType, const GameObject& gameObject, const luminary::ScriptAddressMap& scriptAddresses, luminary::Entity& entity)
+		{
+			ActorIndex actorIndex(project.GetActors(), false);
+			ConvertEntityInstance(project, gameObjectType, gameObject, scriptAddresses, actorIndex, entity);
+		}
+
+		void ConvertEntityInstance(const Project& project, const GameObjectType& gameObjectType, const GameObject& gameObject, const luminary::ScriptAddressMap& scriptAddresses, ActorIndex& actors, luminary::Entity& entity)
 		{
 			//Entity name and id
 			entity.typeName = gameObjectType.GetName();
@@ -575,7 +691,7 @@ namespace luminary
 					param = &entity.components[componentIdx].spawnData.params[paramIdx];
 				}
 
-				ConvertParam(*param, *variable, gameObjectType, nullptr, &gameObject, nullptr, project.GetActors(), scriptAddresses);
+				ConvertParam(*param, *variable, gameObjectType, nullptr, &gameObject, nullptr, actors, scriptAddresses);
 			}
 
 			//Create entity/component script functions
@@ -601,5 +717,212 @@ namespace luminary
 				}
 			}
 		}
+
+		bool IsInstanceTag(luminary::tags::TagType tag)
+		{
+			//Tags whose converted value depends on the game object, not just its type
+			switch (tag)
+			{
+			case luminary::tags::TagType::EntityArchetype:
+			case luminary::tags::TagType::PositionX:
+			case luminary::tags::TagType::PositionY:
+			case luminary::tags::TagType::SpriteSheet:
+			case luminary::tags::TagType::SpriteAnimation:
+				return true;
+			default:
+				return false;
+			}
+		}
+
+		EntityTemplateCache::EntityTemplateCache(const Project& project, const luminary::ScriptAddressMap& scriptAddresses)
+			: m_project(project)
+			, m_scriptAddresses(scriptAddresses)
+			, m_actors(project.GetActors())
+		{
+			m_maxThreads = parallel::s_defaultMaxThreads;
+		}
+
+		void EntityTemplateCache::SetMaxThreads(int maxThreads)
+		{
+			m_maxThreads = maxThreads;
+		}
+
+		void EntityTemplateCache::ConvertEntityInstances(const std::vector<Instance>& instances, std::vector<luminary::Entity>& entities)
+		{
+			//Build all templates up front, the cache is read only while converting
+			for (int i = 0; i < instances.size(); i++)
+			{
+				GetTemplate(*instances[i].first);
+			}
+
+			entities.clear();
+			entities.resize(instances.size());
+
+			parallel::For((int)instances.size(), m_maxThreads, [&](int instanceIdx)
+			{
+				const GameObjectType& gameObjectType = *instances[instanceIdx].first;
+				ConvertFromTemplate(FindTemplate(gameObjectType), gameObjectType, *instances[instanceIdx].second, entities[instanceIdx]);
+			});
+		}
+
+		const EntityTemplateCache::EntityTemplate& EntityTemplateCache::GetTemplate(const GameObjectType& gameObjectType)
+		{
+			std::unordered_map<const GameObjectType*, EntityTemplate>::iterator it = m_templates.find(&gameObjectType);
+			if (it == m_templates.end())
+			{
+				it = m_templates.emplace(&gameObjectType, EntityTemplate()).first;
+				BuildTemplate(gameObjectType, it->second);
+			}
+
+			return it->second;
+		}
+
+		const EntityTemplateCache::EntityTemplate& EntityTemplateCache::FindTemplate(const GameObjectType& gameObjectType) const
+		{
+			//Lookup only, never inserts - safe to call from worker threads once the template is built
+			return m_templates.at(&gameObjectType);
+		}
+
+		void EntityTemplateCache::BuildTemplate(const GameObjectType& gameObjectType, EntityTemplate& entityTemplate)
+		{
+			luminary::Entity& entity = entityTemplate.entity;
+			entity.typeName = gameObjectType.GetName();
+
+			//Same layout as ConvertEntityInstance, from the type's variables only
+			int paramIdx = 0;
+			int componentIdx = -1;
+
+			const std::vector<GameObjectVariable>& variables = gameObjectType.GetVariables();
+			entityTemplate.slots.resize(variables.size());
+
+			for (int j = 0; j < variables.size(); j++, paramIdx++)
+			{
+				const GameObjectVariable& variable = variables[j];
+				luminary::Param* param = nullptr;
+
+				if (variable.m_componentIdx == -1)
+				{
+					//Entity param
+					entity.spawnData.params.resize(paramIdx + 1);
+					param = &entity.spawnData.params[paramIdx];
+				}
+				else
+				{
+					//Component param
+					if (componentIdx != variable.m_componentIdx)
+					{
+						componentIdx = variable.m_componentIdx;
+						entity.components.resize(componentIdx + 1);
+						entity.components[componentIdx].name = variable.m_componentName;
+						paramIdx = 0;
+					}
+
+					entity.components[componentIdx].spawnData.params.resize(paramIdx + 1);
+					param = &entity.components[componentIdx].spawnData.params[paramIdx];
+				}
+
+				ParamSlot& slot = entityTemplate.slots[j];
+				slot.componentIdx = variable.m_componentIdx;
+				slot.paramIdx = paramIdx;
+				slot.variableIdx = j;
+				slot.tagSet = luminary::tags::ParseTags(variable.m_tags);
+
+				if (IsInstanceTag(FindConvertTag(slot.tagSet)))
+				{
+					entityTemplate.instanceSlots.push_back(j);
+				}
+
+				entityTemplate.slotsByName[ion::string::ToLower(variable.m_name)].push_back(j);
+
+				ConvertParam(*param, variable, slot.tagSet, gameObjectType, nullptr, nullptr, nullptr, m_actors, m_scriptAddresses);
+			}
+
+			//Create entity/component script functions
+			const std::vector<GameObjectScriptFunc>& scriptFuncs = gameObjectType.GetScriptFunctions();
+
+			for (int j = 0; j < scriptFuncs.size(); j++)
+			{
+				ScriptFunc scriptFunc;
+				scriptFunc.name = scriptFuncs[j].name;
+				scriptFunc.params = scriptFuncs[j].params;
+				scriptFunc.returnType = scriptFuncs[j].returnType;
+				scriptFunc.routine = scriptFuncs[j].routine;
+
+				if (scriptFuncs[j].componentIdx == -1)
+				{
+					scriptFunc.scope = entity.typeName;
+					entity.scriptFuncs.push_back(scriptFunc);
+				}
+				else
+				{
+					scriptFunc.scope = entity.components[scriptFuncs[j].componentIdx].name;
+					entity.components[scriptFuncs[j].componentIdx].scriptFuncs.push_back(scriptFunc);
+				}
+			}
+		}
+
+		void EntityTemplateCache::ConvertEntityInstance(const GameObjectType& gameObjectType, const GameObject& gameObject, luminary::Entity& entity)
+		{
+			ConvertFromTemplate(GetTemplate(gameObjectType), gameObjectType, gameObject, entity);
+		}
+
+		void EntityTemplateCache::ConvertFromTemplate(const EntityTemplate& entityTemplate, const GameObjectType& gameObjectType, const GameObject& gameObject, luminary::Entity& entity)
+		{
+			const std::vector<GameObjectVariable>& variables = gameObjectType.GetVariables();
+
+			//Start from the type's converted params and script funcs
+			entity = entityTemplate.entity;
+			entity.id = gameObject.GetId() & 0xFFFF;
+
+			//Entity name
+			if (gameObject.GetName().size() > 0)
+				entity.spawnData.name = gameObject.GetName();
+			else
+				entity.spawnData.name = gameObjectType.GetName() + std::to_string(gameObject.GetId());
+
+			//Spawn position
+			entity.spawnData.positionX = gameObject.GetPosition().x + GameObject::spriteSheetBorderX;
+			entity.spawnData.positionY = gameObject.GetPosition().y + GameObject::spriteSheetBorderY;
+			entity.spawnData.width = (gameObject.GetDimensions().x > 0) ? gameObject.GetDimensions().x : gameObjectType.GetDimensions().x;
+			entity.spawnData.height = (gameObject.GetDimensions().y > 0) ? gameObject.GetDimensions().y : gameObjectType.GetDimensions().y;
+
+			//Re-convert instance dependent params, and any sharing a name with an instance variable
+			std::vector<int> dirtySlots = entityTemplate.instanceSlots;
+			const std::vector<GameObjectVariable>& overrides = gameObject.GetVariables();
+
+			for (int i = 0; i < overrides.size(); i++)
+			{
+				std::unordered_map<std::string, std::vector<int>>::const_iterator it = entityTemplate.slotsByName.find(ion::string::ToLower(overrides[i].m_name));
+				if (it != entityTemplate.slotsByName.end())
+				{
+					dirtySlots.insert(dirtySlots.end(), it->second.begin(), it->second.end());
+				}
+			}
+
+			for (int i = 0; i < dirtySlots.size(); i++)
+			{
+				const ParamSlot& slot = entityTemplate.slots[dirtySlots[i]];
+				const GameObjectVariable& typeVariable = variables[slot.variableIdx];
+
+				//Find overridden variable on game object
+				const GameObjectVariable* variable = gameObject.FindVariable(typeVariable.m_name, typeVariable.m_componentIdx);
+
+				if (variable && variable->m_componentIdx != slot.componentIdx)
+				{
+					//Override belongs to another component, layout no longer matches the template
+					entity = luminary::Entity();
+					beehive::ConvertEntityInstance(m_project, gameObjectType, gameObject, m_scriptAddresses, m_actors, entity);
+					return;
+				}
+
+				luminary::Param& param = (slot.componentIdx == -1) ? entity.spawnData.params[slot.paramIdx] : entity.components[slot.componentIdx].spawnData.params[slot.paramIdx];
+
+				//Overrides normally carry their type variable's tags, so reuse its interned set
+				if (variable && variable->m_tags != typeVariable.m_tags)
+					ConvertParam(param, *variable, gameObjectType, nullptr, &gameObject, nullptr, m_actors, m_scriptAddresses);
+				else
+					ConvertParam(param, variable ? *variable : typeVariable, slot.tagSet, gameObjectType, nullptr, &gameObject, nullptr, m_actors, m_scriptAddresses);
+			}
+		}
 	}
 }
\ No newline at end of file
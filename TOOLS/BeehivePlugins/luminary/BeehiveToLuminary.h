@@ -8,10 +8,15 @@
 
 #pragma once
 
+#include <map>
+#include <mutex>
 #include <string>
+#include <tuple>
+#include <unordered_map>
 #include <vector>
 
 #include "Types.h"
+#include "Tags.h"
 
 #include <beehive/Project.h>
 #include <beehive/Actor.h>
@@ -23,16 +28,97 @@ namespace luminary
 {
 	namespace beehive
 	{
+		//Case insensitive actor lookup and sprite label cache. Exporters build one per export and pass it to every
+		//Convert call. The overloads without one wrap the actor map unindexed, searching it linearly as before.
+		class ActorIndex
+		{
+		public:
+			//Indexing costs O(actors) up front, so only do it once per export
+			ActorIndex(const TActorMap& actors, bool indexed = true);
+
+			const Actor* FindActor(const std::string& name) const;
+
+			const std::string& GetSpriteSheetLabel(const Actor& actor, const SpriteSheet& spriteSheet);
+			const std::string& GetSpriteAnimLabel(const Actor& actor, const SpriteSheet& spriteSheet, const SpriteAnimation& spriteAnim);
+
+		private:
+			typedef std::tuple<const Actor*, const SpriteSheet*, const SpriteAnimation*> LabelKey;
+			typedef std::map<LabelKey, std::string> TLabelMap;
+
+			const TActorMap& m_actorMap;
+			bool m_indexed;
+			std::unordered_map<std::string, const Actor*> m_actors;
+			TLabelMap m_labels;
+			std::mutex m_labelsMutex;
+		};
+
 		const SpriteSheet* FindSpriteSheet(const Actor& actor, const GameObjectType& gameObjectType, const GameObject* gameObject, const GameObjectType::PrefabChild* prefabChild, const GameObjectVariable* variable);
 		const SpriteAnimation* FindSpriteAnim(const Actor& actor, const GameObjectType& gameObjectType, const GameObject* gameObject, const GameObjectType::PrefabChild* prefabChild, const GameObjectArchetype* archetype, const GameObjectVariable& variable, std::string& sheetName);
 
 		void CreatePrefabType(GameObjectType& gameObjectType);
 
 		void ConvertParam(luminary::Param& param, const GameObjectVariable& variable, const GameObjectType& gameObjectType, const GameObjectArchetype* archetype, const GameObject* gameObject, const GameObjectType::PrefabChild* prefabChild, const TActorMap& actors, const luminary::ScriptAddressMap& scriptAddresses);
+		void ConvertParam(luminary::Param& param, const GameObjectVariable& variable, const GameObjectType& gameObjectType, const GameObjectArchetype* archetype, const GameObject* gameObject, const GameObjectType::PrefabChild* prefabChild, ActorIndex& actors, const luminary::ScriptAddressMap& scriptAddresses);
+		//Converts with tags interned up front (see EntityTemplateCache), the overloads above intern variable.m_tags per call
+		void ConvertParam(luminary::Param& param, const GameObjectVariable& variable, const luminary::tags::TagSet& tagSet, const GameObjectType& gameObjectType, const GameObjectArchetype* archetype, const GameObject* gameObject, const GameObjectType::PrefabChild* prefabChild, ActorIndex& actors, const luminary::ScriptAddressMap& scriptAddresses);
 		void ConvertArchetype(const Project& project, const GameObjectArchetype& srcArchetype, const luminary::ScriptAddressMap& scriptAddresses, luminary::Archetype& archetype);
+		void ConvertArchetype(const Project& project, const GameObjectArchetype& srcArchetype, const luminary::ScriptAddressMap& scriptAddresses, ActorIndex& actors, luminary::Archetype& archetype);
 		void ConvertPrefabType(const Project& project, const GameObjectType& gameObjectType, luminary::Prefab& prefab);
+		void ConvertPrefabType(const Project& project, const GameObjectType& gameObjectType, ActorIndex& actors, luminary::Prefab& prefab);
 		void ConvertPrefabChild(const Project& project, const GameObjectType& gameObjectType, const GameObjectType::PrefabChild& prefabChild, luminary::Entity& entity);
+		void ConvertPrefabChild(const Project& project, const GameObjectType& gameObjectType, const GameObjectType::PrefabChild& prefabChild, ActorIndex& actors, luminary::Entity& entity);
 		void ConvertEntityType(const Project& project, const GameObjectType& gameObjectType, luminary::Entity& entity);
+		void ConvertEntityType(const Project& project, const GameObjectType& gameObjectType, ActorIndex& actors, luminary::Entity& entity);
 		void ConvertEntityInstance(const Project& project, const GameObjectType& gameObjectType, const GameObject& gameObject, const luminary::ScriptAddressMap& scriptAddresses, luminary::Entity& entity);
+		void ConvertEntityInstance(const Project& project, const GameObjectType& gameObjectType, const GameObject& gameObject, const luminary::ScriptAddressMap& scriptAddresses, ActorIndex& actors, luminary::Entity& entity);
+
+		//Converts game object instances from a per-type template, built on first use. Each instance
+		//starts as a copy of its type's converted params and script funcs, then only re-converts the
+		//params it overrides and those whose tags depend on the instance (position, sprites, archetypes).
+		class EntityTemplateCache
+		{
+		public:
+			typedef std::pair<const GameObjectType*, const GameObject*> Instance;
+
+			EntityTemplateCache(const Project& project, const luminary::ScriptAddressMap& scriptAddresses);
+
+			//Max worker threads for ConvertEntityInstances (0 = one per hardware thread, 1 = serial)
+			void SetMaxThreads(int maxThreads);
+
+			//Builds the type's template on first use, so not safe to call concurrently
+			void ConvertEntityInstance(const GameObjectType& gameObjectType, const GameObject& gameObject, luminary::Entity& entity);
+
+			//Converts instances concurrently, one output entity per instance in the same order.
+			//All templates are built up front, workers only read the cache via FindTemplate.
+			void ConvertEntityInstances(const std::vector<Instance>& instances, std::vector<luminary::Entity>& entities);
+
+		private:
+			struct ParamSlot
+			{
+				int componentIdx;
+				int paramIdx;
+				int variableIdx;
+				luminary::tags::TagSet tagSet;
+			};
+
+			struct EntityTemplate
+			{
+				luminary::Entity entity;
+				std::vector<ParamSlot> slots;
+				std::vector<int> instanceSlots;
+				std::unordered_map<std::string, std::vector<int>> slotsByName;
+			};
+
+			const EntityTemplate& GetTemplate(const GameObjectType& gameObjectType);
+			const EntityTemplate& FindTemplate(const GameObjectType& gameObjectType) const;
+			void ConvertFromTemplate(const EntityTemplate& entityTemplate, const GameObjectType& gameObjectType, const GameObject& gameObject, luminary::Entity& entity);
+			void BuildTemplate(const GameObjectType& gameObjectType, EntityTemplate& entityTemplate);
+
+			const Project& m_project;
+			const luminary::ScriptAddressMap& m_scriptAddresses;
+			ActorIndex m_actors;
+			std::unordered_map<const GameObjectType*, EntityTemplate> m_templates;
+			int m_maxThreads;
+		};
 	}
 }
\ No newline at end of file
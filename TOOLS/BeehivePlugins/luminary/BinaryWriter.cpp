@@ -0,0 +1,42 @@
+// ============================================================================================
+// LUMINARY - a game engine and framework for the SEGA Mega Drive
+// ============================================================================================
+// Matt Phillips - Big Evil Corporation Ltd - 17th October 2026
+// ============================================================================================
+// BinaryWriter.cpp - Buffered big endian writer for exported binaries, flushed in one write
+// ============================================================================================
+
+#include "BinaryWriter.h"
+
+#include <ion/core/io/File.h>
+
+namespace luminary
+{
+	BinaryWriter::BinaryWriter(u32 reserveSize)
+	{
+		m_data.reserve(reserveSize);
+	}
+
+	void BinaryWriter::WriteBytes(const void* data, u32 size)
+	{
+		const u8* bytes = (const u8*)data;
+		m_data.insert(m_data.end(), bytes, bytes + size);
+	}
+
+	bool BinaryWriter::Flush(const std::string& filename) const
+	{
+		ion::io::File file(filename, ion::io::File::OpenMode::Write);
+		if (file.IsOpen())
+		{
+			if (m_data.size() > 0)
+			{
+				file.Write(m_data.data(), m_data.size());
+			}
+
+			file.Close();
+			return true;
+		}
+
+		return false;
+	}
+}
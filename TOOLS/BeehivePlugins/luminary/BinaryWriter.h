@@ -0,0 +1,57 @@
+// ============================================================================================
+// LUMINARY - a game engine and framework for the SEGA Mega Drive
+// ============================================================================================
+// Matt Phillips - Big Evil Corporation Ltd - 17th October 2026
+// ============================================================================================
+// BinaryWriter.h - Buffered big endian writer for exported binaries, flushed in one write
+// ============================================================================================
+
+#pragma once
+
+#include <ion/core/Types.h>
+
+#include <string>
+#include <vector>
+
+namespace luminary
+{
+	class BinaryWriter
+	{
+	public:
+		BinaryWriter(u32 reserveSize = 0);
+
+		//Size up-front from tile/stamp counts, to avoid regrowing mid-export
+		void Reserve(u32 size) { m_data.reserve(size); }
+
+		//Big endian, as the 68000 reads them
+		void WriteU8(u8 value)
+		{
+			m_data.push_back(value);
+		}
+
+		void WriteU16(u16 value)
+		{
+			m_data.push_back((u8)(value >> 8));
+			m_data.push_back((u8)value);
+		}
+
+		void WriteU32(u32 value)
+		{
+			m_data.push_back((u8)(value >> 24));
+			m_data.push_back((u8)(value >> 16));
+			m_data.push_back((u8)(value >> 8));
+			m_data.push_back((u8)value);
+		}
+
+		void WriteBytes(const void* data, u32 size);
+
+		u32 GetSize() const { return (u32)m_data.size(); }
+		const std::vector<u8>& GetData() const { return m_data; }
+
+		//Writes the whole buffer to file in a single write
+		bool Flush(const std::string& filename) const;
+
+	private:
+		std::vector<u8> m_data;
+	};
+}
@@ -0,0 +1,874 @@
+// ============================================================================================
+// LUMINARY - a game engine and framework for the SEGA Mega Drive
+// ============================================================================================
+// Matt Phillips - Big Evil Corporation Ltd - 17th October 2026
+// ============================================================================================
+// CycleEstimator.cpp - Static 68000 cycle estimates for compiled entity script code
+// ============================================================================================
+
+#include "CycleEstimator.h"
+
+#include <algorithm>
+#include <map>
+#include <set>
+
+namespace luminary
+{
+	enum class Flow
+	{
+		Next,			//Falls through
+		Branch,			//Conditional, target or fall through
+		Jump,			//Unconditional, target only
+		Return,			//Leaves the function
+		Indirect,		//Unconditional, unknown target
+	};
+
+	struct Instruction
+	{
+		u32 size;
+		int minCycles;
+		int maxCycles;
+		Flow flow;
+		u32 target;
+	};
+
+	enum OpSize
+	{
+		eOpByte,
+		eOpWord,
+		eOpLong,
+	};
+
+	//Effective address modes, with mode 7 split by register
+	enum EAMode
+	{
+		eEADn,
+		eEAAn,
+		eEAInd,
+		eEAPostInc,
+		eEAPreDec,
+		eEADisp,
+		eEAIndex,
+		eEAAbsW,
+		eEAAbsL,
+		eEAPCDisp,
+		eEAPCIndex,
+		eEAImm,
+		eEAInvalid,
+	};
+
+	//Effective address calculation times, byte/word and long (68000 User's Manual, table 8-1)
+	static const int s_eaCycles[eEAInvalid][2] =
+	{
+		{ 0, 0 },		//Dn
+		{ 0, 0 },		//An
+		{ 4, 8 },		//(An)
+		{ 4, 8 },		//(An)+
+		{ 6, 10 },		//-(An)
+		{ 8, 12 },		//d16(An)
+		{ 10, 14 },		//d8(An,Xn)
+		{ 8, 12 },		//abs.W
+		{ 12, 16 },		//abs.L
+		{ 8, 12 },		//d16(PC)
+		{ 10, 14 },		//d8(PC,Xn)
+		{ 4, 8 },		//#imm
+	};
+
+	//MOVE destination write times, byte/word and long
+	static const int s_moveDstCycles[eEAInvalid][2] =
+	{
+		{ 0, 0 },		//Dn
+		{ 0, 0 },		//An
+		{ 4, 8 },		//(An)
+		{ 4, 8 },		//(An)+
+		{ 4, 8 },		//-(An)
+		{ 8, 12 },		//d16(An)
+		{ 10, 14 },		//d8(An,Xn)
+		{ 8, 12 },		//abs.W
+		{ 12, 16 },		//abs.L
+		{ 0, 0 },
+		{ 0, 0 },
+		{ 0, 0 },
+	};
+
+	//Control addressing times for LEA, PEA, JMP, JSR, indexed by mode from (An)
+	static const int s_leaCycles[eEAInvalid] = { 0, 0, 4, 0, 0, 8, 12, 8, 12, 8, 12, 0 };
+	static const int s_peaCycles[eEAInvalid] = { 0, 0, 12, 0, 0, 16, 20, 16, 20, 16, 20, 0 };
+	static const int s_jmpCycles[eEAInvalid] = { 0, 0, 8, 0, 0, 10, 14, 10, 12, 10, 14, 0 };
+	static const int s_jsrCycles[eEAInvalid] = { 0, 0, 16, 0, 0, 18, 22, 18, 20, 18, 22, 0 };
+
+	//Extra MOVEM time by mode, on top of the register count
+	static const int s_movemCycles[eEAInvalid] = { 0, 0, 0, 0, 0, 4, 6, 4, 8, 4, 6, 0 };
+
+	static u16 ReadWord(const std::vector<u8>& text, u32 offset)
+	{
+		return ((u16)text[offset] << 8) | (u16)text[offset + 1];
+	}
+
+	static EAMode GetEAMode(int mode, int reg)
+	{
+		if (mode < 7)
+			return (EAMode)mode;
+
+		switch (reg)
+		{
+		case 0: return eEAAbsW;
+		case 1: return eEAAbsL;
+		case 2: return eEAPCDisp;
+		case 3: return eEAPCIndex;
+		case 4: return eEAImm;
+		default: return eEAInvalid;
+		}
+	}
+
+	static u32 GetEAExtensionSize(EAMode mode, OpSize size)
+	{
+		switch (mode)
+		{
+		case eEADisp:
+		case eEAIndex:
+		case eEAAbsW:
+		case eEAPCDisp:
+		case eEAPCIndex:
+			return 2;
+		case eEAAbsL:
+			return 4;
+		case eEAImm:
+			return (size == eOpLong) ? 4 : 2;
+		default:
+			return 0;
+		}
+	}
+
+	static int GetEACycles(EAMode mode, OpSize size)
+	{
+		return s_eaCycles[mode][(size == eOpLong) ? 1 : 0];
+	}
+
+	static bool IsRegisterOrImm(EAMode mode)
+	{
+		return mode == eEADn || mode == eEAAn || mode == eEAImm;
+	}
+
+	static int CountBits(u16 mask)
+	{
+		int count = 0;
+
+		for (; mask; mask &= mask - 1)
+		{
+			count++;
+		}
+
+		return count;
+	}
+
+	static bool DecodeInstruction(const std::vector<u8>& text, u32 pc, u32 end, Instruction& instruction)
+	{
+		if (pc + 2 > end)
+			return false;
+
+		u16 op = ReadWord(text, pc);
+		int line = op >> 12;
+		int eaModeBits = (op >> 3) & 7;
+		int eaReg = op & 7;
+		int opSizeBits = (op >> 6) & 3;
+		EAMode ea = GetEAMode(eaModeBits, eaReg);
+		OpSize size = (opSizeBits < 3) ? (OpSize)opSizeBits : eOpWord;
+
+		int cycles = 0;
+		int maxCycles = -1;
+
+		instruction.size = 2;
+		instruction.flow = Flow::Next;
+		instruction.target = 0;
+
+		switch (line)
+		{
+		case 0x0:
+		{
+			if (ea == eEAInvalid)
+				return false;
+
+			if ((op & 0x0100) && eaModeBits == 1)
+			{
+				//MOVEP
+				instruction.size += 2;
+				cycles = (op & 0x0040) ? 24 : 16;
+			}
+			else if ((op & 0x0100) || (op & 0x0F00) == 0x0800)
+			{
+				//BTST/BCHG/BCLR/BSET, dynamic or static (immediate bit number)
+				bool immediate = !(op & 0x0100);
+				int bitOp = (op >> 6) & 3;
+
+				if (immediate)
+					instruction.size += 2;
+
+				instruction.size += GetEAExtensionSize(ea, eOpByte);
+
+				if (ea == eEADn)
+				{
+					static const int s_bitOpDn[4] = { 6, 8, 10, 8 };
+					cycles = s_bitOpDn[bitOp] + (immediate ? 4 : 0);
+				}
+				else
+				{
+					cycles = ((bitOp == 0) ? 4 : 8) + (immediate ? 4 : 0) + GetEACycles(ea, eOpByte);
+				}
+			}
+			else
+			{
+				//ORI/ANDI/SUBI/ADDI/EORI/CMPI
+				int immOp = (op >> 9) & 7;
+				if (immOp == 4 || immOp == 7)
+					return false;
+
+				if (ea == eEAImm)
+				{
+					//To CCR/SR
+					instruction.size += 2;
+					cycles = 20;
+				}
+				else
+				{
+					if (opSizeBits == 3)
+						return false;
+
+					instruction.size += ((size == eOpLong) ? 4 : 2) + GetEAExtensionSize(ea, size);
+
+					bool compare = (immOp == 6);
+
+					if (ea == eEADn)
+					{
+						if (size == eOpLong)
+							cycles = compare ? 14 : ((immOp == 1) ? 14 : 16);
+						else
+							cycles = 8;
+					}
+					else
+					{
+						if (size == eOpLong)
+							cycles = (compare ? 12 : 20) + GetEACycles(ea, size);
+						else
+							cycles = (compare ? 8 : 12) + GetEACycles(ea, size);
+					}
+				}
+			}
+			break;
+		}
+
+		case 0x1:
+		case 0x2:
+		case 0x3:
+		{
+			//MOVE/MOVEA
+			OpSize moveSize = (line == 1) ? eOpByte : ((line == 3) ? eOpWord : eOpLong);
+			EAMode dst = GetEAMode((op >> 6) & 7, (op >> 9) & 7);
+
+			if (ea == eEAInvalid || dst == eEAInvalid || dst >= eEAPCDisp)
+				return false;
+
+			instruction.size += GetEAExtensionSize(ea, moveSize) + GetEAExtensionSize(dst, moveSize);
+			cycles = 4 + GetEACycles(ea, moveSize) + s_moveDstCycles[dst][(moveSize == eOpLong) ? 1 : 0];
+			break;
+		}
+
+		case 0x4:
+		{
+			if (op == 0x4E71)
+			{
+				//NOP
+				cycles = 4;
+			}
+			else if (op == 0x4E75 || op == 0x4E73 || op == 0x4E77)
+			{
+				//RTS/RTE/RTR
+				cycles = (op == 0x4E75) ? 16 : 20;
+				instruction.flow = Flow::Return;
+			}
+			else if (op == 0x4E70)
+			{
+				//RESET
+				cycles = 132;
+			}
+			else if (op == 0x4E72)
+			{
+				//STOP
+				instruction.size += 2;
+				cycles = 4;
+				instruction.flow = Flow::Return;
+			}
+			else if (op == 0x4E76)
+			{
+				//TRAPV
+				cycles = 4;
+			}
+			else if (op == 0x4AFC)
+			{
+				//ILLEGAL
+				return false;
+			}
+			else if ((op & 0xFFF0) == 0x4E40)
+			{
+				//TRAP, handler not counted
+				cycles = 34;
+			}
+			else if ((op & 0xFFF8) == 0x4E50)
+			{
+				//LINK
+				instruction.size += 2;
+				cycles = 16;
+			}
+			else if ((op & 0xFFF8) == 0x4E58)
+			{
+				//UNLK
+				cycles = 12;
+			}
+			else if ((op & 0xFFF0) == 0x4E60)
+			{
+				//MOVE USP
+				cycles = 4;
+			}
+			else if ((op & 0xFF80) == 0x4E80)
+			{
+				//JSR/JMP
+				bool jump = (op & 0x0040) != 0;
+
+				if (ea == eEAInvalid || !s_jmpCycles[ea])
+					return false;
+
+				instruction.size += GetEAExtensionSize(ea, eOpLong);
+				cycles = jump ? s_jmpCycles[ea] : s_jsrCycles[ea];
+
+				if (jump)
+				{
+					if (ea == eEAPCDisp)
+					{
+						instruction.flow = Flow::Jump;
+						instruction.target = pc + 2 + (s16)ReadWord(text, pc + 2);
+					}
+					else
+					{
+						instruction.flow = Flow::Indirect;
+					}
+				}
+			}
+			else if ((op & 0xF1C0) == 0x41C0)
+			{
+				//LEA
+				if (ea == eEAInvalid || !s_leaCycles[ea])
+					return false;
+
+				instruction.size += GetEAExtensionSize(ea, eOpLong);
+				cycles = s_leaCycles[ea];
+			}
+			else if ((op & 0xF1C0) == 0x4180)
+			{
+				//CHK, trap not counted
+				if (ea == eEAInvalid)
+					return false;
+
+				instruction.size += GetEAExtensionSize(ea, eOpWord);
+				cycles = 10 + GetEACycles(ea, eOpWord);
+			}
+			else if ((op & 0xFFF8) == 0x4840)
+			{
+				//SWAP
+				cycles = 4;
+			}
+			else if ((op & 0xFFC0) == 0x4840)
+			{
+				//PEA
+				if (ea == eEAInvalid || !s_peaCycles[ea])
+					return false;
+
+				instruction.size += GetEAExtensionSize(ea, eOpLong);
+				cycles = s_peaCycles[ea];
+			}
+			else if ((op & 0xFFB8) == 0x4880)
+			{
+				//EXT
+				cycles = 4;
+			}
+			else if ((op & 0xFB80) == 0x4880)
+			{
+				//MOVEM, register mask in the extension word
+				if (ea == eEAInvalid || pc + 4 > end)
+					return false;
+
+				bool toRegisters = (op & 0x0400) != 0;
+				int perRegister = (op & 0x0040) ? 8 : 4;
+				int numRegisters = CountBits(ReadWord(text, pc + 2));
+
+				instruction.size += 2 + GetEAExtensionSize(ea, eOpWord);
+				cycles = (toRegisters ? 12 : 8) + (perRegister * numRegisters) + s_movemCycles[ea];
+			}
+			else if ((op & 0xFFC0) == 0x4AC0)
+			{
+				//TAS
+				if (ea == eEAInvalid)
+					return false;
+
+				instruction.size += GetEAExtensionSize(ea, eOpByte);
+				cycles = (ea == eEADn) ? 4 : 14 + GetEACycles(ea, eOpByte);
+			}
+			else if ((op & 0xFFC0) == 0x4800)
+			{
+				//NBCD
+				if (ea == eEAInvalid)
+					return false;
+
+				instruction.size += GetEAExtensionSize(ea, eOpByte);
+				cycles = (ea == eEADn) ? 6 : 8 + GetEACycles(ea, eOpByte);
+			}
+			else if ((op & 0xF900) == 0x4000 && opSizeBits == 3)
+			{
+				//MOVE from SR, to CCR, to SR
+				if (ea == eEAInvalid)
+					return false;
+
+				instruction.size += GetEAExtensionSize(ea, eOpWord);
+
+				if ((op & 0x0600) == 0x0000)
+					cycles = (ea == eEADn) ? 6 : 8 + GetEACycles(ea, eOpWord);
+				else
+					cycles = 12 + GetEACycles(ea, eOpWord);
+			}
+			else if ((op & 0xF900) == 0x4000 || (op & 0xFF00) == 0x4A00)
+			{
+				//NEGX/CLR/NEG/NOT, TST
+				if (ea == eEAInvalid || opSizeBits == 3)
+					return false;
+
+				instruction.size += GetEAExtensionSize(ea, size);
+
+				if ((op & 0xFF00) == 0x4A00)
+					cycles = 4 + GetEACycles(ea, size);
+				else if (ea == eEADn)
+					cycles = (size == eOpLong) ? 6 : 4;
+				else
+					cycles = ((size == eOpLong) ? 12 : 8) + GetEACycles(ea, size);
+			}
+			else
+			{
+				return false;
+			}
+			break;
+		}
+
+		case 0x5:
+		{
+			if (opSizeBits == 3 && eaModeBits == 1)
+			{
+				//DBcc: condition true 12, loop 10, counter expired 14
+				if (pc + 4 > end)
+					return false;
+
+				instruction.size += 2;
+				instruction.flow = Flow::Branch;
+				instruction.target = pc + 2 + (s16)ReadWord(text, pc + 2);
+				cycles = 10;
+				maxCycles = 14;
+			}
+			else if (opSizeBits == 3)
+			{
+				//Scc
+				if (ea == eEAInvalid)
+					return false;
+
+				instruction.size += GetEAExtensionSize(ea, eOpByte);
+
+				if (ea == eEADn)
+				{
+					cycles = 4;
+					maxCycles = 6;
+				}
+				else
+				{
+					cycles = 8 + GetEACycles(ea, eOpByte);
+				}
+			}
+			else
+			{
+				//ADDQ/SUBQ
+				if (ea == eEAInvalid)
+					return false;
+
+				instruction.size += GetEAExtensionSize(ea, size);
+
+				if (ea == eEADn)
+					cycles = (size == eOpLong) ? 8 : 4;
+				else if (ea == eEAAn)
+					cycles = 8;
+				else
+					cycles = ((size == eOpLong) ? 12 : 8) + GetEACycles(ea, size);
+			}
+			break;
+		}
+
+		case 0x6:
+		{
+			//Bcc/BRA/BSR, 8 bit displacement or 16 bit extension word
+			int condition = (op >> 8) & 0xF;
+			s32 displacement = (s8)(op & 0xFF);
+
+			if (displacement == 0)
+			{
+				if (pc + 4 > end)
+					return false;
+
+				instruction.size += 2;
+				displacement = (s16)ReadWord(text, pc + 2);
+			}
+
+			instruction.target = pc + 2 + displacement;
+
+			if (condition == 0)
+			{
+				//BRA
+				instruction.flow = Flow::Jump;
+				cycles = 10;
+			}
+			else if (condition == 1)
+			{
+				//BSR, callee not counted
+				cycles = 18;
+			}
+			else
+			{
+				//Not taken 8 (byte) or 12 (word), taken 10
+				instruction.flow = Flow::Branch;
+				cycles = (instruction.size == 4) ? 10 : 8;
+				maxCycles = (instruction.size == 4) ? 12 : 10;
+			}
+			break;
+		}
+
+		case 0x7:
+		{
+			//MOVEQ
+			if (op & 0x0100)
+				return false;
+
+			cycles = 4;
+			break;
+		}
+
+		case 0x8:
+		case 0x9:
+		case 0xB:
+		case 0xC:
+		case 0xD:
+		{
+			int opMode = (op >> 6) & 7;
+
+			if (ea == eEAInvalid)
+				return false;
+
+			if ((line == 0x8 || line == 0xC) && opMode == 3)
+			{
+				//DIVU/MULU
+				instruction.size += GetEAExtensionSize(ea, eOpWord);
+				cycles = ((line == 0x8) ? 76 : 38) + GetEACycles(ea, eOpWord);
+				maxCycles = ((line == 0x8) ? 140 : 70) + GetEACycles(ea, eOpWord);
+			}
+			else if ((line == 0x8 || line == 0xC) && opMode == 7)
+			{
+				//DIVS/MULS
+				instruction.size += GetEAExtensionSize(ea, eOpWord);
+				cycles = ((line == 0x8) ? 120 : 38) + GetEACycles(ea, eOpWord);
+				maxCycles = ((line == 0x8) ? 158 : 70) + GetEACycles(ea, eOpWord);
+			}
+			else if ((line == 0x8 || line == 0xC) && opMode == 4 && eaModeBits <= 1)
+			{
+				//SBCD/ABCD
+				cycles = (eaModeBits == 0) ? 6 : 18;
+			}
+			else if (line == 0xC && (opMode == 5 || opMode == 6) && eaModeBits <= 1)
+			{
+				//EXG
+				cycles = 6;
+			}
+			else if ((line == 0x9 || line == 0xD || line == 0xB) && (opMode == 3 || opMode == 7))
+			{
+				//SUBA/ADDA/CMPA
+				OpSize addressSize = (opMode == 7) ? eOpLong : eOpWord;
+				instruction.size += GetEAExtensionSize(ea, addressSize);
+
+				if (line == 0xB)
+					cycles = 6 + GetEACycles(ea, addressSize);
+				else if (addressSize == eOpLong)
+					cycles = (IsRegisterOrImm(ea) ? 8 : 6) + GetEACycles(ea, addressSize);
+				else
+					cycles = 8 + GetEACycles(ea, addressSize);
+			}
+			else if ((line == 0x9 || line == 0xD) && opMode >= 4 && eaModeBits <= 1)
+			{
+				//SUBX/ADDX
+				if (eaModeBits == 0)
+					cycles = (size == eOpLong) ? 8 : 4;
+				else
+					cycles = (size == eOpLong) ? 30 : 18;
+			}
+			else if (line == 0xB && opMode >= 4 && eaModeBits == 1)
+			{
+				//CMPM
+				cycles = (size == eOpLong) ? 20 : 12;
+			}
+			else if (opMode < 3)
+			{
+				//OR/SUB/CMP/AND/ADD <ea>,Dn
+				instruction.size += GetEAExtensionSize(ea, size);
+
+				if (size != eOpLong)
+					cycles = 4 + GetEACycles(ea, size);
+				else if (line == 0xB)
+					cycles = 6 + GetEACycles(ea, size);
+				else
+					cycles = (IsRegisterOrImm(ea) ? 8 : 6) + GetEACycles(ea, size);
+			}
+			else
+			{
+				//OR/SUB/EOR/AND/ADD Dn,<ea>
+				instruction.size += GetEAExtensionSize(ea, size);
+
+				if (ea == eEADn)
+					cycles = (size == eOpLong) ? 8 : 4;
+				else
+					cycles = ((size == eOpLong) ? 12 : 8) + GetEACycles(ea, size);
+			}
+			break;
+		}
+
+		case 0xE:
+		{
+			if (opSizeBits == 3)
+			{
+				//Memory shift/rotate, by one
+				if (ea == eEAInvalid)
+					return false;
+
+				instruction.size += GetEAExtensionSize(ea, eOpWord);
+				cycles = 8 + GetEACycles(ea, eOpWord);
+			}
+			else
+			{
+				//Register shift/rotate, 2 cycles per bit
+				int base = (size == eOpLong) ? 8 : 6;
+				int count = (op >> 9) & 7;
+
+				if (op & 0x0020)
+				{
+					//Count in a register, mod 64
+					cycles = base;
+					maxCycles = base + (2 * 63);
+				}
+				else
+				{
+					cycles = base + (2 * ((count == 0) ? 8 : count));
+				}
+			}
+			break;
+		}
+
+		default:
+			//Line A/F emulator traps
+			return false;
+		}
+
+		if (pc + instruction.size > end)
+			return false;
+
+		instruction.minCycles = cycles;
+		instruction.maxCycles = (maxCycles > cycles) ? maxCycles : cycles;
+		return true;
+	}
+
+	bool CycleEstimator::EstimateFunctions(const ElfReader& elf, const std::vector<u8>& text, std::vector<Function>& functions)
+	{
+		const ElfReader::Section* textSection = elf.FindSection(".text");
+		if (!textSection)
+			return false;
+
+		const std::vector<ElfReader::Section>& sections = elf.GetSections();
+		const std::vector<ElfReader::Symbol>& symbols = elf.GetSymbols();
+
+		bool complete = true;
+
+		for (int i = 0; i < symbols.size(); i++)
+		{
+			const ElfReader::Symbol& symbol = symbols[i];
+
+			if (symbol.type == ElfReader::STT_FUNC && symbol.sectionIdx < sections.size() && &sections[symbol.sectionIdx] == textSection && symbol.size > 0)
+			{
+				Function function;
+				function.name = symbol.demangledName;
+				complete &= EstimateFunction(text, symbol.value, symbol.size, function);
+				functions.push_back(function);
+			}
+		}
+
+		return complete;
+	}
+
+	static void FindBackEdges(const std::vector<CycleEstimator::BasicBlock>& blocks, int blockIdx, std::vector<int>& state, std::set<std::pair<int, int>>& backEdges)
+	{
+		//0 = unvisited, 1 = on stack, 2 = done
+		state[blockIdx] = 1;
+
+		for (int i = 0; i < blocks[blockIdx].successors.size(); i++)
+		{
+			int successor = blocks[blockIdx].successors[i];
+
+			if (state[successor] == 1)
+				backEdges.insert(std::make_pair(blockIdx, successor));
+			else if (state[successor] == 0)
+				FindBackEdges(blocks, successor, state, backEdges);
+		}
+
+		state[blockIdx] = 2;
+	}
+
+	static void FindPathCycles(const std::vector<CycleEstimator::BasicBlock>& blocks, int blockIdx, const std::set<std::pair<int, int>>& backEdges, std::vector<std::pair<int, int>>& pathCycles, std::vector<bool>& visited)
+	{
+		const CycleEstimator::BasicBlock& block = blocks[blockIdx];
+		int best = -1;
+		int worst = 0;
+
+		visited[blockIdx] = true;
+
+		for (int i = 0; i < block.successors.size(); i++)
+		{
+			int successor = block.successors[i];
+
+			if (backEdges.find(std::make_pair(blockIdx, successor)) == backEdges.end())
+			{
+				if (!visited[successor])
+					FindPathCycles(blocks, successor, backEdges, pathCycles, visited);
+
+				best = (best == -1) ? pathCycles[successor].first : std::min(best, pathCycles[successor].first);
+				worst = std::max(worst, pathCycles[successor].second);
+			}
+		}
+
+		//Exits, and blocks only looping back, end the path
+		if (best == -1)
+			best = 0;
+
+		pathCycles[blockIdx] = std::make_pair(block.bestCycles + best, block.worstCycles + worst);
+	}
+
+	bool CycleEstimator::EstimateFunction(const std::vector<u8>& text, u32 offset, u32 size, Function& function)
+	{
+		u32 end = std::min<u32>(offset + size, (u32)text.size());
+
+		function.offset = offset;
+		function.size = size;
+		function.blocks.clear();
+		function.bestCycles = 0;
+		function.worstCycles = 0;
+		function.complete = true;
+
+		//Decode linearly, collecting block leaders (entry, branch targets, after control flow)
+		std::map<u32, Instruction> instructions;
+		std::set<u32> leaders;
+		leaders.insert(offset);
+
+		for (u32 pc = offset; pc < end;)
+		{
+			Instruction instruction;
+			if (!DecodeInstruction(text, pc, end, instruction))
+			{
+				function.complete = false;
+				break;
+			}
+
+			instructions[pc] = instruction;
+
+			if (instruction.flow != Flow::Next)
+			{
+				leaders.insert(pc + instruction.size);
+
+				if ((instruction.flow == Flow::Branch || instruction.flow == Flow::Jump) && instruction.target >= offset && instruction.target < end)
+				{
+					leaders.insert(instruction.target);
+				}
+			}
+
+			pc += instruction.size;
+		}
+
+		//Build blocks
+		std::map<u32, int> blockIndices;
+
+		for (std::set<u32>::const_iterator it = leaders.begin(); it != leaders.end(); ++it)
+		{
+			if (instructions.find(*it) != instructions.end())
+			{
+				blockIndices[*it] = (int)function.blocks.size();
+
+				BasicBlock block;
+				block.start = *it;
+				block.end = *it;
+				block.bestCycles = 0;
+				block.worstCycles = 0;
+				function.blocks.push_back(block);
+			}
+		}
+
+		for (int i = 0; i < function.blocks.size(); i++)
+		{
+			BasicBlock& block = function.blocks[i];
+			const Instruction* last = nullptr;
+
+			for (u32 pc = block.start; instructions.find(pc) != instructions.end();)
+			{
+				const Instruction& instruction = instructions[pc];
+				block.bestCycles += instruction.minCycles;
+				block.worstCycles += instruction.maxCycles;
+				block.end = pc + instruction.size;
+				last = &instruction;
+
+				pc += instruction.size;
+
+				if (instruction.flow != Flow::Next || blockIndices.find(pc) != blockIndices.end())
+					break;
+			}
+
+			if (!last)
+				continue;
+
+			//Successors
+			if (last->flow == Flow::Next || last->flow == Flow::Branch)
+			{
+				std::map<u32, int>::const_iterator next = blockIndices.find(block.end);
+				if (next != blockIndices.end())
+					block.successors.push_back(next->second);
+			}
+
+			if (last->flow == Flow::Branch || last->flow == Flow::Jump)
+			{
+				std::map<u32, int>::const_iterator target = blockIndices.find(last->target);
+				if (target != blockIndices.end())
+					block.successors.push_back(target->second);
+			}
+		}
+
+		if (function.blocks.empty())
+			return function.complete;
+
+		//Best/worst path from entry, ignoring back edges so each loop body counts once
+		std::vector<int> state(function.blocks.size(), 0);
+		std::set<std::pair<int, int>> backEdges;
+		FindBackEdges(function.blocks, 0, state, backEdges);
+
+		std::vector<std::pair<int, int>> pathCycles(function.blocks.size(), std::make_pair(0, 0));
+		std::vector<bool> visited(function.blocks.size(), false);
+		FindPathCycles(function.blocks, 0, backEdges, pathCycles, visited);
+
+		function.bestCycles = pathCycles[0].first;
+		function.worstCycles = pathCycles[0].second;
+
+		return function.complete;
+	}
+}
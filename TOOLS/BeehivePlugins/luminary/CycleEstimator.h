@@ -0,0 +1,53 @@
+// ============================================================================================
+// LUMINARY - a game engine and framework for the SEGA Mega Drive
+// ============================================================================================
+// Matt Phillips - Big Evil Corporation Ltd - 17th October 2026
+// ============================================================================================
+// CycleEstimator.h - Static 68000 cycle estimates for compiled entity script code
+// ============================================================================================
+
+#pragma once
+
+#include "ElfReader.h"
+
+#include <ion/core/Types.h>
+
+#include <string>
+#include <vector>
+
+namespace luminary
+{
+	class CycleEstimator
+	{
+	public:
+		struct BasicBlock
+		{
+			u32 start;
+			u32 end;
+			int bestCycles;
+			int worstCycles;
+			std::vector<int> successors;
+		};
+
+		struct Function
+		{
+			std::string name;
+			u32 offset;
+			u32 size;
+			std::vector<BasicBlock> blocks;
+
+			//Shortest and longest path from entry to any exit, loops counted once, calls excluded
+			int bestCycles;
+			int worstCycles;
+
+			//False if an undecodable opcode was hit, estimates then only cover the code before it
+			bool complete;
+		};
+
+		//Estimates every function symbol in .text
+		bool EstimateFunctions(const ElfReader& elf, const std::vector<u8>& text, std::vector<Function>& functions);
+
+		//Decodes a function into basic blocks and estimates its best/worst path
+		bool EstimateFunction(const std::vector<u8>& text, u32 offset, u32 size, Function& function);
+	};
+}
@@ -0,0 +1,331 @@
+// ============================================================================================
+// LUMINARY - a game engine and framework for the SEGA Mega Drive
+// ============================================================================================
+// Matt Phillips - Big Evil Corporation Ltd - 17th October 2026
+// ============================================================================================
+// ElfReader.cpp - Minimal ELF32 big endian object reader, for m68k-elf-gcc script objects
+// ============================================================================================
+
+#include "ElfReader.h"
+
+#include <ion/core/io/File.h>
+
+namespace luminary
+{
+	static const u32 s_sectionTypeSymTab = 2;
+	static const u32 s_sectionTypeRela = 4;
+
+	static const int s_headerSize = 0x34;
+	static const int s_sectionHeaderSize = 0x28;
+	static const int s_symbolSize = 0x10;
+	static const int s_relaSize = 0x0C;
+
+	static u16 ReadU16(const std::vector<u8>& data, u32 offset)
+	{
+		return ((u16)data[offset] << 8) | (u16)data[offset + 1];
+	}
+
+	static u32 ReadU32(const std::vector<u8>& data, u32 offset)
+	{
+		return ((u32)data[offset] << 24) | ((u32)data[offset + 1] << 16) | ((u32)data[offset + 2] << 8) | (u32)data[offset + 3];
+	}
+
+	static std::string ReadString(const std::vector<u8>& data, const ElfReader::Section& strTab, u32 offset)
+	{
+		std::string string;
+
+		for (u32 i = strTab.offset + offset; i < strTab.offset + strTab.size && data[i] != 0; i++)
+		{
+			string += (char)data[i];
+		}
+
+		return string;
+	}
+
+	bool ElfReader::Open(const std::string& filename)
+	{
+		ion::io::File file(filename, ion::io::File::OpenMode::Read);
+		if (!file.IsOpen())
+		{
+			return false;
+		}
+
+		std::vector<u8> data;
+		data.resize(file.GetSize());
+
+		if (data.size() > 0)
+		{
+			file.Read(&data[0], data.size());
+		}
+
+		file.Close();
+
+		return Read(data);
+	}
+
+	bool ElfReader::Read(const std::vector<u8>& data)
+	{
+		m_data = data;
+		m_sections.clear();
+		m_symbols.clear();
+		m_textRelocations.clear();
+
+		//ELF32 (class 1), big endian (data 2)
+		if (m_data.size() < s_headerSize || m_data[0] != 0x7F || m_data[1] != 'E' || m_data[2] != 'L' || m_data[3] != 'F' || m_data[4] != 1 || m_data[5] != 2)
+		{
+			return false;
+		}
+
+		u32 sectionHeaderOffset = ReadU32(m_data, 0x20);
+		u16 sectionHeaderSize = ReadU16(m_data, 0x2E);
+		u16 numSections = ReadU16(m_data, 0x30);
+		u16 sectionNameIdx = ReadU16(m_data, 0x32);
+
+		if (sectionHeaderSize < s_sectionHeaderSize || (u64)sectionHeaderOffset + (u64)sectionHeaderSize * numSections > m_data.size() || sectionNameIdx >= numSections)
+		{
+			return false;
+		}
+
+		//Section headers
+		std::vector<u32> nameOffsets;
+		m_sections.resize(numSections);
+		nameOffsets.resize(numSections);
+
+		for (int i = 0; i < numSections; i++)
+		{
+			u32 headerOffset = sectionHeaderOffset + (i * sectionHeaderSize);
+			Section& section = m_sections[i];
+
+			nameOffsets[i] = ReadU32(m_data, headerOffset + 0x00);
+			section.type = ReadU32(m_data, headerOffset + 0x04);
+			section.offset = ReadU32(m_data, headerOffset + 0x10);
+			section.size = ReadU32(m_data, headerOffset + 0x14);
+			section.link = ReadU32(m_data, headerOffset + 0x18);
+			section.info = ReadU32(m_data, headerOffset + 0x1C);
+
+			//.bss and friends have no file data
+			if (section.type != 8 && (u64)section.offset + section.size > m_data.size())
+			{
+				return false;
+			}
+		}
+
+		for (int i = 0; i < numSections; i++)
+		{
+			m_sections[i].name = ReadString(m_data, m_sections[sectionNameIdx], nameOffsets[i]);
+		}
+
+		//Symbol table
+		int symTabIdx = -1;
+
+		for (int i = 0; i < numSections && symTabIdx == -1; i++)
+		{
+			if (m_sections[i].type == s_sectionTypeSymTab && m_sections[i].link < numSections)
+			{
+				symTabIdx = i;
+			}
+		}
+
+		if (symTabIdx != -1)
+		{
+			const Section& symTab = m_sections[symTabIdx];
+			const Section& strTab = m_sections[symTab.link];
+			int numSymbols = symTab.size / s_symbolSize;
+
+			m_symbols.resize(numSymbols);
+
+			for (int i = 0; i < numSymbols; i++)
+			{
+				u32 symbolOffset = symTab.offset + (i * s_symbolSize);
+				Symbol& symbol = m_symbols[i];
+
+				symbol.name = ReadString(m_data, strTab, ReadU32(m_data, symbolOffset + 0x00));
+				symbol.value = ReadU32(m_data, symbolOffset + 0x04);
+				symbol.size = ReadU32(m_data, symbolOffset + 0x08);
+				symbol.type = m_data[symbolOffset + 0x0C] & 0xF;
+				symbol.sectionIdx = ReadU16(m_data, symbolOffset + 0x0E);
+
+				//Section symbols are unnamed, name them after their section as objdump does
+				if (symbol.name.empty() && symbol.type == STT_SECTION && symbol.sectionIdx < numSections)
+				{
+					symbol.name = m_sections[symbol.sectionIdx].name;
+				}
+
+				symbol.demangledName = Demangle(symbol.name);
+			}
+		}
+
+		//Relocations against .text
+		for (int i = 0; i < numSections; i++)
+		{
+			const Section& section = m_sections[i];
+
+			if (section.type == s_sectionTypeRela && section.info < numSections && m_sections[section.info].name == ".text")
+			{
+				int numRelocations = section.size / s_relaSize;
+
+				for (int j = 0; j < numRelocations; j++)
+				{
+					u32 relaOffset = section.offset + (j * s_relaSize);
+					u32 info = ReadU32(m_data, relaOffset + 0x04);
+
+					Relocation relocation;
+					relocation.offset = ReadU32(m_data, relaOffset + 0x00);
+					relocation.type = info & 0xFF;
+					relocation.symbolIdx = info >> 8;
+					relocation.addend = (s32)ReadU32(m_data, relaOffset + 0x08);
+
+					if (relocation.symbolIdx < m_symbols.size())
+					{
+						m_textRelocations.push_back(relocation);
+					}
+				}
+			}
+		}
+
+		return true;
+	}
+
+	const ElfReader::Section* ElfReader::FindSection(const std::string& name) const
+	{
+		for (int i = 0; i < m_sections.size(); i++)
+		{
+			if (m_sections[i].name == name)
+			{
+				return &m_sections[i];
+			}
+		}
+
+		return nullptr;
+	}
+
+	bool ElfReader::GetSectionData(const std::string& name, std::vector<u8>& data) const
+	{
+		if (const Section* section = FindSection(name))
+		{
+			data.assign(m_data.begin() + section->offset, m_data.begin() + section->offset + section->size);
+			return true;
+		}
+
+		return false;
+	}
+
+	bool ElfReader::IsGOTRelocation(u32 type)
+	{
+		return type >= R_68K_GOT32 && type <= R_68K_GOT8O;
+	}
+
+	static bool DemangleSourceName(const std::string& name, int& pos, std::string& sourceName)
+	{
+		//<length><identifier>
+		int length = 0;
+
+		while (pos < name.size() && name[pos] >= '0' && name[pos] <= '9')
+		{
+			length = (length * 10) + (name[pos++] - '0');
+		}
+
+		if (length == 0 || pos + length > name.size())
+		{
+			return false;
+		}
+
+		sourceName = name.substr(pos, length);
+		pos += length;
+		return true;
+	}
+
+	std::string ElfReader::Demangle(const std::string& name)
+	{
+		if (name.size() < 3 || name[0] != '_' || name[1] != 'Z')
+		{
+			return name;
+		}
+
+		int pos = 2;
+		std::vector<std::string> names;
+
+		//Internal linkage
+		if (name[pos] == 'L')
+		{
+			pos++;
+		}
+
+		if (name[pos] == 'N')
+		{
+			//Nested name, with optional const/volatile/ref qualifiers
+			pos++;
+
+			while (pos < name.size() && (name[pos] == 'K' || name[pos] == 'V' || name[pos] == 'r' || name[pos] == 'R' || name[pos] == 'O'))
+			{
+				pos++;
+			}
+
+			while (pos < name.size() && name[pos] != 'E')
+			{
+				std::string sourceName;
+
+				if (name[pos] == 'S' && pos + 1 < name.size() && name[pos + 1] == 't')
+				{
+					sourceName = "std";
+					pos += 2;
+				}
+				else if (name[pos] == 'C' && pos + 1 < name.size() && !names.empty())
+				{
+					//Constructor
+					sourceName = names.back();
+					pos += 2;
+				}
+				else if (name[pos] == 'D' && pos + 1 < name.size() && !names.empty())
+				{
+					//Destructor
+					sourceName = "~" + names.back();
+					pos += 2;
+				}
+				else if (!DemangleSourceName(name, pos, sourceName))
+				{
+					//Templates, operators, substitutions
+					return name;
+				}
+
+				names.push_back(sourceName);
+			}
+
+			if (pos >= name.size())
+			{
+				return name;
+			}
+
+			pos++;
+		}
+		else
+		{
+			//Unscoped name, not a template
+			std::string sourceName;
+			if (!DemangleSourceName(name, pos, sourceName) || (pos < name.size() && name[pos] == 'I'))
+			{
+				return name;
+			}
+
+			names.push_back(sourceName);
+		}
+
+		std::string demangled;
+
+		for (int i = 0; i < names.size(); i++)
+		{
+			if (i > 0)
+				demangled += "::";
+
+			demangled += names[i];
+		}
+
+		//Remaining chars are the parameter types, only tell apart empty (v) from the rest
+		if (pos == name.size())
+			return demangled;
+		else if (name.substr(pos) == "v")
+			return demangled + "()";
+		else
+			return demangled + "(...)";
+	}
+}
@@ -0,0 +1,91 @@
+// ============================================================================================
+// LUMINARY - a game engine and framework for the SEGA Mega Drive
+// ============================================================================================
+// Matt Phillips - Big Evil Corporation Ltd - 17th October 2026
+// ============================================================================================
+// ElfReader.h - Minimal ELF32 big endian object reader, for m68k-elf-gcc script objects
+// ============================================================================================
+
+#pragma once
+
+#include <ion/core/Types.h>
+
+#include <string>
+#include <vector>
+
+namespace luminary
+{
+	class ElfReader
+	{
+	public:
+		enum RelocationType
+		{
+			R_68K_GOT32 = 7,
+			R_68K_GOT16 = 8,
+			R_68K_GOT8 = 9,
+			R_68K_GOT32O = 10,
+			R_68K_GOT16O = 11,
+			R_68K_GOT8O = 12,
+		};
+
+		struct Section
+		{
+			std::string name;
+			u32 type;
+			u32 offset;
+			u32 size;
+			u32 link;
+			u32 info;
+		};
+
+		enum SymbolType
+		{
+			STT_NOTYPE = 0,
+			STT_OBJECT = 1,
+			STT_FUNC = 2,
+			STT_SECTION = 3,
+		};
+
+		struct Symbol
+		{
+			std::string name;
+			std::string demangledName;
+			u32 value;
+			u32 size;
+			u8 type;
+			u16 sectionIdx;
+		};
+
+		struct Relocation
+		{
+			u32 offset;
+			u32 type;
+			u32 symbolIdx;
+			s32 addend;
+		};
+
+		bool Open(const std::string& filename);
+		bool Read(const std::vector<u8>& data);
+
+		u32 GetSize() const { return (u32)m_data.size(); }
+		const std::vector<Section>& GetSections() const { return m_sections; }
+		const std::vector<Symbol>& GetSymbols() const { return m_symbols; }
+
+		//Relocations applying to .text, in table order
+		const std::vector<Relocation>& GetTextRelocations() const { return m_textRelocations; }
+
+		const Section* FindSection(const std::string& name) const;
+		bool GetSectionData(const std::string& name, std::vector<u8>& data) const;
+
+		static bool IsGOTRelocation(u32 type);
+
+		//Itanium C++ demangling, nested names only (Scope::name), parameter types aren't decoded
+		static std::string Demangle(const std::string& name);
+
+	private:
+		std::vector<u8> m_data;
+		std::vector<Section> m_sections;
+		std::vector<Symbol> m_symbols;
+		std::vector<Relocation> m_textRelocations;
+	};
+}
@@ -8,12 +8,19 @@
 // ============================================================================================
 
 #include "EntityParser.h"
+#include "Parallel.h"
 
 #include <ion/core/io/File.h>
 #include <ion/core/io/FileDevice.h>
 #include <ion/core/string/String.h>
 
 #include <cctype>
+#include <algorithm>
+#include <iterator>
+#include <string_view>
+#include <filesystem>
+#include <unordered_map>
+#include <unordered_set>
 
 static const std::vector<std::string> s_asmExtensions =
 {
@@ -43,17 +50,52 @@ static const std::string s_rsLong = "rs.l";
 static const std::string s_tagStart = "[TAGS=";
 static const std::string s_tagEnd = "]";
 static const std::string s_tagDelim = ",";
-static const std::vector<char> s_tokenDelim = { ' ', ',', '\t' };
-static const std::vector<char> s_lineEndings = { '\r', '\n' };
+static const u32 s_cacheMagic = 0x4C504331; // LPC1
 
 namespace luminary
 {
 	EntityParser::EntityParser()
 	{
+		//Serial unless opted in, file reads go through ion::io on the worker threads
+		m_maxThreads = 1;
+		m_cacheEnabled = false;
+		m_cacheLoaded = false;
+		m_numFilesScanned = 0;
+	}
+
+	void EntityParser::SetMaxThreads(int maxThreads)
+	{
+		m_maxThreads = maxThreads;
+	}
+
+	void EntityParser::SetCacheEnabled(bool enabled)
+	{
+		m_cacheEnabled = enabled;
 
+		if (!m_cacheEnabled)
+		{
+			m_cache.clear();
+		}
 	}
 
-	void RecursiveFindASMFiles(ion::io::FileDevice& fileDevice, const std::string& directory, std::vector<std::string>& asmFiles)
+	void EntityParser::SetCacheFilename(const std::string& filename)
+	{
+		m_cacheFilename = filename;
+		m_cacheLoaded = false;
+
+		if (m_cacheFilename.size() > 0)
+		{
+			m_cacheEnabled = true;
+		}
+	}
+
+	//Key for finding the same file through overlapping or unnormalised (trailing separator, "..") directories
+	std::string GetFileKey(const std::string& filename)
+	{
+		return std::filesystem::path(filename).lexically_normal().generic_string();
+	}
+
+	void RecursiveFindASMFiles(ion::io::FileDevice& fileDevice, const std::string& directory, std::vector<std::string>& asmFiles, std::unordered_set<std::string>& foundFiles)
 	{
 		std::vector<ion::io::FileDevice::DirectoryItem> contents;
 		fileDevice.ReadDirectory(directory, contents);
@@ -65,102 +107,256 @@ namespace luminary
 				if (contents[i].m_filename != "." && contents[i].m_filename != "..")
 				{
 					std::string subDir = directory + fileDevice.GetPathSeparator() + contents[i].m_filename;
-					RecursiveFindASMFiles(fileDevice, subDir, asmFiles);
+					RecursiveFindASMFiles(fileDevice, subDir, asmFiles, foundFiles);
 				}
 			}
 			else if (contents[i].m_fileType == ion::io::FileDevice::FileType::File)
 			{
-				for (int j = 0; j < s_asmExtensions.size(); j++)
+				if (EntityParser::IsASMFile(contents[i].m_filename))
 				{
-					if (ion::string::EndsWith(ion::string::ToLower(contents[i].m_filename), s_asmExtensions[j]))
-					{
-						std::string fullPath = directory + fileDevice.GetPathSeparator() + contents[i].m_filename;
+					std::string fullPath = directory + fileDevice.GetPathSeparator() + contents[i].m_filename;
 
-						if (std::find(asmFiles.begin(), asmFiles.end(), fullPath) == asmFiles.end())
-						{
-							asmFiles.push_back(fullPath);
-						}
-
-						break;
+					//Directories may overlap, only take each file once
+					if (foundFiles.insert(GetFileKey(fullPath)).second)
+					{
+						asmFiles.push_back(fullPath);
 					}
 				}
 			}
 		}
 	}
 
+	//Maps lowercase name to index of first item with that name, for case insensitive lookup
+	template <typename T> void BuildNameIndex(const std::vector<T>& items, std::unordered_map<std::string, int>& index)
+	{
+		index.clear();
+		index.reserve(items.size());
+
+		for (int i = 0; i < items.size(); i++)
+		{
+			index.emplace(ion::string::ToLower(items[i].name), i);
+		}
+	}
+
+	int FindNameIndex(const std::unordered_map<std::string, int>& index, const std::string& name)
+	{
+		std::unordered_map<std::string, int>::const_iterator it = index.find(ion::string::ToLower(name));
+		return (it != index.end()) ? it->second : -1;
+	}
+
+	bool GetFileSizeAndTime(const std::string& filename, u64& size, u64& modifiedTime)
+	{
+		std::error_code error;
+		std::filesystem::path path(filename);
+
+		size = std::filesystem::file_size(path, error);
+		if (error)
+			return false;
+
+		modifiedTime = std::filesystem::last_write_time(path, error).time_since_epoch().count();
+		if (error)
+			return false;
+
+		return true;
+	}
+
+	void EntityParser::FindASMFiles(const std::vector<std::string>& directories, std::vector<std::string>& filenames)
+	{
+		std::unordered_set<std::string> foundFiles;
+
+		for (int i = 0; i < filenames.size(); i++)
+		{
+			foundFiles.insert(GetFileKey(filenames[i]));
+		}
+
+		for (auto directory : directories)
+		{
+			RecursiveFindASMFiles(*ion::io::FileDevice::GetDefault(), directory, filenames, foundFiles);
+		}
+	}
+
+	bool EntityParser::IsASMFile(const std::string& filename)
+	{
+		std::string lowerFilename = ion::string::ToLower(filename);
+
+		for (int i = 0; i < s_asmExtensions.size(); i++)
+		{
+			if (ion::string::EndsWith(lowerFilename, s_asmExtensions[i]))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
 	bool EntityParser::ParseDirectories(const std::vector<std::string>& directories, std::vector<Entity>& entities)
 	{
 		if (ion::io::FileDevice::GetDefault())
 		{
-			for (auto directory : directories)
-			{
-				//Recursively search directory for ASM files
-				std::vector<std::string> asmFiles;
-				RecursiveFindASMFiles(*ion::io::FileDevice::GetDefault(), directory, asmFiles);
+			//Recursively search all directories for ASM files first
+			std::vector<std::string> asmFiles;
+			FindASMFiles(directories, asmFiles);
 
-				//Find all entity and component text blocks
-				for (int i = 0; i < asmFiles.size(); i++)
-				{
-					FindTextBlocks(asmFiles[i]);
-				}
+			return ParseFiles(asmFiles, entities);
+		}
 
-				//Parse component spawn data
-				for (int i = 0; i < m_componentSpawnTextBlocks.size(); i++)
-				{
-					SpawnData spawnData;
-					ParseSpawnData(m_componentSpawnTextBlocks[i], spawnData);
-					m_componentSpawnData.push_back(spawnData);
-				}
+		return false;
+	}
 
-				//Parse entity spawn data
-				for (int i = 0; i < m_entitySpawnTextBlocks.size(); i++)
-				{
-					SpawnData spawnData;
-					ParseSpawnData(m_entitySpawnTextBlocks[i], spawnData);
-					m_entitySpawnData.push_back(spawnData);
-				}
+	bool EntityParser::ParseFiles(const std::vector<std::string>& filenames, std::vector<Entity>& entities)
+	{
+		//Load text blocks from previous session
+		if (m_cacheFilename.size() > 0 && !m_cacheLoaded)
+		{
+			LoadCache();
+			m_cacheLoaded = true;
+		}
 
-				//Parse components and match with spawn data
-				for (int i = 0; i < m_componentTextBlocks.size(); i++)
-				{
-					Component component;
-					if (ParseComponent(m_componentTextBlocks[i], component))
-					{
-						m_components.push_back(component);
-					}
-				}
+		//Find all entity and component text blocks
+		ScanFiles(filenames);
 
-				//Parse entities and match with spawn data
-				for (int i = 0; i < m_entityTextBlocks.size(); i++)
-				{
-					Entity entity;
-					if (ParseEntity(m_entityTextBlocks[i], entity))
-					{
-						entities.push_back(entity);
-					}
-				}
+		//Save cache, dropping files which no longer exist
+		if (m_cacheFilename.size() > 0)
+		{
+			SaveCache(filenames);
+		}
 
-				//Parse static entities
-				for (int i = 0; i < m_staticEntityTextBlocks.size(); i++)
-				{
-					Entity entity;
-					ParseStaticEntity(m_staticEntityTextBlocks[i], entity);
-					entities.push_back(entity);
-				}
-			}
+		//Parse every block once, now all components and spawn data are known
+		ParseTextBlocks(entities);
 
+		return true;
+	}
+
+	bool EntityParser::HasChanges(const std::vector<std::string>& filenames) const
+	{
+		if (filenames.size() != m_cache.size())
+		{
 			return true;
 		}
 
+		for (int i = 0; i < filenames.size(); i++)
+		{
+			std::map<std::string, ScannedFile>::const_iterator it = m_cache.find(filenames[i]);
+
+			u64 size = 0;
+			u64 modifiedTime = 0;
+
+			if (it == m_cache.end() || !GetFileSizeAndTime(filenames[i], size, modifiedTime) || size != it->second.size || modifiedTime != it->second.modifiedTime)
+			{
+				return true;
+			}
+		}
+
 		return false;
 	}
 
-	std::string EntityParser::GetNameToken(const std::vector<std::string>& tokens)
+	void EntityParser::ScanFiles(const std::vector<std::string>& filenames)
+	{
+		m_entityTextBlocks.clear();
+		m_staticEntityTextBlocks.clear();
+		m_entitySpawnTextBlocks.clear();
+		m_componentTextBlocks.clear();
+		m_componentSpawnTextBlocks.clear();
+
+		//One result slot per file
+		std::vector<ScannedFile> scannedFiles(filenames.size());
+		std::vector<u8> tokenised(filenames.size(), 0);
+
+		parallel::For((int)filenames.size(), m_maxThreads, [&](int fileIdx)
+		{
+			tokenised[fileIdx] = ScanFile(filenames[fileIdx], scannedFiles[fileIdx]);
+		});
+
+		m_numFilesScanned = (int)std::count(tokenised.begin(), tokenised.end(), 1);
+
+		//Update cache, and merge in file order so output matches a serial scan
+		if (m_cacheEnabled)
+		{
+			m_cache.clear();
+		}
+
+		for (int i = 0; i < scannedFiles.size(); i++)
+		{
+			if (m_cacheEnabled)
+			{
+				m_cache[filenames[i]] = scannedFiles[i];
+			}
+
+			MergeTextBlocks(scannedFiles[i].textBlocks);
+		}
+	}
+
+	void EntityParser::ParseTextBlocks(std::vector<Entity>& entities)
+	{
+		m_entitySpawnData.clear();
+		m_componentSpawnData.clear();
+		m_components.clear();
+		m_componentDefinitions.clear();
+
+		//Parse component spawn data
+		for (int i = 0; i < m_componentSpawnTextBlocks.size(); i++)
+		{
+			SpawnData spawnData;
+			ParseSpawnData(m_componentSpawnTextBlocks[i], spawnData);
+			m_componentSpawnData.push_back(std::move(spawnData));
+		}
+
+		//Parse entity spawn data
+		for (int i = 0; i < m_entitySpawnTextBlocks.size(); i++)
+		{
+			SpawnData spawnData;
+			ParseSpawnData(m_entitySpawnTextBlocks[i], spawnData);
+			m_entitySpawnData.push_back(std::move(spawnData));
+		}
+
+		//Index spawn data by name
+		BuildNameIndex(m_componentSpawnData, m_componentSpawnDataIndex);
+		BuildNameIndex(m_entitySpawnData, m_entitySpawnDataIndex);
+
+		//Parse components and match with spawn data
+		for (int i = 0; i < m_componentTextBlocks.size(); i++)
+		{
+			Component component;
+			if (ParseComponent(m_componentTextBlocks[i], component))
+			{
+				m_components.push_back(std::move(component));
+			}
+		}
+
+		//Index components by name, and share one copy of each with every entity that uses it
+		BuildNameIndex(m_components, m_componentIndex);
+
+		for (int i = 0; i < m_components.size(); i++)
+		{
+			m_componentDefinitions.push_back(std::make_shared<const Component>(m_components[i]));
+		}
+
+		//Parse entities and match with spawn data
+		for (int i = 0; i < m_entityTextBlocks.size(); i++)
+		{
+			Entity entity;
+			if (ParseEntity(m_entityTextBlocks[i], entity))
+			{
+				entities.push_back(std::move(entity));
+			}
+		}
+
+		//Parse static entities
+		for (int i = 0; i < m_staticEntityTextBlocks.size(); i++)
+		{
+			Entity entity;
+			ParseStaticEntity(m_staticEntityTextBlocks[i], entity);
+			entities.push_back(std::move(entity));
+		}
+	}
+
+	std::string EntityParser::GetNameToken(const std::vector<std::string_view>& tokens)
 	{
 		//A name should always follow the entity/component/spawn macro
 		if (tokens.size() >= 2)
 		{
-			return tokens[1];
+			return std::string(tokens[1]);
 		}
 
 		return "";
@@ -194,8 +390,48 @@ namespace luminary
 		return -1;
 	}
 
-	void EntityParser::FindTextBlocks(const std::string& filename)
+	void EntityParser::MergeTextBlocks(FileTextBlocks& textBlocks)
+	{
+		std::move(textBlocks.entityTextBlocks.begin(), textBlocks.entityTextBlocks.end(), std::back_inserter(m_entityTextBlocks));
+		std::move(textBlocks.staticEntityTextBlocks.begin(), textBlocks.staticEntityTextBlocks.end(), std::back_inserter(m_staticEntityTextBlocks));
+		std::move(textBlocks.entitySpawnTextBlocks.begin(), textBlocks.entitySpawnTextBlocks.end(), std::back_inserter(m_entitySpawnTextBlocks));
+		std::move(textBlocks.componentTextBlocks.begin(), textBlocks.componentTextBlocks.end(), std::back_inserter(m_componentTextBlocks));
+		std::move(textBlocks.componentSpawnTextBlocks.begin(), textBlocks.componentSpawnTextBlocks.end(), std::back_inserter(m_componentSpawnTextBlocks));
+	}
+
+	u64 HashContents(const std::string& contents)
 	{
+		//FNV-1a
+		u64 hash = 0xcbf29ce484222325ull;
+
+		for (int i = 0; i < contents.size(); i++)
+		{
+			hash ^= (u8)contents[i];
+			hash *= 0x100000001b3ull;
+		}
+
+		return hash;
+	}
+
+	//Returns true if the file was read and tokenised, false if taken from the cache
+	bool EntityParser::ScanFile(const std::string& filename, ScannedFile& scannedFile) const
+	{
+		scannedFile.size = 0;
+		scannedFile.modifiedTime = 0;
+		scannedFile.contentHash = 0;
+
+		//If size and modified time match the cache, use cached blocks without reading
+		std::map<std::string, ScannedFile>::const_iterator cached = m_cache.find(filename);
+
+		if (GetFileSizeAndTime(filename, scannedFile.size, scannedFile.modifiedTime) && cached != m_cache.end())
+		{
+			if (cached->second.size == scannedFile.size && cached->second.modifiedTime == scannedFile.modifiedTime)
+			{
+				scannedFile = cached->second;
+				return false;
+			}
+		}
+
 		ion::io::File file(filename, ion::io::File::OpenMode::Read);
 		if (file.IsOpen())
 		{
@@ -203,157 +439,457 @@ namespace luminary
 			std::string contents;
 			contents.resize(file.GetSize());
 			file.Read(&contents[0], file.GetSize());
+			file.Close();
 
-			//Extract lines
-			std::vector<std::string> lines;
-			ion::string::Tokenise(contents, lines, s_lineEndings);
+			scannedFile.contentHash = HashContents(contents);
 
-			bool inEntitySpawnBlock = false;
-			bool inComponentSpawnBlock = false;
-			bool inEntityBlock = false;
-			bool inStaticEntityBlock = false;
-			bool inComponentBlock = false;
-			bool inMacroBlock = false;
+			//If only touched, contents still match the cache
+			if (cached != m_cache.end() && cached->second.size == contents.size() && cached->second.contentHash == scannedFile.contentHash)
+			{
+				scannedFile.textBlocks = cached->second.textBlocks;
+				return false;
+			}
 
-			TextBlock currentBlock;
+			FindTextBlocks(contents, scannedFile.textBlocks);
+			return true;
+		}
 
-			for (int i = 0; i < lines.size(); i++)
+		return false;
+	}
+
+	//Block and macro keywords, recognised by FindTextBlocks() in a single pass
+	enum class BlockKeyword
+	{
+		MacroStart,
+		MacroEnd,
+		EntityBegin,
+		EntityEnd,
+		StaticEntityBegin,
+		StaticEntityEnd,
+		EntitySpawnBegin,
+		EntitySpawnEnd,
+		ComponentBegin,
+		ComponentEnd,
+		ComponentSpawnBegin,
+		ComponentSpawnEnd,
+
+		Count
+	};
+
+	static const std::string* s_blockKeywords[(int)BlockKeyword::Count] =
+	{
+		&s_macroStart,
+		&s_macroEnd,
+		&s_entityBegin,
+		&s_entityEnd,
+		&s_staticEntityBegin,
+		&s_staticEntityEnd,
+		&s_entitySpawnBegin,
+		&s_entitySpawnEnd,
+		&s_componentBegin,
+		&s_componentEnd,
+		&s_componentSpawnBegin,
+		&s_componentSpawnEnd,
+	};
+
+	//All block keywords differ in length, so length alone is a perfect hash
+	static const int s_maxBlockKeywordLength = 32;
+
+	struct BlockKeywordTable
+	{
+		BlockKeywordTable()
+		{
+			std::fill(keywordByLength, keywordByLength + s_maxBlockKeywordLength, -1);
+
+			for (int i = 0; i < (int)BlockKeyword::Count; i++)
+			{
+				ion::debug::Assert(s_blockKeywords[i]->size() < s_maxBlockKeywordLength && keywordByLength[s_blockKeywords[i]->size()] == -1, "EntityParser - Block keyword lengths must be unique");
+				keywordByLength[s_blockKeywords[i]->size()] = i;
+			}
+		}
+
+		int keywordByLength[s_maxBlockKeywordLength];
+	};
+
+	static const BlockKeywordTable s_blockKeywordTable;
+
+	//Returns bit for the keyword matching token (case insensitive), or 0
+	u32 FindBlockKeyword(const std::string_view& token)
+	{
+		if (token.size() < s_maxBlockKeywordLength)
+		{
+			int keyword = s_blockKeywordTable.keywordByLength[token.size()];
+
+			if (keyword >= 0)
 			{
-				//Tokenise
-				std::vector<std::string> words;
-				ion::string::Tokenise(lines[i], words, s_tokenDelim);
+				const std::string& keywordText = *s_blockKeywords[keyword];
 
-				if (words.size() > 0)
+				for (int i = 0; i < token.size(); i++)
 				{
-					//Ignore comment lines
-					if (words[0][0] != ';')
+					if (std::tolower((u8)token[i]) != std::tolower((u8)keywordText[i]))
 					{
-						if (inMacroBlock)
-						{
-							//Ignore macro definition until it finishes
-							if (ContainsToken(words, s_macroEnd) >= 0)
-							{
-								inMacroBlock = false;
-							}
-						}
-						else
-						{
-							if (ContainsToken(words, s_macroStart) >= 0)
-							{
-								//Found  macro block, ignoring everything in here
-								inMacroBlock = true;
-							}
-							else
-							{
-								if (inEntitySpawnBlock)
-								{
-									//In entity spawn data block, collect lines until we find the end
-									if (ContainsToken(words, s_entitySpawnEnd) >= 0)
-									{
-										inEntitySpawnBlock = false;
-										m_entitySpawnTextBlocks.push_back(currentBlock);
-										currentBlock = TextBlock();
-									}
-									else
-									{
-										currentBlock.block.push_back(words);
-									}
-								}
-								else if (inComponentSpawnBlock)
-								{
-									//In component spawn block, collect lines until we find the end
-									if (ContainsToken(words, s_componentSpawnEnd) >= 0)
-									{
-										inComponentSpawnBlock = false;
-										m_componentSpawnTextBlocks.push_back(currentBlock);
-										currentBlock = TextBlock();
-									}
-									else
-									{
-										currentBlock.block.push_back(words);
-									}
-								}
-								else if (inEntityBlock)
-								{
-									//In entity block, collect lines until we find the end
-									if (ContainsToken(words, s_entityEnd) >= 0)
-									{
-										inEntityBlock = false;
-										m_entityTextBlocks.push_back(currentBlock);
-										currentBlock = TextBlock();
-									}
-									else
-									{
-										currentBlock.block.push_back(words);
-									}
-								}
-								else if (inStaticEntityBlock)
-								{
-									//In static entity block, collect lines until we find the end
-									if (ContainsToken(words, s_staticEntityEnd) >= 0)
-									{
-										inStaticEntityBlock = false;
-										m_staticEntityTextBlocks.push_back(currentBlock);
-										currentBlock = TextBlock();
-									}
-									else
-									{
-										currentBlock.block.push_back(words);
-									}
-								}
-								else if (inComponentBlock)
-								{
-									//In component block, collect lines until we find the end
-									if (ContainsToken(words, s_componentEnd) >= 0)
-									{
-										inComponentBlock = false;
-										m_componentTextBlocks.push_back(currentBlock);
-										currentBlock = TextBlock();
-									}
-									else
-									{
-										currentBlock.block.push_back(words);
-									}
-								}
-								else
-								{
-									//Find an entity, component, or spawn data blocks
-									int pos = -1;
-
-									if ((pos = ContainsToken(words, s_entitySpawnBegin)) >= 0)
-									{
-										currentBlock.name = GetNameToken(words);
-										inEntitySpawnBlock = true;
-									}
-									else if ((pos = ContainsToken(words, s_componentSpawnBegin)) >= 0)
-									{
-										currentBlock.name = GetNameToken(words);
-										inComponentSpawnBlock = true;
-									}
-									else if ((pos = ContainsToken(words, s_entityBegin)) >= 0)
-									{
-										currentBlock.name = GetNameToken(words);
-										inEntityBlock = true;
-									}
-									else if ((pos = ContainsToken(words, s_staticEntityBegin)) >= 0)
-									{
-										currentBlock.name = GetNameToken(words);
-										inStaticEntityBlock = true;
-									}
-									else if ((pos = ContainsToken(words, s_componentBegin)) >= 0)
-									{
-										currentBlock.name = GetNameToken(words);
-										inComponentBlock = true;
-									}
-								}
-							}
-						}
+						return 0;
 					}
 				}
+
+				return 1 << keyword;
 			}
+		}
+
+		return 0;
+	}
 
+	inline bool HasBlockKeyword(u32 keywordMask, BlockKeyword keyword)
+	{
+		return (keywordMask & (1 << (int)keyword)) != 0;
+	}
+
+	inline bool IsLineEnding(char c)
+	{
+		return c == '\r' || c == '\n';
+	}
+
+	inline bool IsTokenDelim(char c)
+	{
+		return c == ' ' || c == ',' || c == '\t';
+	}
+
+	void EntityParser::FindTextBlocks(const std::string& contents, FileTextBlocks& textBlocks)
+	{
+		bool inEntitySpawnBlock = false;
+		bool inComponentSpawnBlock = false;
+		bool inEntityBlock = false;
+		bool inStaticEntityBlock = false;
+		bool inComponentBlock = false;
+		bool inMacroBlock = false;
+
+		TextBlock currentBlock;
+
+		//Scan contents in place, only copying out words for lines within blocks
+		std::string_view text(contents);
+		std::vector<std::string_view> words;
+
+		size_t pos = 0;
+
+		while (pos < text.size())
+		{
+			//Find next line
+			size_t lineEnd = pos;
+			while (lineEnd < text.size() && !IsLineEnding(text[lineEnd]))
+			{
+				lineEnd++;
+			}
+
+			//Tokenise, and flag any block keywords found along the way
+			words.clear();
+			u32 keywords = 0;
+
+			for (size_t wordStart = pos; wordStart < lineEnd;)
+			{
+				if (IsTokenDelim(text[wordStart]))
+				{
+					wordStart++;
+				}
+				else
+				{
+					size_t wordEnd = wordStart;
+					while (wordEnd < lineEnd && !IsTokenDelim(text[wordEnd]))
+					{
+						wordEnd++;
+					}
+
+					std::string_view word = text.substr(wordStart, wordEnd - wordStart);
+					keywords |= FindBlockKeyword(word);
+					words.push_back(word);
+					wordStart = wordEnd;
+				}
+			}
+
+			pos = lineEnd + 1;
+
+			//Ignore empty and comment lines
+			if (words.size() == 0 || words[0][0] == ';')
+			{
+				continue;
+			}
+
+			if (inMacroBlock)
+			{
+				//Ignore macro definition until it finishes
+				if (HasBlockKeyword(keywords, BlockKeyword::MacroEnd))
+				{
+					inMacroBlock = false;
+				}
+			}
+			else if (HasBlockKeyword(keywords, BlockKeyword::MacroStart))
+			{
+				//Found  macro block, ignoring everything in here
+				inMacroBlock = true;
+			}
+			else if (inEntitySpawnBlock || inComponentSpawnBlock || inEntityBlock || inStaticEntityBlock || inComponentBlock)
+			{
+				//In a block, collect lines until we find its end
+				std::vector<TextBlock>* blocks = nullptr;
+
+				if (inEntitySpawnBlock && HasBlockKeyword(keywords, BlockKeyword::EntitySpawnEnd))
+				{
+					inEntitySpawnBlock = false;
+					blocks = &textBlocks.entitySpawnTextBlocks;
+				}
+				else if (inComponentSpawnBlock && HasBlockKeyword(keywords, BlockKeyword::ComponentSpawnEnd))
+				{
+					inComponentSpawnBlock = false;
+					blocks = &textBlocks.componentSpawnTextBlocks;
+				}
+				else if (inEntityBlock && HasBlockKeyword(keywords, BlockKeyword::EntityEnd))
+				{
+					inEntityBlock = false;
+					blocks = &textBlocks.entityTextBlocks;
+				}
+				else if (inStaticEntityBlock && HasBlockKeyword(keywords, BlockKeyword::StaticEntityEnd))
+				{
+					inStaticEntityBlock = false;
+					blocks = &textBlocks.staticEntityTextBlocks;
+				}
+				else if (inComponentBlock && HasBlockKeyword(keywords, BlockKeyword::ComponentEnd))
+				{
+					inComponentBlock = false;
+					blocks = &textBlocks.componentTextBlocks;
+				}
+
+				if (blocks)
+				{
+					blocks->push_back(std::move(currentBlock));
+					currentBlock = TextBlock();
+				}
+				else
+				{
+					currentBlock.block.emplace_back(words.begin(), words.end());
+				}
+			}
+			else if (keywords)
+			{
+				//Find an entity, component, or spawn data blocks
+				if (HasBlockKeyword(keywords, BlockKeyword::EntitySpawnBegin))
+				{
+					currentBlock.name = GetNameToken(words);
+					inEntitySpawnBlock = true;
+				}
+				else if (HasBlockKeyword(keywords, BlockKeyword::ComponentSpawnBegin))
+				{
+					currentBlock.name = GetNameToken(words);
+					inComponentSpawnBlock = true;
+				}
+				else if (HasBlockKeyword(keywords, BlockKeyword::EntityBegin))
+				{
+					currentBlock.name = GetNameToken(words);
+					inEntityBlock = true;
+				}
+				else if (HasBlockKeyword(keywords, BlockKeyword::StaticEntityBegin))
+				{
+					currentBlock.name = GetNameToken(words);
+					inStaticEntityBlock = true;
+				}
+				else if (HasBlockKeyword(keywords, BlockKeyword::ComponentBegin))
+				{
+					currentBlock.name = GetNameToken(words);
+					inComponentBlock = true;
+				}
+			}
+		}
+	}
+
+	void WriteCacheU32(std::string& buffer, u32 value)
+	{
+		buffer.append((const char*)&value, sizeof(u32));
+	}
+
+	void WriteCacheU64(std::string& buffer, u64 value)
+	{
+		buffer.append((const char*)&value, sizeof(u64));
+	}
+
+	void WriteCacheString(std::string& buffer, const std::string& string)
+	{
+		WriteCacheU32(buffer, (u32)string.size());
+		buffer.append(string);
+	}
+
+	void WriteCacheBlocks(std::string& buffer, const std::vector<EntityParser::TextBlock>& textBlocks)
+	{
+		WriteCacheU32(buffer, (u32)textBlocks.size());
+
+		for (int i = 0; i < textBlocks.size(); i++)
+		{
+			WriteCacheString(buffer, textBlocks[i].name);
+			WriteCacheU32(buffer, (u32)textBlocks[i].block.size());
+
+			for (int j = 0; j < textBlocks[i].block.size(); j++)
+			{
+				WriteCacheU32(buffer, (u32)textBlocks[i].block[j].size());
+
+				for (int k = 0; k < textBlocks[i].block[j].size(); k++)
+				{
+					WriteCacheString(buffer, textBlocks[i].block[j][k]);
+				}
+			}
+		}
+	}
+
+	struct CacheReader
+	{
+		CacheReader(const std::string& buffer) : buffer(buffer), pos(0), valid(true) {}
+
+		template <typename T> T Read()
+		{
+			T value = 0;
+
+			if (valid && pos + sizeof(T) <= buffer.size())
+			{
+				std::copy(buffer.begin() + pos, buffer.begin() + pos + sizeof(T), (char*)&value);
+				pos += sizeof(T);
+			}
+			else
+			{
+				valid = false;
+			}
+
+			return value;
+		}
+
+		std::string ReadString()
+		{
+			u32 size = Read<u32>();
+
+			if (valid && pos + size <= buffer.size())
+			{
+				pos += size;
+				return buffer.substr(pos - size, size);
+			}
+
+			valid = false;
+			return "";
+		}
+
+		void ReadBlocks(std::vector<EntityParser::TextBlock>& textBlocks)
+		{
+			u32 numBlocks = Read<u32>();
+
+			for (u32 i = 0; i < numBlocks && valid; i++)
+			{
+				EntityParser::TextBlock textBlock;
+				textBlock.name = ReadString();
+
+				u32 numLines = Read<u32>();
+
+				for (u32 j = 0; j < numLines && valid; j++)
+				{
+					std::vector<std::string> words;
+					u32 numWords = Read<u32>();
+
+					for (u32 k = 0; k < numWords && valid; k++)
+					{
+						words.push_back(ReadString());
+					}
+
+					textBlock.block.push_back(words);
+				}
+
+				textBlocks.push_back(textBlock);
+			}
+		}
+
+		const std::string& buffer;
+		size_t pos;
+		bool valid;
+	};
+
+	bool EntityParser::LoadCache()
+	{
+		m_cache.clear();
+
+		ion::io::File file(m_cacheFilename, ion::io::File::OpenMode::Read);
+		if (file.IsOpen())
+		{
+			std::string buffer;
+			buffer.resize(file.GetSize());
+
+			if (buffer.size() > 0)
+			{
+				file.Read(&buffer[0], buffer.size());
+			}
+
+			file.Close();
+
+			CacheReader reader(buffer);
+
+			if (reader.Read<u32>() == s_cacheMagic)
+			{
+				u32 numFiles = reader.Read<u32>();
+
+				for (u32 i = 0; i < numFiles && reader.valid; i++)
+				{
+					std::string filename = reader.ReadString();
+
+					ScannedFile scannedFile;
+					scannedFile.size = reader.Read<u64>();
+					scannedFile.modifiedTime = reader.Read<u64>();
+					scannedFile.contentHash = reader.Read<u64>();
+					reader.ReadBlocks(scannedFile.textBlocks.entityTextBlocks);
+					reader.ReadBlocks(scannedFile.textBlocks.staticEntityTextBlocks);
+					reader.ReadBlocks(scannedFile.textBlocks.entitySpawnTextBlocks);
+					reader.ReadBlocks(scannedFile.textBlocks.componentTextBlocks);
+					reader.ReadBlocks(scannedFile.textBlocks.componentSpawnTextBlocks);
+
+					if (reader.valid)
+					{
+						m_cache[filename] = scannedFile;
+					}
+				}
+			}
+
+			//Corrupt or out of date cache, rescan everything
+			if (!reader.valid)
+			{
+				m_cache.clear();
+			}
+
+			return reader.valid;
+		}
+
+		return false;
+	}
+
+	bool EntityParser::SaveCache(const std::vector<std::string>& filenames)
+	{
+		std::string buffer;
+		WriteCacheU32(buffer, s_cacheMagic);
+		WriteCacheU32(buffer, (u32)filenames.size());
+
+		for (int i = 0; i < filenames.size(); i++)
+		{
+			const ScannedFile& scannedFile = m_cache[filenames[i]];
+
+			WriteCacheString(buffer, filenames[i]);
+			WriteCacheU64(buffer, scannedFile.size);
+			WriteCacheU64(buffer, scannedFile.modifiedTime);
+			WriteCacheU64(buffer, scannedFile.contentHash);
+			WriteCacheBlocks(buffer, scannedFile.textBlocks.entityTextBlocks);
+			WriteCacheBlocks(buffer, scannedFile.textBlocks.staticEntityTextBlocks);
+			WriteCacheBlocks(buffer, scannedFile.textBlocks.entitySpawnTextBlocks);
+			WriteCacheBlocks(buffer, scannedFile.textBlocks.componentTextBlocks);
+			WriteCacheBlocks(buffer, scannedFile.textBlocks.componentSpawnTextBlocks);
+		}
+
+		ion::io::File file(m_cacheFilename, ion::io::File::OpenMode::Write);
+		if (file.IsOpen())
+		{
+			file.Write(buffer.data(), buffer.size());
 			file.Close();
+			return true;
 		}
+
+		return false;
 	}
 
 	void EntityParser::ParseSpawnData(const TextBlock& textBlock, SpawnData& spawnData)
@@ -382,16 +918,18 @@ namespace luminary
 
 			if ((tokenPos = ContainsToken(textBlock.block[i], s_componentNamedDef)) >= 0)
 			{
-				if (Component* component = ParseComponentDef(textBlock.block[i], tokenPos))
+				Component component;
+				if (ParseComponentDef(textBlock.block[i], tokenPos, component))
 				{
-					entity.components.push_back(*component);
+					entity.components.push_back(std::move(component));
 				}
 			}
 			else if ((tokenPos = ContainsToken(textBlock.block[i], s_componentDef)) >= 0)
 			{
-				if (Component* component = ParseComponentDef(textBlock.block[i], tokenPos))
+				Component component;
+				if (ParseComponentDef(textBlock.block[i], tokenPos, component))
 				{
-					entity.components.push_back(*component);
+					entity.components.push_back(std::move(component));
 				}
 			}
 			else if ((tokenPos = ContainsToken(textBlock.block[i], s_scriptFuncDef)) >= 0)
@@ -521,26 +1059,25 @@ namespace luminary
 		}
 	}
 
-	Component* EntityParser::ParseComponentDef(const std::vector<std::string>& line, int pos)
+	bool EntityParser::ParseComponentDef(const std::vector<std::string>& line, int pos, Component& component)
 	{
-		Component* component = nullptr;
-
 		//Expecting at least 2 tokens - macro and component name
 		if (line.size() >= 2)
 		{
 			//Find component
-			std::string componentName = line[1];
+			int componentIdx = FindNameIndex(m_componentIndex, line[1]);
 
-			for (int i = 0; i < m_components.size() && !component; i++)
+			if (componentIdx >= 0)
 			{
-				if (ion::string::CompareNoCase(m_components[i].name, componentName))
-				{
-					component = &m_components[i];
-				}
+				//Spawn data is per entity, params and script funcs stay with the definition
+				component.name = m_components[componentIdx].name;
+				component.spawnData = m_components[componentIdx].spawnData;
+				component.definition = m_componentDefinitions[componentIdx];
+				return true;
 			}
 		}
 
-		return component;
+		return false;
 	}
 
 	ScriptFunc EntityParser::ParseScriptFuncDef(const std::vector<std::string>& line, int pos)
@@ -548,19 +1085,16 @@ namespace luminary
 		ScriptFunc scriptFunc;
 
 		//Expecting at least 4 tokens - macro, routine, return value, name, and optional params
-		if (line.size() >= 3)
+		if (line.size() >= pos + 4)
 		{
-			scriptFunc.routine = line[1];
-			scriptFunc.returnType = line[2];
-			scriptFunc.name = line[3];
+			scriptFunc.routine = line[pos + 1];
+			scriptFunc.returnType = line[pos + 2];
+			scriptFunc.name = line[pos + 3];
 
-			if (line.size() >= 5)
+			//Read all func params, type then name (with an optional :reg for register calls)
+			for (int i = pos + 4; i + 1 < line.size(); i += 2)
 			{
-				//Read all func params
-				for (int i = 4; i < line.size(); i += 2)
-				{
-					scriptFunc.params.push_back(std::make_pair(line[i], line[i + 1]));
-				}
+				scriptFunc.params.push_back(std::make_pair(line[i], line[i + 1]));
 			}
 		}
 
@@ -569,31 +1103,13 @@ namespace luminary
 
 	SpawnData* EntityParser::FindComponentSpawnData(const std::string& componentName)
 	{
-		SpawnData* spawnData = nullptr;
-
-		for (int i = 0; i < m_componentSpawnData.size() && !spawnData; i++)
-		{
-			if (ion::string::CompareNoCase(m_componentSpawnData[i].name, componentName))
-			{
-				spawnData = &m_componentSpawnData[i];
-			}
-		}
-
-		return spawnData;
+		int spawnDataIdx = FindNameIndex(m_componentSpawnDataIndex, componentName);
+		return (spawnDataIdx >= 0) ? &m_componentSpawnData[spawnDataIdx] : nullptr;
 	}
 
 	SpawnData* EntityParser::FindEntitySpawnData(const std::string& entityName)
 	{
-		SpawnData* spawnData = nullptr;
-
-		for (int i = 0; i < m_entitySpawnData.size() && !spawnData; i++)
-		{
-			if (ion::string::CompareNoCase(m_entitySpawnData[i].name, entityName))
-			{
-				spawnData = &m_entitySpawnData[i];
-			}
-		}
-
-		return spawnData;
+		int spawnDataIdx = FindNameIndex(m_entitySpawnDataIndex, entityName);
+		return (spawnDataIdx >= 0) ? &m_entitySpawnData[spawnDataIdx] : nullptr;
 	}
 }
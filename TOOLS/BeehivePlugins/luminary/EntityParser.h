@@ -10,7 +10,10 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
+#include <map>
+#include <unordered_map>
 
 #include "Types.h"
 
@@ -19,17 +22,71 @@ namespace luminary
 	class EntityParser
 	{
 	public:
+		struct TextBlock
+		{
+			std::string name;
+			std::vector<std::vector<std::string>> block;
+		};
+
+		//All text blocks found in a single file
+		struct FileTextBlocks
+		{
+			std::vector<TextBlock> entityTextBlocks;
+			std::vector<TextBlock> staticEntityTextBlocks;
+			std::vector<TextBlock> entitySpawnTextBlocks;
+			std::vector<TextBlock> componentTextBlocks;
+			std::vector<TextBlock> componentSpawnTextBlocks;
+		};
+
 		EntityParser();
 
+		//Max worker threads for reading and scanning ASM files (0 = one per hardware thread, 1 = serial, the default)
+		void SetMaxThreads(int maxThreads);
+
+		//Keep scanned text blocks between parses, so unchanged files aren't re-tokenised
+		void SetCacheEnabled(bool enabled);
+
+		//Cache file for scanned text blocks, persisting them between sessions (empty = no cache file)
+		void SetCacheFilename(const std::string& filename);
+
 		bool ParseDirectories(const std::vector<std::string>& directories, std::vector<Entity>& entities);
+		bool ParseFiles(const std::vector<std::string>& filenames, std::vector<Entity>& entities);
+
+		//Components from last parse
+		const std::vector<Component>& GetComponents() const { return m_components; }
+
+		//True if any file was added, removed, or modified since last cached parse
+		bool HasChanges(const std::vector<std::string>& filenames) const;
+
+		//Files read and re-tokenised by the last parse, the rest came from the cache
+		int GetNumFilesScanned() const { return m_numFilesScanned; }
+
+		static void FindASMFiles(const std::vector<std::string>& directories, std::vector<std::string>& filenames);
+
+		//True if filename has an ASM extension (.asm, .s), case insensitive
+		static bool IsASMFile(const std::string& filename);
+
+		//Single pass scan of one file's contents for entity, component and spawn data blocks
+		static void FindTextBlocks(const std::string& contents, FileTextBlocks& textBlocks);
 
 	private:
-		struct TextBlock
+		//Scanned file, keyed in cache by path + size + modified time + content hash
+		struct ScannedFile
 		{
-			std::string name;
-			std::vector<std::vector<std::string>> block;
+			u64 size;
+			u64 modifiedTime;
+			u64 contentHash;
+			FileTextBlocks textBlocks;
 		};
 
+		int m_maxThreads;
+
+		bool m_cacheEnabled;
+		bool m_cacheLoaded;
+		std::string m_cacheFilename;
+		std::map<std::string, ScannedFile> m_cache;
+		int m_numFilesScanned;
+
 		std::vector<TextBlock> m_entityTextBlocks;
 		std::vector<TextBlock> m_staticEntityTextBlocks;
 		std::vector<TextBlock> m_entitySpawnTextBlocks;
@@ -40,16 +97,27 @@ namespace luminary
 		std::vector<SpawnData> m_componentSpawnData;
 
 		std::vector<Component> m_components;
+		std::vector<std::shared_ptr<const Component>> m_componentDefinitions;
+
+		//Lowercase name to index lookups, rebuilt after each parse stage
+		std::unordered_map<std::string, int> m_entitySpawnDataIndex;
+		std::unordered_map<std::string, int> m_componentSpawnDataIndex;
+		std::unordered_map<std::string, int> m_componentIndex;
 
-		void FindTextBlocks(const std::string& filename);
-		std::string GetNameToken(const std::vector<std::string>& tokens);
+		void ScanFiles(const std::vector<std::string>& filenames);
+		bool ScanFile(const std::string& filename, ScannedFile& scannedFile) const;
+		void ParseTextBlocks(std::vector<Entity>& entities);
+		bool LoadCache();
+		bool SaveCache(const std::vector<std::string>& filenames);
+		void MergeTextBlocks(FileTextBlocks& textBlocks);
+		static std::string GetNameToken(const std::vector<std::string_view>& tokens);
 		bool ParseEntity(const TextBlock& textBlock, Entity& entity);
 		void ParseStaticEntity(const TextBlock& textBlock, Entity& entity);
 		bool ParseComponent(const TextBlock& textBlock, Component& component);
 		void ParseSpawnData(const TextBlock& textBlock, SpawnData& spawnData);
 		bool ParseParam(const std::vector<std::string>& line, Param& param);
 		void ParseTags(const std::string& tagLine, Param& param);
-		Component* ParseComponentDef(const std::vector<std::string>& line, int pos);
+		bool ParseComponentDef(const std::vector<std::string>& line, int pos, Component& component);
 		ScriptFunc ParseScriptFuncDef(const std::vector<std::string>& line, int pos);
 		SpawnData* FindComponentSpawnData(const std::string& componentName);
 		SpawnData* FindEntitySpawnData(const std::string& entityName);
@@ -0,0 +1,202 @@
+// ============================================================================================
+// LUMINARY - a game engine and framework for the SEGA Mega Drive
+// ============================================================================================
+// Matt Phillips - Big Evil Corporation Ltd - 17th October 2026
+// ============================================================================================
+// EntitySchema.cpp - Long-lived entity and component schema, kept up to date by watching the
+// engine and game directories for ASM file changes.
+// ============================================================================================
+
+#include "EntitySchema.h"
+
+#include <ion/core/io/FileDevice.h>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+namespace luminary
+{
+	EntitySchema::EntitySchema()
+	{
+		m_watchHndl = -1;
+		m_changesPending = false;
+
+		//Keep text blocks in memory, only changed files need rescanning
+		m_parser.SetCacheEnabled(true);
+	}
+
+	EntitySchema::~EntitySchema()
+	{
+		Close();
+	}
+
+	bool EntitySchema::Open(const std::vector<std::string>& directories)
+	{
+		Close();
+
+		if (!ion::io::FileDevice::GetDefault())
+		{
+			return false;
+		}
+
+		m_directories = directories;
+
+#if defined(__linux__)
+		m_watchHndl = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+		for (auto directory : m_directories)
+		{
+			WatchDirectory(directory);
+		}
+#endif
+
+		return Rebuild();
+	}
+
+	void EntitySchema::Close()
+	{
+#if defined(__linux__)
+		if (m_watchHndl >= 0)
+		{
+			close(m_watchHndl);
+		}
+#endif
+
+		m_watchHndl = -1;
+		m_watchedDirectories.clear();
+		m_directories.clear();
+		m_asmFiles.clear();
+		m_entities.clear();
+		m_components.clear();
+		m_changesPending = false;
+	}
+
+	bool EntitySchema::Update()
+	{
+		if (m_directories.size() > 0 && PollChanges())
+		{
+			return Rebuild();
+		}
+
+		return false;
+	}
+
+	bool EntitySchema::Rebuild()
+	{
+		//Find files again, in case any were added or removed
+		m_asmFiles.clear();
+		EntityParser::FindASMFiles(m_directories, m_asmFiles);
+
+		//Unchanged files come from the parser's cache
+		std::vector<Entity> entities;
+		if (m_parser.ParseFiles(m_asmFiles, entities))
+		{
+			m_entities = std::move(entities);
+			m_components = m_parser.GetComponents();
+			return true;
+		}
+
+		return false;
+	}
+
+	bool EntitySchema::PollChanges()
+	{
+#if defined(__linux__)
+		if (m_watchHndl >= 0)
+		{
+			//Drain all pending events
+			char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+			ssize_t length = 0;
+
+			while ((length = read(m_watchHndl, buffer, sizeof(buffer))) > 0)
+			{
+				for (char* ptr = buffer; ptr < buffer + length; ptr += sizeof(struct inotify_event) + ((struct inotify_event*)ptr)->len)
+				{
+					const struct inotify_event* event = (const struct inotify_event*)ptr;
+					bool asmChanged = false;
+
+					if (event->mask & IN_ISDIR)
+					{
+						std::map<int, std::string>::const_iterator it = m_watchedDirectories.find(event->wd);
+
+						if ((event->mask & (IN_CREATE | IN_MOVED_TO)) && event->len > 0 && it != m_watchedDirectories.end())
+						{
+							//Start watching new subdirectories, any ASM files already in them were missed
+							std::string directory = it->second + ion::io::FileDevice::GetDefault()->GetPathSeparator() + event->name;
+							WatchDirectory(directory);
+
+							std::vector<std::string> asmFiles;
+							EntityParser::FindASMFiles({ directory }, asmFiles);
+							asmChanged = asmFiles.size() > 0;
+						}
+						else if (event->mask & IN_MOVED_FROM)
+						{
+							//Files moved out with a directory get no events of their own
+							asmChanged = true;
+						}
+					}
+					else if (event->len > 0)
+					{
+						//Ignore editor swap/backup files and anything else that isn't ASM
+						asmChanged = EntityParser::IsASMFile(event->name);
+					}
+
+					if (event->mask & IN_IGNORED)
+					{
+						m_watchedDirectories.erase(event->wd);
+					}
+
+					if (asmChanged)
+					{
+						m_changesPending = true;
+						m_lastChangeTime = std::chrono::steady_clock::now();
+					}
+				}
+			}
+
+			//Coalesce, wait for the burst to settle
+			if (m_changesPending && std::chrono::steady_clock::now() - m_lastChangeTime >= std::chrono::milliseconds(s_settleTimeMs))
+			{
+				m_changesPending = false;
+				return true;
+			}
+
+			return false;
+		}
+#endif
+
+		//No change notifications on this platform, compare file sizes and times instead
+		std::vector<std::string> asmFiles;
+		EntityParser::FindASMFiles(m_directories, asmFiles);
+		return m_parser.HasChanges(asmFiles);
+	}
+
+	void EntitySchema::WatchDirectory(const std::string& directory)
+	{
+#if defined(__linux__)
+		if (m_watchHndl >= 0)
+		{
+			int watchDesc = inotify_add_watch(m_watchHndl, directory.c_str(), IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF);
+			if (watchDesc >= 0)
+			{
+				m_watchedDirectories[watchDesc] = directory;
+			}
+
+			//inotify isn't recursive, watch all subdirectories too
+			std::vector<ion::io::FileDevice::DirectoryItem> contents;
+			ion::io::FileDevice::GetDefault()->ReadDirectory(directory, contents);
+
+			for (int i = 0; i < contents.size(); i++)
+			{
+				if (contents[i].m_fileType == ion::io::FileDevice::FileType::Directory && contents[i].m_filename != "." && contents[i].m_filename != "..")
+				{
+					WatchDirectory(directory + ion::io::FileDevice::GetDefault()->GetPathSeparator() + contents[i].m_filename);
+				}
+			}
+		}
+#endif
+	}
+}
@@ -0,0 +1,62 @@
+// ============================================================================================
+// LUMINARY - a game engine and framework for the SEGA Mega Drive
+// ============================================================================================
+// Matt Phillips - Big Evil Corporation Ltd - 17th October 2026
+// ============================================================================================
+// EntitySchema.h - Long-lived entity and component schema, kept up to date by watching the
+// engine and game directories for ASM file changes.
+// ============================================================================================
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <map>
+
+#include "Types.h"
+#include "EntityParser.h"
+
+namespace luminary
+{
+	class EntitySchema
+	{
+	public:
+		EntitySchema();
+		~EntitySchema();
+
+		//Parses all directories and begins watching them for changes
+		bool Open(const std::vector<std::string>& directories);
+		void Close();
+
+		//Non-blocking, rescans only changed files if any ASM file was modified since last update. Bursts of
+		//changes (e.g. an editor's save) are coalesced, the rebuild waits until s_settleTimeMs pass without any.
+		//Returns true if the schema was rebuilt.
+		bool Update();
+
+		static const int s_settleTimeMs = 100;
+
+		const std::vector<Entity>& GetEntities() const { return m_entities; }
+		const std::vector<Component>& GetComponents() const { return m_components; }
+
+	private:
+		bool Rebuild();
+		bool PollChanges();
+		void WatchDirectory(const std::string& directory);
+
+		EntityParser m_parser;
+		std::vector<std::string> m_directories;
+		std::vector<std::string> m_asmFiles;
+
+		std::vector<Entity> m_entities;
+		std::vector<Component> m_components;
+
+		//inotify instance and watched directories, by watch descriptor
+		int m_watchHndl;
+		std::map<int, std::string> m_watchedDirectories;
+
+		//ASM changes seen but not yet rebuilt, and when the last arrived
+		bool m_changesPending;
+		std::chrono::steady_clock::time_point m_lastChangeTime;
+	};
+}
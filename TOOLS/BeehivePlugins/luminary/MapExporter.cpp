@@ -7,40 +7,67 @@
 // ============================================================================================
 
 #include "MapExporter.h"
+#include "BinaryWriter.h"
 
-#include <ion/core/memory/Endian.h>
+#include <algorithm>
 
 namespace luminary
 {
-	bool MapExporter::ExportMap(const std::string& binFilename, const Map& map, int stampWidth, int stampHeight, StampId backgroundStamp)
+	u32 MapExporter::GetStampWord(StampId stampId, u16 stampFlags, u32 stampSizeBytes, const std::vector<TilesetExporter::StampRemap>& stampRemap)
 	{
-		ion::io::File file(binFilename, ion::io::File::OpenMode::Write);
-		if (file.IsOpen())
+		//32 bit longword:
+		//-------------------------------------------
+		//A00D C000 EEEE EEEE EEEE EEEE EEEE EEEE
+		//-------------------------------------------
+		//A = High plane
+		//C = Horizontal flip
+		//D = Vertical flip
+		//E = Stamp data offset
+		//The upper word's flags sit where they do in a tile word, MAP_UpdateStreamingPlane applies them to each tile.
+		//The top byte holds nothing but flags, so the streamer tests it alone to skip unflagged stamps cheaply.
+
+		//Point to the unique stamp, a flipped duplicate flips back by XORing its flips with the map's
+		if (stampId < stampRemap.size())
+		{
+			stampFlags ^= stampRemap[stampId].flipFlags;
+			stampId = stampRemap[stampId].stampId;
+		}
+
+		u32 addr = stampId * stampSizeBytes;
+		ion::debug::Assert(addr < (1 << 24), "MapExporter::ExportMap() - Stamp data too large for map offset");
+
+		u32 flipH = (stampFlags & Map::eFlipX) ? 1 << 27 : 0;
+		u32 flipV = (stampFlags & Map::eFlipY) ? 1 << 28 : 0;
+		u32 plane = (stampFlags & Map::eHighPlane) ? 1u << 31 : 0;
+
+		return addr | flipH | flipV | plane;
+	}
+
+	bool MapExporter::ExportMap(const std::string& binFilename, const Map& map, int stampWidth, int stampHeight, StampId backgroundStamp, const std::vector<TilesetExporter::StampRemap>& stampRemap)
+	{
+		int widthStamps = map.GetWidth() / stampWidth;
+		int heightStamps = map.GetHeight() / stampHeight;
+		u32 stampSizeBytes = stampWidth * stampHeight * 2;
+
+		std::vector<u32> stampMap;
+		stampMap.resize(widthStamps * heightStamps);
+		u32 backgroundWord = GetStampWord(backgroundStamp, 0, stampSizeBytes, stampRemap);
+		std::fill(stampMap.begin(), stampMap.end(), backgroundWord);
+
+		for (TStampPosMap::const_iterator it = map.StampsBegin(), end = map.StampsEnd(); it != end; ++it)
+		{
+			int x = it->m_position.x / stampWidth;
+			int y = it->m_position.y / stampHeight;
+			stampMap[(y * widthStamps) + x] = GetStampWord(it->m_id, it->m_flags, stampSizeBytes, stampRemap);
+		}
+
+		BinaryWriter writer(stampMap.size() * sizeof(u32));
+
+		for (int i = 0; i < stampMap.size(); i++)
 		{
-			int widthStamps = map.GetWidth() / stampWidth;
-			int heightStamps = map.GetHeight() / stampHeight;
-			u32 stampSizeBytes = stampWidth * stampHeight * 2;
-
-			std::vector<u32> stampMap;
-			stampMap.resize(widthStamps * heightStamps);
-			u32 backgroundWord = backgroundStamp * stampSizeBytes;
-			std::fill(stampMap.begin(), stampMap.end(), backgroundWord);
-
-			for (TStampPosMap::const_iterator it = map.StampsBegin(), end = map.StampsEnd(); it != end; ++it)
-			{
-				int x = it->m_position.x / stampWidth;
-				int y = it->m_position.y / stampHeight;
-				u32 addr = (it->m_id * stampSizeBytes);
-				u32 word = addr | (it->m_flags << 13);	// High Prio, Flip X, Flip Y
-				ion::memory::EndianSwap(word);
-				stampMap[(y * widthStamps) + x] = word;
-			}
-
-			file.Write(stampMap.data(), stampMap.size() * sizeof(u32));
-			file.Close();
-			return true;
+			writer.WriteU32(stampMap[i]);
 		}
 
-		return false;
+		return writer.Flush(binFilename);
 	}
 }
\ No newline at end of file
@@ -10,11 +10,17 @@
 
 #include <ion/beehive/Map.h>
 
+#include "TilesetExporter.h"
+
 namespace luminary
 {
 	class MapExporter
 	{
 	public:
-		bool ExportMap(const std::string& binFilename, const Map& map, int stampWidth, int stampHeight, StampId backgroundStamp);
+		//Stamp remap from TilesetExporter::DeduplicateStamps(), or empty if stamps were exported as-is
+		bool ExportMap(const std::string& binFilename, const Map& map, int stampWidth, int stampHeight, StampId backgroundStamp, const std::vector<TilesetExporter::StampRemap>& stampRemap = std::vector<TilesetExporter::StampRemap>());
+
+		//Stamp map longword for a placed stamp (Map::Flags), as read by MAP_UpdateStreamingPlane
+		static u32 GetStampWord(StampId stampId, u16 stampFlags, u32 stampSizeBytes, const std::vector<TilesetExporter::StampRemap>& stampRemap);
 	};
 }
\ No newline at end of file
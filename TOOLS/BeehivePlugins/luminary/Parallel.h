@@ -0,0 +1,78 @@
+// ============================================================================================
+// LUMINARY - a game engine and framework for the SEGA Mega Drive
+// ============================================================================================
+// Matt Phillips - Big Evil Corporation Ltd - 17th October 2026
+// ============================================================================================
+// Parallel.h - Minimal worker pool helpers for tools exporting
+// ============================================================================================
+
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace luminary
+{
+	namespace parallel
+	{
+		//Default thread limit for parallel tool stages (0 = one per hardware thread). EntityParser stays serial unless opted in.
+		static const int s_defaultMaxThreads = 0;
+
+		//Number of worker threads to use for a job count (maxThreads 0 = one per hardware thread)
+		inline int GetNumThreads(int maxThreads, int numJobs)
+		{
+			int numThreads = maxThreads;
+
+			if (numThreads <= 0)
+			{
+				numThreads = (int)std::thread::hardware_concurrency();
+			}
+
+			if (numThreads > numJobs)
+			{
+				numThreads = numJobs;
+			}
+
+			return (numThreads > 0) ? numThreads : 1;
+		}
+
+		//Runs func(index) for every index in [0, count) across a pool of worker threads.
+		//Jobs are handed out in index order, but may complete in any order - callers
+		//write results into per-index slots to keep output deterministic.
+		template <typename T> void For(int count, int maxThreads, const T& func)
+		{
+			int numThreads = GetNumThreads(maxThreads, count);
+
+			if (numThreads <= 1)
+			{
+				for (int i = 0; i < count; i++)
+				{
+					func(i);
+				}
+
+				return;
+			}
+
+			std::atomic<int> nextIdx(0);
+			std::vector<std::thread> threads;
+			threads.reserve(numThreads);
+
+			for (int i = 0; i < numThreads; i++)
+			{
+				threads.emplace_back([&]()
+				{
+					for (int idx = nextIdx++; idx < count; idx = nextIdx++)
+					{
+						func(idx);
+					}
+				});
+			}
+
+			for (int i = 0; i < threads.size(); i++)
+			{
+				threads[i].join();
+			}
+		}
+	}
+}
@@ -140,7 +140,7 @@ namespace luminary
 			stream << "\tdc.l " << sceneData.palettesLabel << "\t; SceneData_Palettes" << std::endl;
 			stream << "\tdc.l " << "SceneEntityDataStatic_" << sceneName << "\t; SceneData_StaticEntities" << std::endl;
 			stream << "\tdc.l " << "SceneEntityDataDynamic_" << sceneName << "\t; SceneData_DynamicEntities" << std::endl;
-			stream << "\tdc.w " << sceneData.numTiles << "\t; SceneData_GfxTileCount" << std::endl;
+			stream << "\tdc.w " << sceneData.numTiles << (sceneData.tilesCompressed ? "|TILES_FLAG_COMPRESSED" : "") << "\t; SceneData_GfxTileCount" << std::endl;
 			stream << "\tdc.w " << sceneData.numStamps << "\t; SceneData_GfxStampCount" << std::endl;
 			stream << "\tdc.w " << sceneData.mapFgWidthStamps << "\t; SceneData_GfxMapFgWidthStamps" << std::endl;
 			stream << "\tdc.w " << sceneData.mapFgHeightStamps << "\t; SceneData_GfxMapFgHeightStamps" << std::endl;
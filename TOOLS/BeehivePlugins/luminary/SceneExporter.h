@@ -34,6 +34,7 @@ namespace luminary
 			std::vector<Entity> dynamicEntities;
 
 			int numTiles;
+			bool tilesCompressed = false;	//LZ tileset, flagged in the tile count for MAP_PreLoad
 			int numStamps;
 			int mapFgWidthStamps;
 			int mapFgHeightStamps;
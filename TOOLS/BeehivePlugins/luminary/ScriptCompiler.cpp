@@ -7,14 +7,29 @@
 // ============================================================================================
 
 #include "ScriptCompiler.h"
+#include "Parallel.h"
 
 #include <ion/core/string/String.h>
 #include <ion/core/memory/Endian.h>
 #include <ion/core/io/File.h>
 #include <ion/core/io/FileDevice.h>
+#include <ion/core/utils/STL.h>
 
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <map>
 #include <sstream>
 #include <set>
+#include <stdio.h>
+
+#if defined _WIN32
+#define popen _popen
+#define pclose _pclose
+#else
+#include <sys/wait.h>
+#endif
 
 namespace luminary
 {
@@ -44,6 +59,7 @@ namespace luminary
 
 	const std::string g_commonInclude = "Common.h";
 	const std::string g_componentsInclude = "Components.h";
+	const std::string g_globalOffsetTableFile = "globaloffsets.table";
 
 	const std::vector<ScriptEntryPoint> g_scriptFuncs =
 	{
@@ -52,6 +68,181 @@ namespace luminary
 		{ "void", "OnUpdate", "const Engine& engine, const Scene& scene" },
 	};
 
+	ScriptTranspiler::ScriptTranspiler()
+	{
+		m_packedLayouts = false;
+	}
+
+	void ScriptTranspiler::SetPackedLayouts(bool packed)
+	{
+		m_packedLayouts = packed;
+	}
+
+	//SCRIPT_FUNC params can name the register the routine expects them in (type,name:d1), and a return type
+	//can be suffixed with :reg (void:reg) to opt a func with no params in. Those funcs are called with this in a0,
+	//args in their registers and the return value in d0, following the gcc ABI otherwise (d0-d1/a0-a1 are scratch).
+	const std::string g_registerCallTag = "reg";
+	const std::vector<std::string> g_scratchRegisters = { "d0", "d1", "a0", "a1" };
+
+	static void SplitRegister(const std::string& token, std::string& name, std::string& reg)
+	{
+		size_t colonPos = token.find(':');
+
+		if (colonPos != std::string::npos)
+		{
+			name = token.substr(0, colonPos);
+			reg = ion::string::ToLower(token.substr(colonPos + 1));
+		}
+		else
+		{
+			name = token;
+			reg.clear();
+		}
+	}
+
+	static bool IsArgRegister(const std::string& reg)
+	{
+		//a0 holds this, a5/a6 are the GOT and frame pointers, a7 is sp
+		return reg.size() == 2 && ((reg[0] == 'd' && reg[1] >= '0' && reg[1] <= '7') || (reg[0] == 'a' && reg[1] >= '1' && reg[1] <= '4'));
+	}
+
+	struct RegisterCall
+	{
+		std::string returnType;
+		std::vector<std::string> types;
+		std::vector<std::string> names;
+		std::vector<std::string> registers;
+		std::string error;
+	};
+
+	static bool GetRegisterCall(const ScriptFunc& scriptFunc, RegisterCall& call)
+	{
+		std::string returnReg;
+		SplitRegister(scriptFunc.returnType, call.returnType, returnReg);
+
+		bool annotated = returnReg.size() > 0;
+		std::set<std::string> usedRegisters;
+
+		for (int i = 0; i < scriptFunc.params.size(); i++)
+		{
+			std::string name;
+			std::string reg;
+			SplitRegister(scriptFunc.params[i].second, name, reg);
+
+			call.types.push_back(scriptFunc.params[i].first);
+			call.names.push_back(name);
+			call.registers.push_back(reg);
+
+			annotated |= reg.size() > 0;
+		}
+
+		//Annotated funcs that can't be called by register report an error in the header rather than falling back to the stack
+		if (!annotated)
+		{
+			return false;
+		}
+
+		if (returnReg.size() > 0 && returnReg != g_registerCallTag && returnReg != "d0")
+		{
+			call.error = scriptFunc.scope + "::" + scriptFunc.name + " returns in " + returnReg + ", only d0 is supported";
+			return true;
+		}
+
+		//Can't mix stack and register params
+		for (int i = 0; i < call.registers.size(); i++)
+		{
+			if (!IsArgRegister(call.registers[i]) || !usedRegisters.insert(call.registers[i]).second)
+			{
+				call.error = scriptFunc.scope + "::" + scriptFunc.name + " param " + call.names[i] + " needs a unique register in d0-d7/a1-a4";
+				return true;
+			}
+		}
+
+		return true;
+	}
+
+	static void WriteRegisterCallWrapper(std::stringstream& stream, const std::string& structName, const ScriptFunc& scriptFunc, const RegisterCall& call)
+	{
+		if (call.error.size() > 0)
+		{
+			stream << "#error \"" << call.error << "\"" << std::endl;
+			return;
+		}
+
+		bool hasReturn = call.returnType != "void";
+		bool returnRegIsArg = false;
+
+		stream << "\tinline __attribute__((always_inline)) " << call.returnType << " " << scriptFunc.name << "(";
+
+		for (int i = 0; i < call.names.size(); i++)
+		{
+			stream << call.types[i] << " " << call.names[i];
+
+			if (i != call.names.size() - 1)
+			{
+				stream << ", ";
+			}
+		}
+
+		stream << ")" << std::endl;
+		stream << "\t{" << std::endl;
+
+		//Pin this and all args to their registers, they're all read/write since the routine is free to trash them
+		std::vector<std::string> outputs;
+		std::set<std::string> operandRegisters;
+
+		stream << "\t\tregister " << structName << "* reg_a0 asm(\"a0\") = this;" << std::endl;
+		outputs.push_back("\"+r\"(reg_a0)");
+		operandRegisters.insert("a0");
+
+		for (int i = 0; i < call.names.size(); i++)
+		{
+			std::string regType = (hasReturn && call.registers[i] == "d0") ? call.returnType : call.types[i];
+			stream << "\t\tregister " << regType << " reg_" << call.registers[i] << " asm(\"" << call.registers[i] << "\") = (" << regType << ")" << call.names[i] << ";" << std::endl;
+			outputs.push_back("\"+r\"(reg_" + call.registers[i] + ")");
+			operandRegisters.insert(call.registers[i]);
+
+			returnRegIsArg |= call.registers[i] == "d0";
+		}
+
+		if (hasReturn && !returnRegIsArg)
+		{
+			stream << "\t\tregister " << call.returnType << " reg_d0 asm(\"d0\");" << std::endl;
+			outputs.insert(outputs.begin(), "\"=r\"(reg_d0)");
+			operandRegisters.insert("d0");
+		}
+
+		//Routine address comes from the GOT, via the extern "C" routine symbol
+		stream << "\t\tasm volatile(\"jsr (%[routine])\"" << std::endl;
+		stream << "\t\t\t: ";
+
+		for (int i = 0; i < outputs.size(); i++)
+		{
+			stream << outputs[i] << ((i != outputs.size() - 1) ? ", " : "");
+		}
+
+		stream << std::endl;
+		stream << "\t\t\t: [routine] \"a\"(&" << scriptFunc.routine << ")" << std::endl;
+		stream << "\t\t\t: ";
+
+		for (int i = 0; i < g_scratchRegisters.size(); i++)
+		{
+			if (operandRegisters.find(g_scratchRegisters[i]) == operandRegisters.end())
+			{
+				stream << "\"" << g_scratchRegisters[i] << "\", ";
+			}
+		}
+
+		stream << "\"cc\", \"memory\");" << std::endl;
+
+		if (hasReturn)
+		{
+			stream << "\t\treturn reg_d0;" << std::endl;
+		}
+
+		stream << "\t}" << std::endl;
+	}
+
 	bool ScriptTranspiler::GenerateComponentCppHeader(const std::vector<Component>& components, const std::string& outputDir)
 	{
 		std::string filename = outputDir + "\\" + g_componentsInclude;
@@ -62,41 +253,47 @@ namespace luminary
 			std::stringstream stream;
 			std::set<std::string> exportedComponentHeaders;
 
+			stream << "#pragma once" << std::endl << std::endl;
+
 			for (int i = 0; i < components.size(); i++)
 			{
 				if (exportedComponentHeaders.find(components[i].name) == exportedComponentHeaders.end())
 				{
+					//Register call routines are resolved through the GOT by routine name
+					std::vector<RegisterCall> registerCalls;
+					std::vector<bool> isRegisterCall;
+
+					for (int j = 0; j < components[i].scriptFuncs.size(); j++)
+					{
+						RegisterCall call;
+						isRegisterCall.push_back(GetRegisterCall(components[i].scriptFuncs[j], call));
+						registerCalls.push_back(call);
+
+						if (isRegisterCall.back() && call.error.empty())
+						{
+							stream << "extern \"C\" void " << components[i].scriptFuncs[j].routine << "();" << std::endl;
+						}
+					}
+
+					if (std::find(isRegisterCall.begin(), isRegisterCall.end(), true) != isRegisterCall.end())
+					{
+						stream << std::endl;
+					}
+
 					stream << "struct " << components[i].name << " : ComponentBase" << std::endl;
 					stream << "{" << std::endl;
 
-					int structSize = 0;
+					StructLayout layout;
 
 					for (int j = 0; j < components[i].params.size(); j++)
 					{
 						std::string paramName = ion::string::RemoveSubstring(components[i].params[j].name, components[i].name + "_");
 						paramName[0] = ion::string::ToLower(paramName)[0];
-
-						switch (components[i].params[j].size)
-						{
-							case ParamSize::Byte:
-								stream << "\tchar " << paramName << ";" << std::endl;
-								structSize += 1;
-								break;
-							case ParamSize::Word:
-								stream << "\tshort " << paramName << ";" << std::endl;
-								structSize += 2;
-								break;
-							case ParamSize::Long:
-								stream << "\tint " << paramName << ";" << std::endl;
-								structSize += 4;
-								break;
-						}
+						layout.AddField(paramName, components[i].params[j].name, components[i].params[j].size);
 					}
 
-					if (structSize & 1)
-					{
-						stream << "\tunsigned char padding;" << std::endl;
-					}
+					layout.Build(m_packedLayouts);
+					layout.WriteCppFields(stream, "\t");
 
 					if (components[i].scriptFuncs.size() > 0)
 					{
@@ -104,6 +301,12 @@ namespace luminary
 
 						for (int j = 0; j < components[i].scriptFuncs.size(); j++)
 						{
+							if (isRegisterCall[j])
+							{
+								WriteRegisterCallWrapper(stream, components[i].name, components[i].scriptFuncs[j], registerCalls[j]);
+								continue;
+							}
+
 							stream << "\t" << components[i].scriptFuncs[j].returnType << " " << components[i].scriptFuncs[j].name << "(";
 
 							for (int k = 0; k < components[i].scriptFuncs[j].params.size(); k++)
@@ -122,6 +325,14 @@ namespace luminary
 
 					stream << "};" << std::endl << std::endl;
 
+					if (m_packedLayouts)
+					{
+						layout.WriteAsmOrderComment(stream, components[i].name);
+					}
+
+					layout.WriteCppOffsetAsserts(stream, components[i].name, "ComponentBase", true);
+					stream << std::endl;
+
 					exportedComponentHeaders.insert(components[i].name);
 				}
 			}
@@ -144,6 +355,7 @@ namespace luminary
 			std::stringstream stream;
 
 			stream << g_header << std::endl << std::endl;
+			stream << "#pragma once" << std::endl << std::endl;
 			stream << "#include <" << g_commonInclude + ">" << std::endl;
 			stream << "#include <" << g_componentsInclude + ">" << std::endl << std::endl;
 
@@ -175,34 +387,17 @@ namespace luminary
 
 			stream << "\t};" << std::endl << std::endl;
 			
-			int structSize = 0;
+			StructLayout layout;
 
 			for (int i = 0; i < entity.params.size(); i++)
 			{
 				std::string paramName = ion::string::RemoveSubstring(entity.params[i].name, entity.typeName + "_");
 				paramName[0] = ion::string::ToLower(paramName)[0];
-
-				switch (entity.params[i].size)
-				{
-				case ParamSize::Byte:
-					stream << "\tchar " << paramName << ";" << std::endl;
-					structSize += 1;
-					break;
-				case ParamSize::Word:
-					stream << "\tshort " << paramName << ";" << std::endl;
-					structSize += 2;
-					break;
-				case ParamSize::Long:
-					stream << "\tint " << paramName << ";" << std::endl;
-					structSize += 4;
-					break;
-				}
+				layout.AddField(paramName, entity.params[i].name, entity.params[i].size);
 			}
 
-			if (structSize & 1)
-			{
-				stream << "\tunsigned char padding;" << std::endl;
-			}
+			layout.Build(m_packedLayouts);
+			layout.WriteCppFields(stream, "\t");
 
 			stream << std::endl;
 
@@ -213,7 +408,15 @@ namespace luminary
 				stream << "\t" << func.returnType << " " << func.methodName << "(" << func.params << ");" << std::endl;
 			}
 
-			stream << "};" << std::endl;
+			stream << "};" << std::endl << std::endl;
+
+			if (m_packedLayouts)
+			{
+				layout.WriteAsmOrderComment(stream, entity.typeName);
+			}
+
+			//Components follow the params in ASM too, but their handles are laid out by ENT_COMPONENT so only params are checked
+			layout.WriteCppOffsetAsserts(stream, entity.typeName, "Entity", false);
 
 			file.Write(stream.str().c_str(), stream.str().size());
 			file.Close();
@@ -249,33 +452,94 @@ namespace luminary
 
 	bool ScriptTranspiler::GenerateGlobalOffsetTable(const std::vector<Entity>& entities, const std::vector<Component>& components, std::vector<ScriptFunc>& table, const std::string& asmFilename)
 	{
-		int scriptFuncIdx = 0;
+		return GenerateGlobalOffsetTable(entities, components, std::vector<ScriptFunc>(), table, asmFilename);
+	}
+
+	static std::string GetGlobalOffsetKey(const ScriptFunc& scriptFunc)
+	{
+		return scriptFunc.scope + "::" + scriptFunc.name + "=" + scriptFunc.routine;
+	}
+
+	bool ScriptTranspiler::GenerateGlobalOffsetTable(const std::vector<Entity>& entities, const std::vector<Component>& components, const std::vector<ScriptFunc>& previousTable, std::vector<ScriptFunc>& table, const std::string& asmFilename)
+	{
+		//Collect unique script funcs, in entity then component order
+		std::vector<const ScriptFunc*> scriptFuncs;
+		std::unordered_map<std::string, int> scriptFuncIndex;
+
+		for (int i = 0; i < entities.size(); i++)
+		{
+			for (int j = 0; j < entities[i].scriptFuncs.size(); j++)
+			{
+				if (scriptFuncIndex.emplace(GetGlobalOffsetKey(entities[i].scriptFuncs[j]), (int)scriptFuncs.size()).second)
+				{
+					scriptFuncs.push_back(&entities[i].scriptFuncs[j]);
+				}
+			}
+		}
+
+		for (int i = 0; i < components.size(); i++)
+		{
+			for (int j = 0; j < components[i].scriptFuncs.size(); j++)
+			{
+				if (scriptFuncIndex.emplace(GetGlobalOffsetKey(components[i].scriptFuncs[j]), (int)scriptFuncs.size()).second)
+				{
+					scriptFuncs.push_back(&components[i].scriptFuncs[j]);
+				}
+			}
+		}
 
-		for (auto entity : entities)
+		//Keep previous indices, everything else starts as a free slot
+		std::vector<int> slots(previousTable.size(), -1);
+		std::vector<bool> placed(scriptFuncs.size(), false);
+
+		for (int i = 0; i < previousTable.size(); i++)
 		{
-			for (auto scriptFunc : entity.scriptFuncs)
+			if (previousTable[i].routine.size() > 0)
 			{
-				table.push_back(scriptFunc);
-				table.back().tableOffset = scriptFuncIdx++;
+				std::unordered_map<std::string, int>::const_iterator it = scriptFuncIndex.find(GetGlobalOffsetKey(previousTable[i]));
+				if (it != scriptFuncIndex.end() && !placed[it->second])
+				{
+					slots[i] = it->second;
+					placed[it->second] = true;
+				}
 			}
 		}
 
-		for (auto entity : entities)
+		//New funcs fill free slots, then append
+		int freeSlot = 0;
+
+		for (int i = 0; i < scriptFuncs.size(); i++)
 		{
-			for (auto scriptFunc : entity.scriptFuncs)
+			if (!placed[i])
 			{
-				table.push_back(scriptFunc);
-				table.back().tableOffset = scriptFuncIdx++;
+				while (freeSlot < slots.size() && slots[freeSlot] != -1)
+				{
+					freeSlot++;
+				}
+
+				if (freeSlot < slots.size())
+					slots[freeSlot] = i;
+				else
+					slots.push_back(i);
 			}
 		}
 
-		for (auto component : components)
+		while (slots.size() > 0 && slots.back() == -1)
 		{
-			for (auto scriptFunc : component.scriptFuncs)
+			slots.pop_back();
+		}
+
+		table.clear();
+		table.resize(slots.size());
+
+		for (int i = 0; i < slots.size(); i++)
+		{
+			if (slots[i] != -1)
 			{
-				table.push_back(scriptFunc);
-				table.back().tableOffset = scriptFuncIdx++;
+				table[i] = *scriptFuncs[slots[i]];
 			}
+
+			table[i].tableOffset = i;
 		}
 
 		ion::io::File file(asmFilename, ion::io::File::OpenMode::Write);
@@ -283,8 +547,14 @@ namespace luminary
 		{
 			std::stringstream stream;
 
-			for (auto scriptFunc : table)
+			for (auto& scriptFunc : table)
 			{
+				if (scriptFunc.routine.empty())
+				{
+					stream << "\t dc.l 0\t\t; Unused" << std::endl;
+					continue;
+				}
+
 				stream << "\t dc.l " << scriptFunc.routine << "\t\t; " << scriptFunc.returnType << " " << scriptFunc.scope << "::" << scriptFunc.name << "(";
 
 				for (int i = 0; i < scriptFunc.params.size(); i++)
@@ -306,142 +576,1201 @@ namespace luminary
 		return false;
 	}
 
-	std::string ScriptCompiler::GetBinPath(const std::string& compilerDir)
+	GlobalOffsetTableIndex::GlobalOffsetTableIndex(const std::vector<ScriptFunc>& table)
 	{
-		return ion::io::FileDevice::GetDefault()->GetMountPoint() + "\\" + ion::io::FileDevice::GetDefault()->GetDirectory() + "\\" + compilerDir + "\\" + "bin";
+		m_index.reserve(table.size());
+
+		for (int i = 0; i < table.size(); i++)
+		{
+			if (table[i].routine.size() > 0)
+			{
+				m_index.emplace(table[i].scope + "::" + table[i].name, i);
+				m_routineIndex.emplace(table[i].routine, i);
+			}
+		}
 	}
 
-	std::string ScriptCompiler::GetLibExecPath(const std::string& compilerDir, const std::string& compilerVer)
+	int GlobalOffsetTableIndex::Find(const std::string& scope, const std::string& name) const
 	{
-		return ion::io::FileDevice::GetDefault()->GetMountPoint() + "\\"
-			+ ion::io::FileDevice::GetDefault()->GetDirectory() + "\\"
-			+ compilerDir + "\\libexec\\gcc\\m68k-elf\\" + compilerVer;
+		std::unordered_map<std::string, int>::const_iterator it = m_index.find(scope + "::" + name);
+		return (it != m_index.end()) ? it->second : -1;
 	}
 
-	std::string ScriptCompiler::GenerateCompileCommand(const std::string& filename, const std::string& outname, const std::string& compilerDir, const std::vector<std::string>& includeDirs, const std::vector<std::string>& defines)
+	int GlobalOffsetTableIndex::FindRoutine(const std::string& routine) const
 	{
-		std::string cmdLine = GetBinPath(compilerDir) + "\\" + g_compilerExe + " " + g_compilerArg + " -B" + compilerDir;
+		std::unordered_map<std::string, int>::const_iterator it = m_routineIndex.find(routine);
+		return (it != m_routineIndex.end()) ? it->second : -1;
+	}
 
-		for (auto include : includeDirs)
-		{
-			cmdLine += " -I" + include;
-		}
+	ScriptCompiler::ScriptCompiler()
+	{
+		m_maxThreads = parallel::s_defaultMaxThreads;
+		m_lastBuildTime = 0.0;
+	}
 
-		for (auto define : defines)
-		{
-			cmdLine += " -D" + define;
-		}
-			
-		cmdLine += " " + filename + " -o " + outname + ".o";
+	typedef std::chrono::steady_clock BuildClock;
 
-		return cmdLine;
+	static double GetElapsedMs(BuildClock::time_point& startTime)
+	{
+		//Restarts the timer for the next stage
+		BuildClock::time_point endTime = BuildClock::now();
+		double elapsed = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+		startTime = endTime;
+		return elapsed;
 	}
 
-	std::string ScriptCompiler::GenerateObjCopyCommand(const std::string& filename, const std::string& outname, const std::string& compilerDir)
+	void ScriptCompiler::SetMaxThreads(int maxThreads)
 	{
-		return GetBinPath(compilerDir) + "\\" + g_objcopyExe + " " + g_objcopyArg + " " + outname + ".o " + outname + ".bin";
+		m_maxThreads = maxThreads;
 	}
 
-	std::string ScriptCompiler::GenerateSymbolReadCommand(const std::string& filename, const std::string& outname, const std::string& compilerDir)
+	void ScriptCompiler::SetCacheDirectory(const std::string& directory)
 	{
-		return GetBinPath(compilerDir) + "\\" + g_symbolReadExe + " " + g_symbolReadArg + " " + outname + ".o ";
+		m_cacheDirectory = directory;
 	}
 
-	int ScriptCompiler::ReadRelocationTable(const std::vector<std::string>& symbolOutput, const std::vector<ScriptFunc> globalOffsetsTable, std::vector<ScriptRelocation>& relocationTable)
+	static u64 HashString(u64 hash, const std::string& string)
 	{
-		for (auto line : symbolOutput)
+		//FNV-1a
+		for (int i = 0; i < string.size(); i++)
 		{
-			//TODO: A bit primitive, will have many edge cases
-			if (line.find("R_68K_GOT") != std::string::npos)
-			{
-				std::vector<std::string> tokens;
-				ion::string::TokeniseByWhitespace(line, tokens);
-
-				//Need at least 3 tokens - address, type, name
-				if (tokens.size() >= 3)
-				{
-					ScriptRelocation entry;
-					entry.address = std::stoul(tokens[0], nullptr, 16);
-
-					std::vector<std::string> nameTokens;
-					ion::string::Tokenise(tokens[2], nameTokens, "::");
-
-					std::vector<char> stripChars = { ':', '(', ')' };
-
-					if (nameTokens.size() == 2)
-					{
-						//Scoped C++ function
-						entry.scope = ion::string::Strip(nameTokens[0], stripChars);
+			hash ^= (u8)string[i];
+			hash *= 0x100000001b3ull;
+		}
 
-						//todo : substr up to first (
-						int bracketPos = nameTokens[1].find('(');
-						if (bracketPos != std::string::npos)
-						{
-							entry.name = ion::string::Strip(nameTokens[1].substr(0, bracketPos), stripChars);
-						}
-						else
-						{
-							entry.name = ion::string::Strip(nameTokens[1], stripChars);
-						}
+		return hash;
+	}
 
-						//Match with GOT entry
-						entry.tableIdx = -1;
-						
-						for (int i = 0; i < globalOffsetsTable.size(); i++)
-						{
-							if (entry.scope == globalOffsetsTable[i].scope && entry.name == globalOffsetsTable[i].name)
-							{
-								entry.tableIdx = i;
-								break;
-							}
-						}
-					}
-					else if (nameTokens.size() == 1)
-					{
-						//Global, or the GOT
-						entry.name = ion::string::Strip(nameTokens[0], stripChars);
-					}
+	static u64 HashFile(u64 hash, const std::string& filename)
+	{
+		//Name and contents, so a header found in another include dir also misses
+		hash = HashString(hash, filename);
 
-					relocationTable.push_back(entry);
-				}
-			}
+		ion::io::File file(filename, ion::io::File::OpenMode::Read);
+		if (!file.IsOpen())
+		{
+			return HashString(hash, "<missing>");
 		}
 
-		//First entry should be the GOT, or there's a problem
-		if (relocationTable.size() == 0 || relocationTable[0].name != "_GLOBAL_OFFSET_TABLE_")
+		std::string contents;
+		contents.resize(file.GetSize());
+
+		if (contents.size() > 0)
 		{
-			relocationTable.clear();
+			file.Read(&contents[0], contents.size());
 		}
 
-		return relocationTable.size();
+		file.Close();
+		return HashString(hash, contents);
 	}
 
-	int ScriptCompiler::FindFunctionOffset(const std::vector<std::string>& symbolOutput, const std::string& className, const std::string& name)
+	static std::string FindIncludeFile(const std::string& name, const std::vector<std::string>& directories)
 	{
-		for (auto line : symbolOutput)
+		//First match in search order, as the compiler would
+		for (int i = 0; i < directories.size(); i++)
 		{
-			//TODO: A bit primitive, will have many edge cases
-			if (line.find(className) != std::string::npos && line.find(name) != std::string::npos)
+			std::string filename = directories[i] + "/" + name;
+
+			std::error_code error;
+			if (std::filesystem::is_regular_file(filename, error))
 			{
-				std::vector<std::string> tokens;
-				ion::string::TokeniseByWhitespace(line, tokens);
-				std::string addressHexText = tokens[0];
-				return std::stoul(addressHexText, nullptr, 16);
+				return filename;
 			}
 		}
 
-		return -1;
+		return name;
 	}
 
-	int ScriptCompiler::FindGlobalVarOffset(const std::vector<std::string>& symbolOutput, const std::string& typeName)
+	static std::string FormatCacheKey(u64 hash)
 	{
-		for (auto line : symbolOutput)
-		{
-			//TODO: A bit primitive, will have many edge cases
-			std::string searchTermRef = "static const " + typeName + "&";
-			std::string searchTermPtr = "static const " + typeName + "*";
+		std::stringstream stream;
+		stream << SSTREAM_HEX8((u32)(hash >> 32)) << SSTREAM_HEX8((u32)hash);
+		return stream.str();
+	}
 
-			if (line.find(searchTermRef) != std::string::npos || line.find(searchTermPtr) != std::string::npos)
+	std::string ScriptCompiler::GetDirectCacheKey(const ScriptBuildJob& job, const std::string& compileCommand, const std::vector<std::string>& includeDirs)
+	{
+		//The script's own header is a quoted include, searched for next to the script first
+		std::vector<std::string> quotedDirs = includeDirs;
+		quotedDirs.insert(quotedDirs.begin(), std::filesystem::path(job.filename).parent_path().string());
+
+		std::error_code error;
+		if (!std::filesystem::is_regular_file(job.filename, error))
+		{
+			return std::string();
+		}
+
+		u64 hash = HashString(0xcbf29ce484222325ull, compileCommand);
+		hash = HashFile(hash, job.filename);
+		hash = HashFile(hash, FindIncludeFile(job.entityName + ".h", quotedDirs));
+		hash = HashFile(hash, FindIncludeFile(g_componentsInclude, includeDirs));
+		hash = HashFile(hash, FindIncludeFile(g_commonInclude, includeDirs));
+		return FormatCacheKey(hash);
+	}
+
+	std::string ScriptCompiler::GetCacheKey(const ScriptBuildJob& job, const std::string& compilerDir, const std::vector<std::string>& includeDirs, const std::vector<std::string>& defines)
+	{
+		//Compile command without input/output names, so a renamed script still hits
+		std::string compileCommand = GenerateCompileCommand("", "", compilerDir, includeDirs, defines);
+
+		//Direct mode, skips running the preprocessor if the known inputs are unchanged
+		std::string directKey = GetDirectCacheKey(job, compileCommand, includeDirs);
+		std::string cacheKey;
+
+		if (directKey.size() > 0 && FetchCacheManifest(directKey, cacheKey))
+		{
+			return cacheKey;
+		}
+
+		//Preprocessed source covers the user .cpp and every header it pulls in
+		std::vector<std::string> preprocessed;
+		if (RunCommand(GeneratePreprocessCommand(job.filename, compilerDir, includeDirs, defines), preprocessed) != 0)
+		{
+			return std::string();
+		}
+
+		u64 hash = HashString(0xcbf29ce484222325ull, compileCommand);
+
+		for (int i = 0; i < preprocessed.size(); i++)
+		{
+			hash = HashString(hash, preprocessed[i]);
+			hash = HashString(hash, "\n");
+		}
+
+		cacheKey = FormatCacheKey(hash);
+
+		if (directKey.size() > 0)
+		{
+			StoreCacheManifest(directKey, cacheKey);
+		}
+
+		return cacheKey;
+	}
+
+	bool ScriptCompiler::FetchCacheManifest(const std::string& directKey, std::string& cacheKey)
+	{
+		ion::io::File file(m_cacheDirectory + "/" + directKey + ".manifest", ion::io::File::OpenMode::Read);
+		if (!file.IsOpen())
+		{
+			return false;
+		}
+
+		std::string contents;
+		contents.resize(file.GetSize());
+
+		if (contents.size() > 0)
+		{
+			file.Read(&contents[0], contents.size());
+		}
+
+		file.Close();
+
+		//One object key, anything else is a damaged manifest and misses
+		if (contents.size() != 16 || contents.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos)
+		{
+			return false;
+		}
+
+		cacheKey = contents;
+		return true;
+	}
+
+	void ScriptCompiler::StoreCacheManifest(const std::string& directKey, const std::string& cacheKey)
+	{
+		std::string manifestName = m_cacheDirectory + "/" + directKey;
+
+		//Write then rename, so a fetch never sees a partial manifest
+		std::error_code error;
+		std::filesystem::create_directories(m_cacheDirectory, error);
+
+		ion::io::File file(manifestName + ".mtmp", ion::io::File::OpenMode::Write);
+		if (file.IsOpen())
+		{
+			file.Write(cacheKey.data(), cacheKey.size());
+			file.Close();
+			std::filesystem::rename(manifestName + ".mtmp", manifestName + ".manifest", error);
+		}
+	}
+
+	bool ScriptCompiler::FetchCachedObject(const std::string& cacheKey, ScriptBuildJob& job)
+	{
+		std::error_code error;
+		std::filesystem::copy_file(m_cacheDirectory + "/" + cacheKey + ".o", job.outname + ".o", std::filesystem::copy_options::overwrite_existing, error);
+		return !error;
+	}
+
+	void ScriptCompiler::StoreCachedObject(const std::string& cacheKey, const ScriptBuildJob& job)
+	{
+		std::string cacheName = m_cacheDirectory + "/" + cacheKey;
+
+		//Copy then rename, so a fetch never sees a partial object
+		std::error_code error;
+		std::filesystem::create_directories(m_cacheDirectory, error);
+		std::filesystem::copy_file(job.outname + ".o", cacheName + ".tmp", std::filesystem::copy_options::overwrite_existing, error);
+		if (!error)
+		{
+			std::filesystem::rename(cacheName + ".tmp", cacheName + ".o", error);
+		}
+	}
+
+	bool ScriptCompiler::LoadGlobalOffsetTable(std::vector<ScriptFunc>& table)
+	{
+		table.clear();
+
+		if (m_cacheDirectory.empty())
+		{
+			return false;
+		}
+
+		ion::io::File file(m_cacheDirectory + "/" + g_globalOffsetTableFile, ion::io::File::OpenMode::Read);
+		if (!file.IsOpen())
+		{
+			return false;
+		}
+
+		std::string contents;
+		contents.resize(file.GetSize());
+
+		if (contents.size() > 0)
+		{
+			file.Read(&contents[0], contents.size());
+		}
+
+		file.Close();
+
+		//One tab separated scope, name and routine line per entry, blank for a free slot
+		std::stringstream stream(contents);
+		std::string line;
+
+		while (std::getline(stream, line))
+		{
+			ScriptFunc scriptFunc;
+			scriptFunc.tableOffset = (u32)table.size();
+
+			std::stringstream fields(line);
+			std::getline(fields, scriptFunc.scope, '\t');
+			std::getline(fields, scriptFunc.name, '\t');
+			std::getline(fields, scriptFunc.routine, '\t');
+			table.push_back(scriptFunc);
+		}
+
+		return true;
+	}
+
+	void ScriptCompiler::SaveGlobalOffsetTable(const std::vector<ScriptFunc>& table)
+	{
+		std::string tableName = m_cacheDirectory + "/" + g_globalOffsetTableFile;
+		std::stringstream stream;
+
+		for (int i = 0; i < table.size(); i++)
+		{
+			if (table[i].routine.size() > 0)
+			{
+				stream << table[i].scope << "\t" << table[i].name << "\t" << table[i].routine;
+			}
+
+			stream << std::endl;
+		}
+
+		//Write then rename, so a load never sees a partial table
+		std::error_code error;
+		std::filesystem::create_directories(m_cacheDirectory, error);
+
+		ion::io::File file(tableName + ".tmp", ion::io::File::OpenMode::Write);
+		if (file.IsOpen())
+		{
+			file.Write(stream.str().c_str(), stream.str().size());
+			file.Close();
+			std::filesystem::rename(tableName + ".tmp", tableName, error);
+		}
+	}
+
+	static std::string GetLinkStamp(const std::string& cacheKey, const std::vector<ScriptRelocation>& relocationTable, u16 globalOffsetTableSize, u16 binaryStartOffset)
+	{
+		//Everything LinkProgram patches from, given the same object
+		std::stringstream stream;
+		stream << cacheKey << " " << globalOffsetTableSize << " " << binaryStartOffset;
+
+		for (int i = 0; i < relocationTable.size(); i++)
+		{
+			stream << " " << relocationTable[i].address << ":" << relocationTable[i].tableIdx;
+		}
+
+		return FormatCacheKey(HashString(0xcbf29ce484222325ull, stream.str()));
+	}
+
+	static bool ReadLinkedBinary(const std::string& outname, const std::string& linkStamp, std::vector<u8>& binary)
+	{
+		ion::io::File stampFile(outname + ".link", ion::io::File::OpenMode::Read);
+		if (!stampFile.IsOpen())
+		{
+			return false;
+		}
+
+		std::string stamp;
+		stamp.resize(stampFile.GetSize());
+
+		if (stamp.size() > 0)
+		{
+			stampFile.Read(&stamp[0], stamp.size());
+		}
+
+		stampFile.Close();
+
+		if (stamp != linkStamp)
+		{
+			return false;
+		}
+
+		//Linking only patches words, so the .bin is the same size as the object's .text
+		ion::io::File binFile(outname + ".bin", ion::io::File::OpenMode::Read);
+		if (!binFile.IsOpen() || binFile.GetSize() != binary.size())
+		{
+			return false;
+		}
+
+		if (binary.size() > 0)
+		{
+			binFile.Read(&binary[0], binary.size());
+		}
+
+		binFile.Close();
+		return true;
+	}
+
+	int ScriptCompiler::RunCommand(const std::string& cmdLine, std::vector<std::string>& output)
+	{
+		FILE* pipe = popen((cmdLine + " 2>&1").c_str(), "r");
+		if (!pipe)
+		{
+			return -1;
+		}
+
+		std::string line;
+		char buffer[1024];
+
+		while (fgets(buffer, sizeof(buffer), pipe))
+		{
+			line += buffer;
+
+			if (line.size() > 0 && line.back() == '\n')
+			{
+				line.pop_back();
+				if (line.size() > 0 && line.back() == '\r')
+					line.pop_back();
+
+				output.push_back(line);
+				line.clear();
+			}
+		}
+
+		if (line.size() > 0)
+		{
+			output.push_back(line);
+		}
+
+		int status = pclose(pipe);
+
+#if defined _WIN32
+		//_pclose returns the process exit code directly
+		return status;
+#else
+		//pclose returns a wait status, decode the exit code (-1 if the process didn't exit normally)
+		if (status == -1 || !WIFEXITED(status))
+		{
+			return -1;
+		}
+
+		return WEXITSTATUS(status);
+#endif
+	}
+
+	bool ScriptCompiler::BuildScripts(std::vector<ScriptBuildJob>& jobs, const std::string& compilerDir, const std::vector<std::string>& includeDirs, const std::vector<std::string>& defines, const std::vector<ScriptFunc>& globalOffsetsTable, u16 globalOffsetTableSize)
+	{
+		int numJobs = (int)jobs.size();
+		BuildClock::time_point buildStartTime = BuildClock::now();
+
+		for (int i = 0; i < numJobs; i++)
+		{
+			double transpileTime = jobs[i].timings.transpile;
+			jobs[i].timings = ScriptBuildTimings();
+			jobs[i].timings.transpile = transpileTime;
+
+			jobs[i].relocationTable.clear();
+			jobs[i].binary.clear();
+			jobs[i].cycleEstimates.clear();
+			jobs[i].objectSize = 0;
+			jobs[i].binarySize = 0;
+			jobs[i].cacheHit = false;
+			jobs[i].linkReused = false;
+			jobs[i].success = true;
+			jobs[i].error.clear();
+		}
+
+		std::vector<std::string> cacheKeys(numJobs);
+		GlobalOffsetTableIndex globalOffsetsIndex(globalOffsetsTable);
+
+		//Compile, or fetch from the object cache
+		parallel::For(numJobs, m_maxThreads, [&](int jobIdx)
+		{
+			ScriptBuildJob& job = jobs[jobIdx];
+			std::vector<std::string> output;
+			BuildClock::time_point stageTime = BuildClock::now();
+
+			if (m_cacheDirectory.size() > 0)
+			{
+				cacheKeys[jobIdx] = GetCacheKey(job, compilerDir, includeDirs, defines);
+				job.cacheHit = cacheKeys[jobIdx].size() > 0 && FetchCachedObject(cacheKeys[jobIdx], job);
+				job.timings.cacheLookup = GetElapsedMs(stageTime);
+
+				if (job.cacheHit)
+				{
+					return;
+				}
+			}
+
+			int result = RunCommand(GenerateCompileCommand(job.filename, job.outname, compilerDir, includeDirs, defines), output);
+			job.timings.compile = GetElapsedMs(stageTime);
+
+			if (result != 0)
+			{
+				job.success = false;
+				job.error = "Compile failed";
+
+				for (int i = 0; i < output.size(); i++)
+				{
+					job.error += "\n" + output[i];
+				}
+			}
+		});
+
+		//Extract .text, read relocations and link in memory, all from the object
+		parallel::For(numJobs, m_maxThreads, [&](int jobIdx)
+		{
+			ScriptBuildJob& job = jobs[jobIdx];
+			if (!job.success)
+				return;
+
+			BuildClock::time_point stageTime = BuildClock::now();
+
+			ElfReader elf;
+			if (!elf.Open(job.outname + ".o") || !elf.GetSectionData(".text", job.binary))
+			{
+				job.success = false;
+				job.error = "Could not read object " + job.outname + ".o";
+				return;
+			}
+
+			job.objectSize = (int)elf.GetSize();
+			job.timings.objcopy = GetElapsedMs(stageTime);
+
+			if (!job.cacheHit && cacheKeys[jobIdx].size() > 0)
+			{
+				StoreCachedObject(cacheKeys[jobIdx], job);
+				job.timings.cacheLookup += GetElapsedMs(stageTime);
+			}
+
+			//Estimate from the unpatched code, linking only changes operands
+			CycleEstimator cycleEstimator;
+			cycleEstimator.EstimateFunctions(elf, job.binary, job.cycleEstimates);
+			job.timings.cycleEstimate = GetElapsedMs(stageTime);
+
+			//Scripts which don't call out have no relocations, and link as-is
+			ReadRelocationTable(elf, globalOffsetsIndex, job.relocationTable);
+			job.timings.symbolRead = GetElapsedMs(stageTime);
+
+			//Same object and GOT indices as its last link, the .bin on disk is still good
+			std::string linkStamp;
+			if (cacheKeys[jobIdx].size() > 0)
+			{
+				linkStamp = GetLinkStamp(cacheKeys[jobIdx], job.relocationTable, globalOffsetTableSize, job.binaryStartOffset);
+			}
+
+			if (job.cacheHit && linkStamp.size() > 0 && ReadLinkedBinary(job.outname, linkStamp, job.binary))
+			{
+				job.linkReused = true;
+				job.binarySize = (int)job.binary.size();
+				job.timings.link = GetElapsedMs(stageTime);
+				return;
+			}
+
+			job.binarySize = LinkProgram(job.binary, job.relocationTable, globalOffsetTableSize, job.binaryStartOffset);
+			if (job.binarySize == 0 && job.binary.size() > 0)
+			{
+				job.success = false;
+				job.error = "Link failed, relocation outside of .text";
+				return;
+			}
+
+			//Drop the old stamp first, so an interrupted write can't leave it vouching for a new .bin
+			std::error_code error;
+			std::filesystem::remove(job.outname + ".link", error);
+
+			ion::io::File file(job.outname + ".bin", ion::io::File::OpenMode::Write);
+			if (!file.IsOpen())
+			{
+				job.success = false;
+				job.error = "Could not write " + job.outname + ".bin";
+				return;
+			}
+
+			if (job.binary.size() > 0)
+			{
+				file.Write(&job.binary[0], job.binary.size());
+			}
+
+			file.Close();
+
+			if (linkStamp.size() > 0)
+			{
+				ion::io::File stampFile(job.outname + ".link", ion::io::File::OpenMode::Write);
+				if (stampFile.IsOpen())
+				{
+					stampFile.Write(linkStamp.data(), linkStamp.size());
+					stampFile.Close();
+				}
+			}
+
+			job.timings.link = GetElapsedMs(stageTime);
+		});
+
+		if (m_cacheDirectory.size() > 0)
+		{
+			SaveGlobalOffsetTable(globalOffsetsTable);
+		}
+
+		m_lastBuildTime = GetElapsedMs(buildStartTime);
+
+		bool success = true;
+
+		for (int i = 0; i < numJobs; i++)
+		{
+			success &= jobs[i].success;
+		}
+
+		return success;
+	}
+
+	bool ScriptCompiler::GenerateUnitySource(const std::vector<ScriptBuildJob>& jobs, const std::string& filename)
+	{
+		ion::io::File file(filename, ion::io::File::OpenMode::Write);
+		if (file.IsOpen())
+		{
+			std::stringstream stream;
+			stream << g_header << std::endl << std::endl;
+
+			//Includes resolve from the unity file's directory, not the compiler's working dir
+			std::filesystem::path unityDir = std::filesystem::absolute(filename).parent_path();
+
+			for (int i = 0; i < jobs.size(); i++)
+			{
+				std::filesystem::path sourcePath = std::filesystem::absolute(jobs[i].filename).lexically_normal();
+				std::filesystem::path includePath = sourcePath.lexically_relative(unityDir);
+
+				//No relative path between them (e.g. a different drive), include by absolute path
+				if (includePath.empty())
+					includePath = sourcePath;
+
+				stream << "#include \"" << includePath.generic_string() << "\"" << std::endl;
+			}
+
+			file.Write(stream.str().c_str(), stream.str().size());
+			file.Close();
+			return true;
+		}
+
+		return false;
+	}
+
+	bool ScriptCompiler::BuildUnityScript(const std::vector<ScriptBuildJob>& jobs, ScriptBuildJob& unityJob, std::vector<ScriptEntryPointOffset>& entryPoints, const std::string& compilerDir, const std::vector<std::string>& includeDirs, const std::vector<std::string>& defines, const std::vector<ScriptFunc>& globalOffsetsTable, u16 globalOffsetTableSize)
+	{
+		entryPoints.clear();
+
+		if (!GenerateUnitySource(jobs, unityJob.filename))
+		{
+			unityJob.success = false;
+			unityJob.error = "Could not write " + unityJob.filename;
+			return false;
+		}
+
+		std::vector<ScriptBuildJob> unityJobs;
+		unityJobs.push_back(unityJob);
+
+		bool success = BuildScripts(unityJobs, compilerDir, includeDirs, defines, globalOffsetsTable, globalOffsetTableSize);
+		unityJob = unityJobs[0];
+
+		if (!success)
+		{
+			return false;
+		}
+
+		ElfReader elf;
+		if (!elf.Open(unityJob.outname + ".o"))
+		{
+			unityJob.success = false;
+			unityJob.error = "Could not read object " + unityJob.outname + ".o";
+			return false;
+		}
+
+		for (int i = 0; i < jobs.size(); i++)
+		{
+			for (auto func : g_scriptFuncs)
+			{
+				int offset = FindFunctionOffset(elf, jobs[i].entityName, func.methodName);
+				if (offset >= 0)
+				{
+					ScriptEntryPointOffset entryPoint;
+					entryPoint.scope = jobs[i].entityName;
+					entryPoint.name = func.methodName;
+					entryPoint.offset = offset;
+					entryPoints.push_back(entryPoint);
+				}
+			}
+		}
+
+		return true;
+	}
+
+	void ScriptCompiler::GetScriptAddresses(const std::vector<ScriptEntryPointOffset>& entryPoints, ScriptAddressMap& scriptAddresses)
+	{
+		for (int i = 0; i < entryPoints.size(); i++)
+		{
+			ScriptAddress address;
+			address.name = entryPoints[i].name;
+			address.address = entryPoints[i].offset;
+			scriptAddresses[entryPoints[i].scope].push_back(address);
+		}
+	}
+
+	static int FindWorstCycles(const std::vector<CycleEstimator::Function>& functions, const std::string& scope, const std::string& name)
+	{
+		std::string prefix = scope + "::" + name + "(";
+
+		for (int i = 0; i < functions.size(); i++)
+		{
+			if (ion::string::StartsWith(functions[i].name, prefix))
+			{
+				return functions[i].worstCycles;
+			}
+		}
+
+		return 0;
+	}
+
+	static std::string EscapeJson(const std::string& string)
+	{
+		std::string escaped;
+
+		for (int i = 0; i < string.size(); i++)
+		{
+			switch (string[i])
+			{
+			case '"': escaped += "\\\""; break;
+			case '\\': escaped += "\\\\"; break;
+			case '\n': escaped += "\\n"; break;
+			case '\r': escaped += "\\r"; break;
+			case '\t': escaped += "\\t"; break;
+			default: escaped += string[i]; break;
+			}
+		}
+
+		return escaped;
+	}
+
+	static std::string EscapeCsv(const std::string& string)
+	{
+		if (string.find_first_of(",\"\r\n") == std::string::npos)
+		{
+			return string;
+		}
+
+		//Quote the field, doubling any quotes inside it
+		std::string escaped = "\"";
+
+		for (int i = 0; i < string.size(); i++)
+		{
+			if (string[i] == '"')
+				escaped += '"';
+
+			escaped += string[i];
+		}
+
+		return escaped + "\"";
+	}
+
+	struct BuildStage
+	{
+		const char* name;
+		double ScriptBuildTimings::* time;
+	};
+
+	static const BuildStage s_buildStages[] =
+	{
+		{ "transpile", &ScriptBuildTimings::transpile },
+		{ "cache lookup", &ScriptBuildTimings::cacheLookup },
+		{ "compile", &ScriptBuildTimings::compile },
+		{ "objcopy", &ScriptBuildTimings::objcopy },
+		{ "symbol read", &ScriptBuildTimings::symbolRead },
+		{ "cycle estimate", &ScriptBuildTimings::cycleEstimate },
+		{ "link", &ScriptBuildTimings::link },
+	};
+
+	static bool WriteReportFile(const std::string& filename, const std::stringstream& stream)
+	{
+		ion::io::File file(filename, ion::io::File::OpenMode::Write);
+		if (file.IsOpen())
+		{
+			file.Write(stream.str().c_str(), stream.str().size());
+			file.Close();
+			return true;
+		}
+
+		return false;
+	}
+
+	bool ScriptCompiler::WriteBuildReport(const std::vector<ScriptBuildJob>& jobs, const std::string& jsonFilename, const std::string& csvFilename, const std::string& summaryFilename, double slowScriptFactor)
+	{
+		bool success = true;
+
+		ScriptBuildTimings totals = ScriptBuildTimings();
+		int totalObjectSize = 0;
+		int totalBinarySize = 0;
+		int numCacheHits = 0;
+		int numFailed = 0;
+
+		std::vector<double> jobTimes;
+
+		for (int i = 0; i < jobs.size(); i++)
+		{
+			const ScriptBuildTimings& timings = jobs[i].timings;
+			totals.transpile += timings.transpile;
+			totals.cacheLookup += timings.cacheLookup;
+			totals.compile += timings.compile;
+			totals.objcopy += timings.objcopy;
+			totals.symbolRead += timings.symbolRead;
+			totals.cycleEstimate += timings.cycleEstimate;
+			totals.link += timings.link;
+
+			totalObjectSize += jobs[i].objectSize;
+			totalBinarySize += jobs[i].binarySize;
+			numCacheHits += jobs[i].cacheHit ? 1 : 0;
+			numFailed += jobs[i].success ? 0 : 1;
+
+			jobTimes.push_back(timings.GetTotal());
+		}
+
+		//Per stage medians over the jobs that missed the cache. Hits skip compile, so against a whole build
+		//median a mostly cached build flags every rebuilt script, and a clean build hides a slow one.
+		//With no cache misses there is nothing to compare against and no script is flagged.
+		const int numStages = sizeof(s_buildStages) / sizeof(s_buildStages[0]);
+		double stageMedians[numStages] = {};
+
+		for (int stageIdx = 0; stageIdx < numStages; stageIdx++)
+		{
+			std::vector<double> stageTimes;
+
+			for (int i = 0; i < jobs.size(); i++)
+			{
+				if (!jobs[i].cacheHit)
+				{
+					stageTimes.push_back(jobs[i].timings.*s_buildStages[stageIdx].time);
+				}
+			}
+
+			if (stageTimes.size() > 0)
+			{
+				std::sort(stageTimes.begin(), stageTimes.end());
+				stageMedians[stageIdx] = stageTimes[stageTimes.size() / 2];
+			}
+		}
+
+		//Stage with the highest time to median ratio over slowScriptFactor, or -1
+		auto GetSlowStage = [&](int jobIdx, double& ratio)
+		{
+			int slowStage = -1;
+			ratio = 0.0;
+
+			for (int stageIdx = 0; stageIdx < numStages && slowScriptFactor > 0.0; stageIdx++)
+			{
+				if (stageMedians[stageIdx] > 0.0)
+				{
+					double stageRatio = (jobs[jobIdx].timings.*s_buildStages[stageIdx].time) / stageMedians[stageIdx];
+					if (stageRatio > slowScriptFactor && stageRatio > ratio)
+					{
+						slowStage = stageIdx;
+						ratio = stageRatio;
+					}
+				}
+			}
+
+			return slowStage;
+		};
+
+		auto IsSlow = [&](int jobIdx) { double ratio; return GetSlowStage(jobIdx, ratio) >= 0; };
+
+		if (jsonFilename.size() > 0)
+		{
+			std::stringstream stream;
+			stream << std::fixed << std::setprecision(3);
+
+			stream << "{" << std::endl;
+			stream << "\t\"buildTimeMs\": " << m_lastBuildTime << "," << std::endl;
+			stream << "\t\"maxThreads\": " << parallel::GetNumThreads(m_maxThreads, (int)jobs.size()) << "," << std::endl;
+			stream << "\t\"cacheHits\": " << numCacheHits << "," << std::endl;
+			stream << "\t\"scripts\": [" << std::endl;
+
+			for (int i = 0; i < jobs.size(); i++)
+			{
+				const ScriptBuildTimings& timings = jobs[i].timings;
+
+				stream << "\t\t{ "
+					<< "\"entity\": \"" << EscapeJson(jobs[i].entityName) << "\", "
+					<< "\"filename\": \"" << EscapeJson(jobs[i].filename) << "\", "
+					<< "\"success\": " << (jobs[i].success ? "true" : "false") << ", "
+					<< "\"cacheHit\": " << (jobs[i].cacheHit ? "true" : "false") << ", "
+					<< "\"slow\": " << (IsSlow(i) ? "true" : "false") << ", "
+					<< "\"objectSize\": " << jobs[i].objectSize << ", "
+					<< "\"binarySize\": " << jobs[i].binarySize << ", "
+					<< "\"timingsMs\": { "
+					<< "\"transpile\": " << timings.transpile << ", "
+					<< "\"cacheLookup\": " << timings.cacheLookup << ", "
+					<< "\"compile\": " << timings.compile << ", "
+					<< "\"objcopy\": " << timings.objcopy << ", "
+					<< "\"symbolRead\": " << timings.symbolRead << ", "
+					<< "\"cycleEstimate\": " << timings.cycleEstimate << ", "
+					<< "\"link\": " << timings.link << ", "
+					<< "\"total\": " << timings.GetTotal() << " } }"
+					<< ((i != jobs.size() - 1) ? "," : "") << std::endl;
+			}
+
+			stream << "\t]" << std::endl;
+			stream << "}" << std::endl;
+
+			success &= WriteReportFile(jsonFilename, stream);
+		}
+
+		if (csvFilename.size() > 0)
+		{
+			std::stringstream stream;
+			stream << std::fixed << std::setprecision(3);
+
+			stream << "entity,success,cacheHit,slow,objectSize,binarySize,transpileMs,cacheLookupMs,compileMs,objcopyMs,symbolReadMs,cycleEstimateMs,linkMs,totalMs" << std::endl;
+
+			for (int i = 0; i < jobs.size(); i++)
+			{
+				const ScriptBuildTimings& timings = jobs[i].timings;
+
+				stream << EscapeCsv(jobs[i].entityName) << ","
+					<< (jobs[i].success ? 1 : 0) << ","
+					<< (jobs[i].cacheHit ? 1 : 0) << ","
+					<< (IsSlow(i) ? 1 : 0) << ","
+					<< jobs[i].objectSize << ","
+					<< jobs[i].binarySize << ","
+					<< timings.transpile << ","
+					<< timings.cacheLookup << ","
+					<< timings.compile << ","
+					<< timings.objcopy << ","
+					<< timings.symbolRead << ","
+					<< timings.cycleEstimate << ","
+					<< timings.link << ","
+					<< timings.GetTotal() << std::endl;
+			}
+
+			success &= WriteReportFile(csvFilename, stream);
+		}
+
+		if (summaryFilename.size() > 0)
+		{
+			std::stringstream stream;
+			stream << std::fixed << std::setprecision(1);
+
+			double totalTime = totals.GetTotal();
+
+			auto WriteStage = [&](const char* name, double time)
+			{
+				stream << "  " << std::left << std::setw(16) << name << std::right << std::setw(10) << time << " ms"
+					<< std::setw(8) << ((totalTime > 0.0) ? (time * 100.0 / totalTime) : 0.0) << " %" << std::endl;
+			};
+
+			stream << "Scripts: " << jobs.size() << " (" << numCacheHits << " cache hits, " << numFailed << " failed)" << std::endl;
+			stream << "Wall clock: " << m_lastBuildTime << " ms on " << parallel::GetNumThreads(m_maxThreads, (int)jobs.size()) << " threads" << std::endl;
+			stream << "Object size: " << totalObjectSize << " bytes, binary size: " << totalBinarySize << " bytes" << std::endl;
+			stream << std::endl;
+			stream << "Stage totals (summed over scripts)" << std::endl;
+
+			WriteStage("Transpile", totals.transpile);
+			WriteStage("Cache lookup", totals.cacheLookup);
+			WriteStage("Compile", totals.compile);
+			WriteStage("Objcopy", totals.objcopy);
+			WriteStage("Symbol read", totals.symbolRead);
+			WriteStage("Cycle estimate", totals.cycleEstimate);
+			WriteStage("Link", totals.link);
+			WriteStage("Total", totalTime);
+
+			//Slowest first
+			std::vector<int> order;
+			for (int i = 0; i < jobs.size(); i++)
+			{
+				order.push_back(i);
+			}
+
+			std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return jobTimes[a] > jobTimes[b]; });
+
+			stream << std::endl;
+			stream << "Entity                            Total ms  Compile ms    Binary  Cache" << std::endl;
+
+			for (int i = 0; i < order.size(); i++)
+			{
+				const ScriptBuildJob& job = jobs[order[i]];
+
+				stream << std::left << std::setw(32) << job.entityName << std::right
+					<< std::setw(10) << jobTimes[order[i]]
+					<< std::setw(12) << job.timings.compile
+					<< std::setw(10) << job.binarySize
+					<< std::setw(7) << (job.cacheHit ? "hit" : "miss");
+
+				if (!job.success)
+					stream << "  FAILED";
+
+				double slowRatio;
+				int slowStage = GetSlowStage(order[i], slowRatio);
+				if (slowStage >= 0)
+					stream << "  SLOW (" << s_buildStages[slowStage].name << " " << slowRatio << "x median)";
+
+				stream << std::endl;
+			}
+
+			success &= WriteReportFile(summaryFilename, stream);
+		}
+
+		return success;
+	}
+
+	bool ScriptCompiler::WriteCycleReport(const std::vector<ScriptBuildJob>& jobs, int frameBudgetCycles, const std::string& filename)
+	{
+		std::stringstream stream;
+
+		stream << "Function                                          Best     Worst  Blocks" << std::endl;
+
+		for (int i = 0; i < jobs.size(); i++)
+		{
+			stream << std::endl << jobs[i].entityName << std::endl;
+
+			for (int j = 0; j < jobs[i].cycleEstimates.size(); j++)
+			{
+				const CycleEstimator::Function& function = jobs[i].cycleEstimates[j];
+
+				stream << "  " << std::left << std::setw(44) << function.name << std::right
+					<< std::setw(8) << function.bestCycles
+					<< std::setw(10) << function.worstCycles
+					<< std::setw(8) << function.blocks.size();
+
+				if (!function.complete)
+					stream << "  (partial, undecodable opcode)";
+
+				if (frameBudgetCycles > 0 && function.worstCycles > frameBudgetCycles)
+					stream << "  OVER FRAME BUDGET";
+
+				stream << std::endl;
+			}
+		}
+
+		ion::io::File file(filename, ion::io::File::OpenMode::Write);
+		if (file.IsOpen())
+		{
+			file.Write(stream.str().c_str(), stream.str().size());
+			file.Close();
+			return true;
+		}
+
+		return false;
+	}
+
+	bool ScriptCompiler::WriteUnitySizeReport(const std::vector<ScriptBuildJob>& jobs, const ScriptBuildJob& unityJob, const std::string& filename)
+	{
+		//Entity code in the unity build, from symbol sizes
+		ElfReader elf;
+		if (!elf.Open(unityJob.outname + ".o"))
+		{
+			return false;
+		}
+
+		std::map<std::string, int> unitySizes;
+		const std::vector<ElfReader::Symbol>& symbols = elf.GetSymbols();
+
+		for (int i = 0; i < symbols.size(); i++)
+		{
+			size_t scopeEnd = symbols[i].demangledName.find("::");
+			if (scopeEnd != std::string::npos && symbols[i].sectionIdx != 0)
+			{
+				unitySizes[symbols[i].demangledName.substr(0, scopeEnd)] += symbols[i].size;
+			}
+		}
+
+		std::stringstream stream;
+		int totalSize = 0;
+
+		stream << "Entity                          Separate     Unity   OnUpdate cycles (separate/unity)" << std::endl;
+
+		for (int i = 0; i < jobs.size(); i++)
+		{
+			stream << std::left << std::setw(32) << jobs[i].entityName << std::right
+				<< std::setw(8) << jobs[i].binarySize
+				<< std::setw(10) << unitySizes[jobs[i].entityName]
+				<< std::setw(10) << FindWorstCycles(jobs[i].cycleEstimates, jobs[i].entityName, "OnUpdate")
+				<< " / " << FindWorstCycles(unityJob.cycleEstimates, jobs[i].entityName, "OnUpdate") << std::endl;
+
+			totalSize += jobs[i].binarySize;
+		}
+
+		stream << std::endl;
+		stream << std::left << std::setw(32) << "Total (whole binary)" << std::right
+			<< std::setw(8) << totalSize
+			<< std::setw(10) << unityJob.binarySize << std::endl;
+
+		ion::io::File file(filename, ion::io::File::OpenMode::Write);
+		if (file.IsOpen())
+		{
+			file.Write(stream.str().c_str(), stream.str().size());
+			file.Close();
+			return true;
+		}
+
+		return false;
+	}
+
+	std::string ScriptCompiler::GetBinPath(const std::string& compilerDir)
+	{
+		return ion::io::FileDevice::GetDefault()->GetMountPoint() + "\\" + ion::io::FileDevice::GetDefault()->GetDirectory() + "\\" + compilerDir + "\\" + "bin";
+	}
+
+	std::string ScriptCompiler::GetLibExecPath(const std::string& compilerDir, const std::string& compilerVer)
+	{
+		return ion::io::FileDevice::GetDefault()->GetMountPoint() + "\\"
+			+ ion::io::FileDevice::GetDefault()->GetDirectory() + "\\"
+			+ compilerDir + "\\libexec\\gcc\\m68k-elf\\" + compilerVer;
+	}
+
+	std::string ScriptCompiler::GeneratePreprocessCommand(const std::string& filename, const std::string& compilerDir, const std::vector<std::string>& includeDirs, const std::vector<std::string>& defines)
+	{
+		//Preprocess only, to stdout, without line markers so the output doesn't depend on paths
+		std::string cmdLine = GetBinPath(compilerDir) + "\\" + g_compilerExe + " " + g_compilerArg + " -E -P -B" + compilerDir;
+
+		for (auto include : includeDirs)
+		{
+			cmdLine += " -I" + include;
+		}
+
+		for (auto define : defines)
+		{
+			cmdLine += " -D" + define;
+		}
+
+		cmdLine += " " + filename;
+
+		return cmdLine;
+	}
+
+	std::string ScriptCompiler::GenerateCompileCommand(const std::string& filename, const std::string& outname, const std::string& compilerDir, const std::vector<std::string>& includeDirs, const std::vector<std::string>& defines)
+	{
+		std::string cmdLine = GetBinPath(compilerDir) + "\\" + g_compilerExe + " " + g_compilerArg + " -B" + compilerDir;
+
+		for (auto include : includeDirs)
+		{
+			cmdLine += " -I" + include;
+		}
+
+		for (auto define : defines)
+		{
+			cmdLine += " -D" + define;
+		}
+			
+		cmdLine += " " + filename + " -o " + outname + ".o";
+
+		return cmdLine;
+	}
+
+	std::string ScriptCompiler::GenerateObjCopyCommand(const std::string& filename, const std::string& outname, const std::string& compilerDir)
+	{
+		return GetBinPath(compilerDir) + "\\" + g_objcopyExe + " " + g_objcopyArg + " " + outname + ".o " + outname + ".bin";
+	}
+
+	std::string ScriptCompiler::GenerateSymbolReadCommand(const std::string& filename, const std::string& outname, const std::string& compilerDir)
+	{
+		return GetBinPath(compilerDir) + "\\" + g_symbolReadExe + " " + g_symbolReadArg + " " + outname + ".o ";
+	}
+
+	int ScriptCompiler::ReadRelocationTable(const std::vector<std::string>& symbolOutput, const std::vector<ScriptFunc>& globalOffsetsTable, std::vector<ScriptRelocation>& relocationTable)
+	{
+		return ReadRelocationTable(symbolOutput, GlobalOffsetTableIndex(globalOffsetsTable), relocationTable);
+	}
+
+	int ScriptCompiler::ReadRelocationTable(const std::vector<std::string>& symbolOutput, const GlobalOffsetTableIndex& globalOffsetsTable, std::vector<ScriptRelocation>& relocationTable)
+	{
+		for (auto line : symbolOutput)
+		{
+			//TODO: A bit primitive, will have many edge cases
+			if (line.find("R_68K_GOT") != std::string::npos)
+			{
+				std::vector<std::string> tokens;
+				ion::string::TokeniseByWhitespace(line, tokens);
+
+				//Need at least 3 tokens - address, type, name
+				if (tokens.size() >= 3)
+				{
+					ScriptRelocation entry;
+					entry.address = std::stoul(tokens[0], nullptr, 16);
+
+					std::vector<std::string> nameTokens;
+					ion::string::Tokenise(tokens[2], nameTokens, "::");
+
+					std::vector<char> stripChars = { ':', '(', ')' };
+
+					if (nameTokens.size() == 2)
+					{
+						//Scoped C++ function
+						entry.scope = ion::string::Strip(nameTokens[0], stripChars);
+
+						//todo : substr up to first (
+						int bracketPos = nameTokens[1].find('(');
+						if (bracketPos != std::string::npos)
+						{
+							entry.name = ion::string::Strip(nameTokens[1].substr(0, bracketPos), stripChars);
+						}
+						else
+						{
+							entry.name = ion::string::Strip(nameTokens[1], stripChars);
+						}
+
+						//Match with GOT entry
+						entry.tableIdx = globalOffsetsTable.Find(entry.scope, entry.name);
+					}
+					else if (nameTokens.size() == 1)
+					{
+						//Global, or the GOT
+						entry.name = ion::string::Strip(nameTokens[0], stripChars);
+					}
+
+					relocationTable.push_back(entry);
+				}
+			}
+		}
+
+		//First entry should be the GOT, or there's a problem
+		if (relocationTable.size() == 0 || relocationTable[0].name != "_GLOBAL_OFFSET_TABLE_")
+		{
+			relocationTable.clear();
+		}
+
+		return relocationTable.size();
+	}
+
+	int ScriptCompiler::FindFunctionOffset(const std::vector<std::string>& symbolOutput, const std::string& className, const std::string& name)
+	{
+		for (auto line : symbolOutput)
+		{
+			//TODO: A bit primitive, will have many edge cases
+			if (line.find(className) != std::string::npos && line.find(name) != std::string::npos)
 			{
 				std::vector<std::string> tokens;
 				ion::string::TokeniseByWhitespace(line, tokens);
@@ -453,34 +1782,172 @@ namespace luminary
 		return -1;
 	}
 
-	int ScriptCompiler::LinkProgram(const std::string& filename, std::vector<ScriptRelocation>& relocationTable, u16 globalOffsetTableSize, u16 binaryStartOffset)
+	static void SplitScopedName(const std::string& demangledName, std::vector<std::string>& names)
 	{
-		ion::io::File file(filename, ion::io::File::OpenMode::Edit);
-		if (file.IsOpen())
+		//Scope::name(params), without the params
+		std::string scopedName = demangledName.substr(0, demangledName.find('('));
+		size_t start = 0;
+
+		for (size_t end = scopedName.find("::"); end != std::string::npos; end = scopedName.find("::", start))
+		{
+			names.push_back(scopedName.substr(start, end - start));
+			start = end + 2;
+		}
+
+		names.push_back(scopedName.substr(start));
+	}
+
+	int ScriptCompiler::ReadRelocationTable(const ElfReader& elf, const std::vector<ScriptFunc>& globalOffsetsTable, std::vector<ScriptRelocation>& relocationTable)
+	{
+		return ReadRelocationTable(elf, GlobalOffsetTableIndex(globalOffsetsTable), relocationTable);
+	}
+
+	int ScriptCompiler::ReadRelocationTable(const ElfReader& elf, const GlobalOffsetTableIndex& globalOffsetsTable, std::vector<ScriptRelocation>& relocationTable)
+	{
+		const std::vector<ElfReader::Symbol>& symbols = elf.GetSymbols();
+		const std::vector<ElfReader::Relocation>& relocations = elf.GetTextRelocations();
+
+		for (int i = 0; i < relocations.size(); i++)
 		{
-			for (auto entry : relocationTable)
+			if (ElfReader::IsGOTRelocation(relocations[i].type))
 			{
-				file.Seek(entry.address, ion::io::SeekMode::Start);
+				const ElfReader::Symbol& symbol = symbols[relocations[i].symbolIdx];
 
-				if (entry.name == "_GLOBAL_OFFSET_TABLE_")
+				ScriptRelocation entry;
+				entry.address = relocations[i].offset;
+				entry.tableIdx = -1;
+
+				std::vector<std::string> names;
+				SplitScopedName(symbol.demangledName, names);
+
+				if (names.size() == 2)
 				{
-					//Offset from PC to global offset table
-					u16 tableOffsetShort = -entry.address - binaryStartOffset - globalOffsetTableSize;
-					ion::memory::EndianSwap(tableOffsetShort);
-					file.Write(&tableOffsetShort, sizeof(u16));
+					//Scoped C++ function, match with GOT entry
+					entry.scope = names[0];
+					entry.name = names[1];
+					entry.tableIdx = globalOffsetsTable.Find(entry.scope, entry.name);
 				}
-				else
+				else if (names.size() == 1)
 				{
-					//Offset into global offset table (longword per entry)
-					u16 tableOffsetShort = entry.tableIdx * sizeof(u32);
-					ion::memory::EndianSwap(tableOffsetShort);
-					file.Write(&tableOffsetShort, sizeof(u16));
+					//Global, the GOT, or an extern "C" register call routine
+					entry.name = names[0];
+					entry.tableIdx = globalOffsetsTable.FindRoutine(entry.name);
 				}
+
+				relocationTable.push_back(entry);
+			}
+		}
+
+		//First entry should be the GOT, or there's a problem
+		if (relocationTable.size() == 0 || relocationTable[0].name != "_GLOBAL_OFFSET_TABLE_")
+		{
+			relocationTable.clear();
+		}
+
+		return relocationTable.size();
+	}
+
+	int ScriptCompiler::FindFunctionOffset(const ElfReader& elf, const std::string& className, const std::string& name)
+	{
+		const std::vector<ElfReader::Symbol>& symbols = elf.GetSymbols();
+
+		for (int i = 0; i < symbols.size(); i++)
+		{
+			std::vector<std::string> names;
+			SplitScopedName(symbols[i].demangledName, names);
+
+			if (names.size() >= 2 && names[names.size() - 2] == className && names.back() == name && symbols[i].sectionIdx != 0)
+			{
+				return symbols[i].value;
+			}
+		}
+
+		return -1;
+	}
+
+	int ScriptCompiler::FindGlobalVarOffset(const std::vector<std::string>& symbolOutput, const std::string& typeName)
+	{
+		for (auto line : symbolOutput)
+		{
+			//TODO: A bit primitive, will have many edge cases
+			std::string searchTermRef = "static const " + typeName + "&";
+			std::string searchTermPtr = "static const " + typeName + "*";
+
+			if (line.find(searchTermRef) != std::string::npos || line.find(searchTermPtr) != std::string::npos)
+			{
+				std::vector<std::string> tokens;
+				ion::string::TokeniseByWhitespace(line, tokens);
+				std::string addressHexText = tokens[0];
+				return std::stoul(addressHexText, nullptr, 16);
+			}
+		}
+
+		return -1;
+	}
+
+	int ScriptCompiler::LinkProgram(const std::string& filename, std::vector<ScriptRelocation>& relocationTable, u16 globalOffsetTableSize, u16 binaryStartOffset)
+	{
+		std::vector<u8> binary;
+
+		{
+			ion::io::File file(filename, ion::io::File::OpenMode::Read);
+			if (!file.IsOpen())
+			{
+				return 0;
 			}
 
-			return file.GetSize();
+			binary.resize(file.GetSize());
+			if (binary.size() > 0)
+			{
+				file.Read(&binary[0], binary.size());
+			}
+
+			file.Close();
+		}
+
+		if (LinkProgram(binary, relocationTable, globalOffsetTableSize, binaryStartOffset) == 0)
+		{
+			return 0;
+		}
+
+		ion::io::File file(filename, ion::io::File::OpenMode::Write);
+		if (file.IsOpen())
+		{
+			file.Write(&binary[0], binary.size());
+			file.Close();
+			return binary.size();
 		}
 
 		return 0;
 	}
+
+	int ScriptCompiler::LinkProgram(std::vector<u8>& binary, const std::vector<ScriptRelocation>& relocationTable, u16 globalOffsetTableSize, u16 binaryStartOffset)
+	{
+		for (auto& entry : relocationTable)
+		{
+			if (entry.address + sizeof(u16) > binary.size())
+			{
+				return 0;
+			}
+
+			u16 tableOffsetShort = 0;
+
+			if (entry.name == "_GLOBAL_OFFSET_TABLE_")
+			{
+				//Offset from PC to global offset table
+				tableOffsetShort = -entry.address - binaryStartOffset - globalOffsetTableSize;
+			}
+			else
+			{
+				//Offset into global offset table (longword per entry)
+				tableOffsetShort = entry.tableIdx * sizeof(u32);
+			}
+
+			//Big endian
+			binary[entry.address] = (u8)(tableOffsetShort >> 8);
+			binary[entry.address + 1] = (u8)(tableOffsetShort & 0xFF);
+		}
+
+		return binary.size();
+	}
 }
\ No newline at end of file
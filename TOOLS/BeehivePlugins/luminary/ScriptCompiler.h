@@ -9,8 +9,12 @@
 #pragma once
 
 #include "Types.h"
+#include "ElfReader.h"
+#include "CycleEstimator.h"
+#include "StructLayout.h"
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace luminary
@@ -18,23 +22,178 @@ namespace luminary
 	class ScriptTranspiler
 	{
 	public:
+		ScriptTranspiler();
+
+		//Packed layouts reorder params by size to minimise padding, the ASM rs order must be changed to match
+		//(the generated headers list the expected order, and #error until it does). Off by default, headers follow
+		//the ASM order as-is.
+		void SetPackedLayouts(bool packed);
+
 		bool GenerateComponentCppHeader(const std::vector<Component>& components, const std::string& outputDir);
 		bool GenerateEntityCppHeader(const Entity& entity, const std::string& outputDir);
 		bool GenerateEntityCppBoilerplate(const Entity& entity, const std::string& outputDir);
+
+		//One entry per unique script func (by scope, name and routine), in entity then component order
 		bool GenerateGlobalOffsetTable(const std::vector<Entity>& entities, const std::vector<Component>& components, std::vector<ScriptFunc>& table, const std::string& asmFilename);
+
+		//As above, but funcs still in previousTable (see ScriptCompiler::LoadGlobalOffsetTable) keep their index,
+		//so unchanged scripts link to the same offsets. New funcs fill freed slots then append, slots left
+		//free stay in the table with an empty routine and are written as 'dc.l 0'.
+		bool GenerateGlobalOffsetTable(const std::vector<Entity>& entities, const std::vector<Component>& components, const std::vector<ScriptFunc>& previousTable, std::vector<ScriptFunc>& table, const std::string& asmFilename);
+
+	private:
+		bool m_packedLayouts;
+	};
+
+	//Scope::name lookup into a global offset table, first entry wins
+	class GlobalOffsetTableIndex
+	{
+	public:
+		GlobalOffsetTableIndex(const std::vector<ScriptFunc>& table);
+
+		int Find(const std::string& scope, const std::string& name) const;
+
+		//By ASM routine label, for extern "C" routine symbols
+		int FindRoutine(const std::string& routine) const;
+
+	private:
+		std::unordered_map<std::string, int> m_index;
+		std::unordered_map<std::string, int> m_routineIndex;
+	};
+
+	//Wall clock milliseconds spent in each build stage of one script
+	struct ScriptBuildTimings
+	{
+		double transpile = 0.0;	//Set by the caller around ScriptTranspiler, kept by BuildScripts
+		double cacheLookup = 0.0;	//Manifest or preprocess, hash and object fetch
+		double compile = 0.0;
+		double objcopy = 0.0;	//.text extraction, in process from the object
+		double symbolRead = 0.0;	//Relocation read, in process from the object
+		double cycleEstimate = 0.0;
+		double link = 0.0;	//In memory link and .bin write
+
+		double GetTotal() const { return transpile + cacheLookup + compile + objcopy + symbolRead + cycleEstimate + link; }
+	};
+
+	//One entity script's trip through compile and link
+	struct ScriptBuildJob
+	{
+		std::string entityName;
+		std::string filename;
+		std::string outname;
+		u16 binaryStartOffset;
+
+		//Results
+		std::vector<ScriptRelocation> relocationTable;
+		std::vector<u8> binary;
+		std::vector<CycleEstimator::Function> cycleEstimates;
+		ScriptBuildTimings timings;
+		int objectSize;
+		int binarySize;
+		bool cacheHit;
+		bool linkReused;	//Cache hit whose relocations resolved as in its last link, .bin kept as-is
+		bool success;
+		std::string error;
+	};
+
+	//Entity entry point within a unity script binary
+	struct ScriptEntryPointOffset
+	{
+		std::string scope;
+		std::string name;
+		int offset;
 	};
 
 	class ScriptCompiler
 	{
 	public:
+		ScriptCompiler();
+
+		//Max concurrent tool processes for BuildScripts (0 = one per hardware thread, 1 = serial)
+		void SetMaxThreads(int maxThreads);
+
+		//Object cache directory, keyed by preprocessed source and compile args (empty = always compile).
+		//Lookups try a direct mode manifest first, keyed by the script, its generated header, Components.h,
+		//Common.h and the compile command, and only run the preprocessor if that misses. Edits to any other
+		//header a script includes aren't seen by direct mode, clear the cache after changing them.
+		void SetCacheDirectory(const std::string& directory);
+
+		//Global offset table saved by the last BuildScripts, to keep indices stable when generating the next.
+		//Returns false if there's no cache directory or saved table.
+		bool LoadGlobalOffsetTable(std::vector<ScriptFunc>& table);
+
+		//Object cache key for a job, from its manifest or by preprocessing. Empty if preprocessing failed.
+		std::string GetCacheKey(const ScriptBuildJob& job, const std::string& compilerDir, const std::vector<std::string>& includeDirs, const std::vector<std::string>& defines);
+
+		//Direct mode manifest key, hashed from the job's inputs without preprocessing. Empty if the script can't be read.
+		std::string GetDirectCacheKey(const ScriptBuildJob& job, const std::string& compileCommand, const std::vector<std::string>& includeDirs);
+
+		//Compiles all jobs concurrently, then links each from its object in memory, writing the .bin once.
+		//A failing job is marked with its error and skips later stages, others carry on.
+		//With a cache directory, each .bin gets a .link stamp of its object key, start offset, GOT size and
+		//resolved relocations, and a cache hit with a matching stamp reuses its .bin. The table is saved
+		//for LoadGlobalOffsetTable. Returns true if every job succeeded.
+		bool BuildScripts(std::vector<ScriptBuildJob>& jobs, const std::string& compilerDir, const std::vector<std::string>& includeDirs, const std::vector<std::string>& defines, const std::vector<ScriptFunc>& globalOffsetsTable, u16 globalOffsetTableSize);
+
+		//Unity build: compiles all job sources as one translation unit into unityJob's binary, so shared
+		//helpers are emitted once. Script sources must not define colliding file local helpers.
+		//Returns each entity's OnStart/OnShutdown/OnUpdate offsets in the combined binary. These are not
+		//added to the GOT, which only holds engine routines called by scripts - the engine reads entry
+		//points from the SCRIPTFUNC spawn data params, so pass them on via GetScriptAddresses.
+		bool BuildUnityScript(const std::vector<ScriptBuildJob>& jobs, ScriptBuildJob& unityJob, std::vector<ScriptEntryPointOffset>& entryPoints, const std::string& compilerDir, const std::vector<std::string>& includeDirs, const std::vector<std::string>& defines, const std::vector<ScriptFunc>& globalOffsetsTable, u16 globalOffsetTableSize);
+
+		//Writes the unity .cpp, sources are included relative to its directory
+		bool GenerateUnitySource(const std::vector<ScriptBuildJob>& jobs, const std::string& filename);
+
+		//Adds unity entry points to an entity type's script addresses, for ConvertParam's SCRIPTFUNC lookup
+		void GetScriptAddresses(const std::vector<ScriptEntryPointOffset>& entryPoints, ScriptAddressMap& scriptAddresses);
+
+		//Per entity code size and OnUpdate worst case cycles, separate builds against the unity build
+		bool WriteUnitySizeReport(const std::vector<ScriptBuildJob>& jobs, const ScriptBuildJob& unityJob, const std::string& filename);
+
+		//Static best/worst cycle estimates for every script function, flagging any over the frame budget
+		bool WriteCycleReport(const std::vector<ScriptBuildJob>& jobs, int frameBudgetCycles, const std::string& filename);
+
+		//Per script stage timings, sizes and cache hits from the last BuildScripts, as JSON and CSV for tooling
+		//and a summary table for humans. A script is flagged slow if any stage takes over slowScriptFactor x
+		//that stage's median across the scripts that missed the object cache (cache hits skew the medians).
+		//Any empty filename is skipped.
+		bool WriteBuildReport(const std::vector<ScriptBuildJob>& jobs, const std::string& jsonFilename, const std::string& csvFilename, const std::string& summaryFilename, double slowScriptFactor = 10.0);
+
+		//Runs a command line, collecting its stdout and stderr lines. Returns the process exit code,
+		//or -1 if it couldn't be started or didn't exit normally.
+		int RunCommand(const std::string& cmdLine, std::vector<std::string>& output);
+
 		std::string GetBinPath(const std::string& compilerDir);
 		std::string GetLibExecPath(const std::string& compilerDir, const std::string& compilerVer);
+		std::string GeneratePreprocessCommand(const std::string& filename, const std::string& compilerDir, const std::vector<std::string>& includeDirs, const std::vector<std::string>& defines);
 		std::string GenerateCompileCommand(const std::string& filename, const std::string& outname, const std::string& compilerDir, const std::vector<std::string>& includeDirs, const std::vector<std::string>& defines);
 		std::string GenerateObjCopyCommand(const std::string& filename, const std::string& outname, const std::string& compilerDir);
 		std::string GenerateSymbolReadCommand(const std::string& filename, const std::string& outname, const std::string& compilerDir);
-		int ReadRelocationTable(const std::vector<std::string>& symbolOutput, const std::vector<ScriptFunc> globalOffsetsTable, std::vector<ScriptRelocation>& relocationTable);
+		int ReadRelocationTable(const std::vector<std::string>& symbolOutput, const std::vector<ScriptFunc>& globalOffsetsTable, std::vector<ScriptRelocation>& relocationTable);
+		int ReadRelocationTable(const std::vector<std::string>& symbolOutput, const GlobalOffsetTableIndex& globalOffsetsTable, std::vector<ScriptRelocation>& relocationTable);
 		int FindFunctionOffset(const std::vector<std::string>& symbolOutput, const std::string& className, const std::string& name);
+
+		//Reads relocations and symbols straight from the object, in place of objdump output
+		int ReadRelocationTable(const ElfReader& elf, const std::vector<ScriptFunc>& globalOffsetsTable, std::vector<ScriptRelocation>& relocationTable);
+		int ReadRelocationTable(const ElfReader& elf, const GlobalOffsetTableIndex& globalOffsetsTable, std::vector<ScriptRelocation>& relocationTable);
+		int FindFunctionOffset(const ElfReader& elf, const std::string& className, const std::string& name);
+
 		int FindGlobalVarOffset(const std::vector<std::string>& symbolOutput, const std::string& typeName);
 		int LinkProgram(const std::string& filename, std::vector<ScriptRelocation>& relocationTable, u16 globalOffsetTableSize, u16 binaryStartOffset);
+
+		//Patches GOT offsets into a binary in memory, returns its size (0 if a relocation is out of range)
+		int LinkProgram(std::vector<u8>& binary, const std::vector<ScriptRelocation>& relocationTable, u16 globalOffsetTableSize, u16 binaryStartOffset);
+
+	private:
+		bool FetchCacheManifest(const std::string& directKey, std::string& cacheKey);
+		void StoreCacheManifest(const std::string& directKey, const std::string& cacheKey);
+		bool FetchCachedObject(const std::string& cacheKey, ScriptBuildJob& job);
+		void StoreCachedObject(const std::string& cacheKey, const ScriptBuildJob& job);
+		void SaveGlobalOffsetTable(const std::vector<ScriptFunc>& table);
+
+		int m_maxThreads;
+		double m_lastBuildTime;
+		std::string m_cacheDirectory;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,174 @@
+// ============================================================================================
+// LUMINARY - a game engine and framework for the SEGA Mega Drive
+// ============================================================================================
+// Matt Phillips - Big Evil Corporation Ltd - 17th October 2026
+// ============================================================================================
+// StructLayout.cpp - Lays out entity and component params as the assembler's rs counter does,
+//                    for generating C++ structs that match the ASM offsets exactly
+// ============================================================================================
+
+#include "StructLayout.h"
+
+#include <algorithm>
+
+namespace luminary
+{
+	void StructLayout::AddField(const std::string& name, const std::string& asmName, ParamSize size)
+	{
+		Field field;
+		field.name = name;
+		field.asmName = asmName;
+		field.size = size;
+		field.offset = 0;
+		field.padding = false;
+		m_fields.push_back(field);
+	}
+
+	void StructLayout::Build(bool packed)
+	{
+		std::vector<Field> fields;
+
+		for (int i = 0; i < m_fields.size(); i++)
+		{
+			if (!m_fields[i].padding)
+			{
+				fields.push_back(m_fields[i]);
+			}
+		}
+
+		m_reordered = false;
+
+		if (packed)
+		{
+			std::vector<Field> declared = fields;
+			std::stable_sort(fields.begin(), fields.end(), [](const Field& a, const Field& b) { return (int)a.size > (int)b.size; });
+
+			for (int i = 0; i < fields.size(); i++)
+			{
+				m_reordered |= (fields[i].asmName != declared[i].asmName);
+			}
+		}
+
+		m_fields.clear();
+		m_size = 0;
+		m_paddingSize = 0;
+
+		int paddingIdx = 0;
+
+		auto AlignEven = [&]()
+		{
+			if (m_size & 1)
+			{
+				Field padding;
+				padding.name = "padding" + std::to_string(paddingIdx++);
+				padding.size = ParamSize::Byte;
+				padding.offset = m_size;
+				padding.padding = true;
+				m_fields.push_back(padding);
+
+				m_size++;
+				m_paddingSize++;
+			}
+		};
+
+		for (int i = 0; i < fields.size(); i++)
+		{
+			//68000 words and longs must be on even addresses, rs.w/rs.l align the counter
+			if (fields[i].size != ParamSize::Byte)
+			{
+				AlignEven();
+			}
+
+			fields[i].offset = m_size;
+			m_fields.push_back(fields[i]);
+			m_size += (int)fields[i].size;
+		}
+
+		//The ASM size ends here, the C++ struct rounds up to its word alignment
+		m_asmSize = m_size;
+		AlignEven();
+	}
+
+	void StructLayout::WriteCppFields(std::stringstream& stream, const std::string& indent) const
+	{
+		for (int i = 0; i < m_fields.size(); i++)
+		{
+			if (m_fields[i].padding)
+			{
+				stream << indent << "unsigned char " << m_fields[i].name << ";" << std::endl;
+			}
+			else
+			{
+				switch (m_fields[i].size)
+				{
+				case ParamSize::Byte:
+					stream << indent << "char " << m_fields[i].name << ";" << std::endl;
+					break;
+				case ParamSize::Word:
+					stream << indent << "short " << m_fields[i].name << ";" << std::endl;
+					break;
+				case ParamSize::Long:
+					stream << indent << "int " << m_fields[i].name << ";" << std::endl;
+					break;
+				}
+			}
+		}
+	}
+
+	void StructLayout::WriteCppOffsetAsserts(std::stringstream& stream, const std::string& structName, const std::string& baseName, bool assertSize) const
+	{
+		if (m_fields.empty())
+		{
+			return;
+		}
+
+		//Derived structs aren't standard layout, offsetof is still well defined for single inheritance in GCC
+		stream << "#pragma GCC diagnostic push" << std::endl;
+		stream << "#pragma GCC diagnostic ignored \"-Winvalid-offsetof\"" << std::endl;
+
+		for (int i = 0; i < m_fields.size(); i++)
+		{
+			if (!m_fields[i].padding)
+			{
+				stream << "static_assert(__builtin_offsetof(" << structName << ", " << m_fields[i].name << ") == sizeof(" << baseName << ") + " << m_fields[i].offset
+					<< ", \"" << structName << "::" << m_fields[i].name << " doesn't match ASM offset " << m_fields[i].asmName << "\");" << std::endl;
+			}
+		}
+
+		if (assertSize)
+		{
+			stream << "static_assert(sizeof(" << structName << ") == sizeof(" << baseName << ") + " << m_size << ", \"" << structName << " size doesn't match ASM (" << m_asmSize << " bytes, rounded up to even)\");" << std::endl;
+		}
+
+		stream << "#pragma GCC diagnostic pop" << std::endl;
+	}
+
+	void StructLayout::WriteAsmOrderComment(std::stringstream& stream, const std::string& structName) const
+	{
+		if (m_reordered)
+		{
+			stream << "#error \"" << structName << " packed layout doesn't match the ASM declaration order, reorder its rs params as listed below\"" << std::endl;
+		}
+
+		stream << "// " << structName << " expects its ASM params declared in this order:" << std::endl;
+
+		for (int i = 0; i < m_fields.size(); i++)
+		{
+			if (!m_fields[i].padding)
+			{
+				switch (m_fields[i].size)
+				{
+				case ParamSize::Byte:
+					stream << "//\t" << m_fields[i].asmName << "\trs.b 1" << std::endl;
+					break;
+				case ParamSize::Word:
+					stream << "//\t" << m_fields[i].asmName << "\trs.w 1" << std::endl;
+					break;
+				case ParamSize::Long:
+					stream << "//\t" << m_fields[i].asmName << "\trs.l 1" << std::endl;
+					break;
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,66 @@
+// ============================================================================================
+// LUMINARY - a game engine and framework for the SEGA Mega Drive
+// ============================================================================================
+// Matt Phillips - Big Evil Corporation Ltd - 17th October 2026
+// ============================================================================================
+// StructLayout.h - Lays out entity and component params as the assembler's rs counter does,
+//                  for generating C++ structs that match the ASM offsets exactly
+// ============================================================================================
+
+#pragma once
+
+#include "Types.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace luminary
+{
+	class StructLayout
+	{
+	public:
+		struct Field
+		{
+			std::string name;
+			std::string asmName;
+			ParamSize size;
+			int offset;
+			bool padding;
+		};
+
+		void AddField(const std::string& name, const std::string& asmName, ParamSize size);
+
+		//Assigns rs offsets, words and longs are word aligned. ENTITY_COMPONENT_END and ENTITY_END don't
+		//align the end, so the ASM size can be odd, but the C++ struct is word aligned and rounds its size
+		//up - that trailing byte is emitted as an explicit padding field. Packed mode sorts fields longs
+		//first, then words, then bytes, leaving at most that one padding byte, and the ASM rs declarations
+		//must then be reordered to match (see WriteAsmOrderComment).
+		void Build(bool packed);
+
+		const std::vector<Field>& GetFields() const { return m_fields; }
+		int GetSize() const { return m_size; }
+		int GetAsmSize() const { return m_asmSize; }
+		int GetPaddingSize() const { return m_paddingSize; }
+
+		//Packed order differs from the order fields were added in (the ASM declaration order)
+		bool IsReordered() const { return m_reordered; }
+
+		//Member declarations, including explicit padding fields
+		void WriteCppFields(std::stringstream& stream, const std::string& indent) const;
+
+		//static_asserts on member offsets, relative to the end of the base struct
+		void WriteCppOffsetAsserts(std::stringstream& stream, const std::string& structName, const std::string& baseName, bool assertSize) const;
+
+		//Commented rs block in the order the layout expects, preceded by an #error if the ASM declares
+		//the fields in a different order, so the header can't compile against the wrong offsets
+		void WriteAsmOrderComment(std::stringstream& stream, const std::string& structName) const;
+
+	private:
+		std::vector<Field> m_fields;
+		int m_size = 0;
+		int m_asmSize = 0;
+		int m_paddingSize = 0;
+		bool m_reordered = false;
+	};
+}
@@ -7,8 +7,8 @@
 // ============================================================================================
 
 #include "Tags.h"
+#include <cctype>
 #include <vector>
-#include <ion/core/string/String.h>
 
 namespace luminary
 {
@@ -25,8 +25,48 @@ namespace luminary
 			{ "ENTITY_ARCHETYPE", TagType::EntityArchetype },
 			{ "SCRIPT_DATA", TagType::ScriptData },
 			{ "PREFAB_DATA", TagType::PrefabData },
+			{ "SCRIPTFUNC", TagType::ScriptFunc },
+			{ "SCRIPTGLOBAL", TagType::ScriptGlobal },
 		};
 
+		//Valued tags are written NAME_value (as in ESCRIPT.ASM's SCRIPTFUNC_OnStart), or NAME=value
+		static const char s_tagValueDelims[] = { '_', '=' };
+
+		static bool CompareNoCasePrefix(const std::string& string, const std::string& prefix, size_t length)
+		{
+			if (string.size() < length || prefix.size() < length)
+			{
+				return false;
+			}
+
+			for (size_t i = 0; i < length; i++)
+			{
+				if (std::tolower((unsigned char)string[i]) != std::tolower((unsigned char)prefix[i]))
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		bool TagSet::FindTagValue(TagType tagType, std::string& value) const
+		{
+			if (HasTag(tagType))
+			{
+				for (int i = 0; i < values.size(); i++)
+				{
+					if (values[i].first == tagType)
+					{
+						value = values[i].second;
+						return true;
+					}
+				}
+			}
+
+			return false;
+		}
+
 		const std::string& GetTagName(TagType tagType)
 		{
 			return s_tags[(int)tagType].name;
@@ -34,12 +74,9 @@ namespace luminary
 
 		TagType FindTagType(const std::string& name)
 		{
-			for (int i = 0; i < s_tags.size(); i++)
+			if (const ParamTag* tag = FindTag(name))
 			{
-				if (ion::string::CompareNoCase(s_tags[i].name, name))
-				{
-					return s_tags[i].tagType;
-				}
+				return tag->tagType;
 			}
 
 			return (TagType)-1;
@@ -47,9 +84,10 @@ namespace luminary
 
 		const ParamTag* FindTag(const std::string& name)
 		{
+			//Few enough tags to compare in place, without lowercasing a copy or hashing
 			for (int i = 0; i < s_tags.size(); i++)
 			{
-				if (ion::string::CompareNoCase(s_tags[i].name, name))
+				if (name.size() == s_tags[i].name.size() && CompareNoCasePrefix(name, s_tags[i].name, name.size()))
 				{
 					return &s_tags[i];
 				}
@@ -57,5 +95,59 @@ namespace luminary
 
 			return nullptr;
 		}
+
+		static const ParamTag* FindValuedTag(const std::string& tagString, std::string& value)
+		{
+			for (int i = 0; i < s_tags.size(); i++)
+			{
+				const std::string& name = s_tags[i].name;
+
+				if (IsValuedTag(s_tags[i].tagType) && tagString.size() > name.size() && CompareNoCasePrefix(tagString, name, name.size()))
+				{
+					for (int j = 0; j < sizeof(s_tagValueDelims); j++)
+					{
+						if (tagString[name.size()] == s_tagValueDelims[j])
+						{
+							value = tagString.substr(name.size() + 1);
+							return &s_tags[i];
+						}
+					}
+				}
+			}
+
+			return nullptr;
+		}
+
+		bool IsValuedTag(TagType tagType)
+		{
+			return tagType == TagType::ScriptFunc || tagType == TagType::ScriptGlobal;
+		}
+
+		TagSet ParseTags(const std::vector<std::string>& tags)
+		{
+			TagSet tagSet;
+
+			for (int i = 0; i < tags.size(); i++)
+			{
+				std::string value;
+
+				if (const ParamTag* tag = FindTag(tags[i]))
+				{
+					//Plain tag
+					if (!IsValuedTag(tag->tagType))
+					{
+						tagSet.mask |= (1 << (int)tag->tagType);
+					}
+				}
+				else if (const ParamTag* valuedTag = FindValuedTag(tags[i], value))
+				{
+					//NAME_value tag
+					tagSet.mask |= (1 << (int)valuedTag->tagType);
+					tagSet.values.push_back(std::make_pair(valuedTag->tagType, value));
+				}
+			}
+
+			return tagSet;
+		}
 	}
 }
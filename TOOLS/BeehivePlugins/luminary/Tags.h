@@ -8,7 +8,11 @@
 
 #pragma once
 
+#include <ion/core/Types.h>
+
 #include <string>
+#include <vector>
+#include <utility>
 
 namespace luminary
 {
@@ -25,6 +29,10 @@ namespace luminary
 			EntityArchetype,
 			ScriptData,
 			PrefabData,
+
+			//Valued tags (NAME_value)
+			ScriptFunc,
+			ScriptGlobal,
 		};
 
 		struct ParamTag
@@ -33,8 +41,26 @@ namespace luminary
 			TagType tagType;
 		};
 
+		//Tags interned to a bitmask of TagType, with values for valued tags
+		struct TagSet
+		{
+			TagSet() : mask(0) {}
+
+			bool HasTag(TagType tagType) const { return (mask & (1 << (int)tagType)) != 0; }
+			bool FindTagValue(TagType tagType, std::string& value) const;
+
+			u32 mask;
+			std::vector<std::pair<TagType, std::string>> values;
+		};
+
 		const std::string& GetTagName(TagType tagType);
 		TagType FindTagType(const std::string& name);
 		const ParamTag* FindTag(const std::string& name);
+
+		bool IsValuedTag(TagType tagType);
+
+		//Interns a list of tag strings, ignoring unsupported tags. Valued tags match on their name plus one
+		//delimiter ('_' or '='), the rest of the string is the value.
+		TagSet ParseTags(const std::vector<std::string>& tags);
 	}
 }
@@ -7,164 +7,183 @@
 // ============================================================================================
 
 #include "TerrainExporter.h"
+#include "BinaryWriter.h"
 
-#include <ion/core/memory/Endian.h>
+#include <algorithm>
+#include <unordered_map>
 
 namespace luminary
 {
 	bool TerrainExporter::ExportTerrainTileset(const std::string& binFilename, const TerrainTileset& tileset, int tileWidth)
 	{
-		ion::io::File file(binFilename, ion::io::File::OpenMode::Write);
-		if (file.IsOpen())
+		//Height and width per pixel column/row
+		BinaryWriter writer(tileset.GetCount() * tileWidth * 2);
+
+		std::vector<s8> heights;
+		std::vector<s8> widths;
+
+		for (int i = 0; i < tileset.GetCount(); i++)
 		{
-			for (int i = 0; i < tileset.GetCount(); i++)
+			if (const TerrainTile* tile = tileset.GetTerrainTile(i))
 			{
-				if (const TerrainTile* tile = tileset.GetTerrainTile(i))
-				{
-					std::vector<s8> heights;
-					std::vector<s8> widths;
-					tile->GetHeights(heights);
-					tile->GetWidths(widths);
-					file.Write(heights.data(), heights.size());
-					file.Write(widths.data(), widths.size());
-				}
+				heights.clear();
+				widths.clear();
+				tile->GetHeights(heights);
+				tile->GetWidths(widths);
+				writer.WriteBytes(heights.data(), heights.size());
+				writer.WriteBytes(widths.data(), widths.size());
 			}
+		}
+
+		return writer.Flush(binFilename);
+	}
 
-			file.Close();
-			return true;
+	static u64 HashStamp(const u32* data, int size)
+	{
+		//FNV-1a
+		u64 hash = 0xcbf29ce484222325ull;
+
+		for (int i = 0; i < size; i++)
+		{
+			hash ^= data[i];
+			hash *= 0x100000001b3ull;
 		}
 
-		return false;
+		return hash;
 	}
 
 	bool TerrainExporter::ExportTerrainStamps(const std::string& binFilename, const std::vector<Stamp>& stamps, const TerrainTileset& tileset, u32 defaultTileId)
 	{
-		ion::io::File file(binFilename, ion::io::File::OpenMode::Write);
-		if (file.IsOpen())
+		m_remap.clear();
+
+		if (stamps.size() > 0)
 		{
-			if (stamps.size() > 0)
-			{
-				int stampWidth = stamps[0].GetWidth();
-				int stampHeight = stamps[0].GetHeight();
-				int stampSize = stampWidth * stampHeight;
+			int stampWidth = stamps[0].GetWidth();
+			int stampHeight = stamps[0].GetHeight();
+			int stampSize = stampWidth * stampHeight;
 
-				//Find unique, add to m_uniqueStamps, remap to m_remap
-				TerrainStamp currStamp;
+			//Find unique, add to m_uniqueStampData, remap to m_remap
+			int stampStride = stampSize * s_terrainLayers;
+			BeginUniqueStamps(stampStride, (int)stamps.size());
 
-				for (int i = 0; i < s_terrainLayers; i++)
-				{
-					currStamp.layers[i].resize(stampSize);
-				}
+			std::vector<u32> currStamp(stampStride);
 
-				for (int stampIdx = 0; stampIdx < stamps.size(); stampIdx++)
+			for (int stampIdx = 0; stampIdx < stamps.size(); stampIdx++)
+			{
+				for (int layerIdx = 0; layerIdx < s_terrainLayers; layerIdx++)
 				{
-					for (int layerIdx = 0; layerIdx < s_terrainLayers; layerIdx++)
+					for (int y = 0; y < stampHeight; y++)
 					{
-						for (int y = 0; y < stampHeight; y++)
+						for (int x = 0; x < stampWidth; x++)
 						{
-							for (int x = 0; x < stampWidth; x++)
+							u16 tileId = 0;
+							u16 flags = 0;
+							u8 angleByte = 0;
+							u8 quadrant = 0;
+							float degrees = 0.0f;
+
+							if (stamps[stampIdx].GetNumTerrainLayers() > layerIdx)
 							{
-								u16 tileId = 0;
-								u16 flags = 0;
-								u8 angleByte = 0;
-								u8 quadrant = 0;
-								float degrees = 0.0f;
+								tileId = stamps[stampIdx].GetTerrainTile(x, y, layerIdx);
+								flags = stamps[stampIdx].GetCollisionTileFlags(x, y, layerIdx);
 
-								if (stamps[stampIdx].GetNumTerrainLayers() > layerIdx)
+								if (const TerrainTile* tile = tileset.GetTerrainTile(tileId))
 								{
-									tileId = stamps[stampIdx].GetTerrainTile(x, y, layerIdx);
-									flags = stamps[stampIdx].GetCollisionTileFlags(x, y, layerIdx);
-
-									if (const TerrainTile* tile = tileset.GetTerrainTile(tileId))
-									{
-										degrees = tile->GetAngleDegrees();
-										angleByte = tile->GetAngleByte();
-										quadrant = ion::maths::Round(degrees / 90.0f) % 4;
-									}
-
-									//Flags start at bit 12
-									flags |= (quadrant << 8);
-									flags |= angleByte;
+									degrees = tile->GetAngleDegrees();
+									angleByte = tile->GetAngleByte();
+									quadrant = ion::maths::Round(degrees / 90.0f) % 4;
 								}
 
-								currStamp.layers[layerIdx][(y * stampWidth) + x].tileId = tileId;
-								currStamp.layers[layerIdx][(y * stampWidth) + x].flags = flags;
+								//Flags start at bit 12
+								flags |= (quadrant << 8);
+								flags |= angleByte;
 							}
-						}
-					}
-
-					std::vector<TerrainStamp>::const_iterator it = std::find(m_uniqueStamps.begin(), m_uniqueStamps.end(), currStamp);
-					if (it == m_uniqueStamps.end())
-					{
-						//Unique
-						m_uniqueStamps.push_back(currStamp);
-						m_remap.insert(std::make_pair(stampIdx, m_uniqueStamps.size() - 1));
-					}
-					else
-					{
-						//Duplicate
-						m_remap.insert(std::make_pair(stampIdx, it - m_uniqueStamps.begin()));
-					}
-				}
-
-				//Export all unique stamps
-				for (int stampIdx = 0; stampIdx < m_uniqueStamps.size(); stampIdx++)
-				{
-					for (int tileIdx = 0; tileIdx < stampSize; tileIdx++)
-					{
-						for (int layerIdx = 0; layerIdx < s_terrainLayers; layerIdx++)
-						{
-							u16 tileId = m_uniqueStamps[stampIdx].layers[layerIdx][tileIdx].tileId;
-							u16 flags = m_uniqueStamps[stampIdx].layers[layerIdx][tileIdx].flags;
 
 							if (tileId == InvalidTerrainTileId)
 								tileId = defaultTileId;
 
-							u32 longword = (flags << 16) | tileId;
-
-							ion::memory::EndianSwap(longword);
-
-							file.Write(&longword, sizeof(u32));
+							//Export order, layers interleaved per tile
+							currStamp[(((y * stampWidth) + x) * s_terrainLayers) + layerIdx] = ((u32)flags << 16) | tileId;
 						}
 					}
 				}
 
-				return true;
+				m_remap.insert(std::make_pair(stampIdx, AddUniqueStamp(currStamp.data())));
+			}
+
+			//Export all unique stamps
+			BinaryWriter writer(m_uniqueStampData.size() * sizeof(u32));
+
+			for (int i = 0; i < m_uniqueStampData.size(); i++)
+			{
+				writer.WriteU32(m_uniqueStampData[i]);
 			}
+
+			return writer.Flush(binFilename);
 		}
 
+		BeginUniqueStamps(0, 0);
 		return false;
 	}
 
+	void TerrainExporter::BeginUniqueStamps(int stampStride, int reserveStamps)
+	{
+		m_uniqueStampData.clear();
+		m_uniqueStampData.reserve(reserveStamps * stampStride);
+		m_stampHashes.clear();
+		m_stampHashes.reserve(reserveStamps);
+		m_stampStride = stampStride;
+		m_numUniqueStamps = 0;
+	}
+
+	int TerrainExporter::AddUniqueStamp(const u32* stampData)
+	{
+		u64 hash = HashStamp(stampData, m_stampStride);
+
+		//Hashes can collide, confirm against the stored stamp
+		auto range = m_stampHashes.equal_range(hash);
+		for (auto it = range.first; it != range.second; ++it)
+		{
+			if (std::equal(stampData, stampData + m_stampStride, m_uniqueStampData.begin() + (it->second * m_stampStride)))
+			{
+				//Duplicate
+				return it->second;
+			}
+		}
+
+		//Unique
+		int uniqueIdx = m_numUniqueStamps++;
+		m_uniqueStampData.insert(m_uniqueStampData.end(), stampData, stampData + m_stampStride);
+		m_stampHashes.insert(std::make_pair(hash, uniqueIdx));
+		return uniqueIdx;
+	}
+
 	bool TerrainExporter::ExportTerrainMap(const std::string& binFilename, const Map& map, int stampWidth, int stampHeight)
 	{
 		//Use ids from m_remap, export addr offsets (width*height*u32*numLayers)
+		int widthStamps = map.GetWidth() / stampWidth;
+		int heightStamps = map.GetHeight() / stampHeight;
+		u32 stampSizeBytes = stampWidth * stampHeight * sizeof(u32) * s_terrainLayers;
 
-		ion::io::File file(binFilename, ion::io::File::OpenMode::Write);
-		if (file.IsOpen())
-		{
-			int widthStamps = map.GetWidth() / stampWidth;
-			int heightStamps = map.GetHeight() / stampHeight;
-			u32 stampSizeBytes = stampWidth * stampHeight * sizeof(u32) * s_terrainLayers;
+		std::vector<u32> stampMap;
+		stampMap.resize(widthStamps * heightStamps);
 
-			std::vector<u32> stampMap;
-			stampMap.resize(widthStamps * heightStamps);
+		for (TStampPosMap::const_iterator it = map.StampsBegin(), end = map.StampsEnd(); it != end; ++it)
+		{
+			int x = it->m_position.x / stampWidth;
+			int y = it->m_position.y / stampHeight;
+			u16 tileId = m_remap[it->m_id];
+			u32 addr = (tileId * stampSizeBytes);
+			stampMap[(y * widthStamps) + x] = addr;
+		}
 
-			for (TStampPosMap::const_iterator it = map.StampsBegin(), end = map.StampsEnd(); it != end; ++it)
-			{
-				int x = it->m_position.x / stampWidth;
-				int y = it->m_position.y / stampHeight;
-				u16 tileId = m_remap[it->m_id];
-				u32 addr = (tileId * stampSizeBytes);
-				ion::memory::EndianSwap(addr);
-				stampMap[(y * widthStamps) + x] = addr;
-			}
+		BinaryWriter writer(stampMap.size() * sizeof(u32));
 
-			file.Write(stampMap.data(), stampMap.size() * sizeof(u32));
-			file.Close();
-			return true;
+		for (int i = 0; i < stampMap.size(); i++)
+		{
+			writer.WriteU32(stampMap[i]);
 		}
 
-		return false;
+		return writer.Flush(binFilename);
 	}
 }
\ No newline at end of file
@@ -13,6 +13,10 @@
 #include <ion/beehive/Stamp.h>
 #include <ion/beehive/Map.h>
 
+#include <map>
+#include <unordered_map>
+#include <vector>
+
 namespace luminary
 {
 	class TerrainExporter
@@ -24,37 +28,22 @@ namespace luminary
 		bool ExportTerrainStamps(const std::string& binFilename, const std::vector<Stamp>& stamps, const TerrainTileset& tileset, u32 defaultTileId);
 		bool ExportTerrainMap(const std::string& binFilename, const Map& map, int stampWidth, int stampHeight);
 
-		int GetNumUniqueTerrainStamps() const { return m_uniqueStamps.size(); }
+		int GetNumUniqueTerrainStamps() const { return m_numUniqueStamps; }
+
+		//Stamp dedupe used by ExportTerrainStamps. Begin clears the unique stamps, then Add returns the
+		//unique index of a stamp's stampStride exported longwords, storing it if not seen before.
+		void BeginUniqueStamps(int stampStride, int reserveStamps);
+		int AddUniqueStamp(const u32* stampData);
+		const std::vector<u32>& GetUniqueStampData() const { return m_uniqueStampData; }
 
 	private:
-		struct TerrainStamp
-		{
-			bool operator == (const TerrainStamp& rhs) const
-			{
-				for (int i = 0; i < s_terrainLayers; i++)
-				{
-					if (layers[i] != rhs.layers[i])
-						return false;
-				}
-
-				return true;
-			}
-
-			struct TerrainTile
-			{
-				bool operator == (const TerrainTile& rhs) const
-				{
-					return tileId == rhs.tileId && flags == rhs.flags;
-				}
-
-				TerrainTileId tileId;
-				u16 flags;
-			};
-
-			std::vector<TerrainTile> layers[s_terrainLayers];
-		};
-
-		std::vector<TerrainStamp> m_uniqueStamps;
+		//Unique stamps as exported, one (flags << 16) | tileId longword per layer per tile, stamp after stamp
+		std::vector<u32> m_uniqueStampData;
+		int m_numUniqueStamps = 0;
+
+		//Unique stamp indices by hash of their data
+		std::unordered_multimap<u64, int> m_stampHashes;
+		int m_stampStride = 0;
 		std::map<StampId, StampId> m_remap;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,205 @@
+// ============================================================================================
+// LUMINARY - a game engine and framework for the SEGA Mega Drive
+// ============================================================================================
+// Matt Phillips - Big Evil Corporation Ltd - 17th October 2026
+// ============================================================================================
+// TileCompression.cpp - LZ tile compression, matching TILES_DecompressLZ in ENGINE/TILES.ASM
+// ============================================================================================
+
+#include "TileCompression.h"
+
+#include <algorithm>
+
+namespace luminary
+{
+	static const int s_maxLiterals = 128;
+	static const int s_minMatch = 3;
+	static const int s_maxMatch = 130;
+
+	//Shortest match worth breaking a literal run for, a 3 byte match costs as much as the literals
+	static const int s_minUsefulMatch = 4;
+
+	//68000 cycles, from the instruction timings of TILES_DecompressLZ/VDP_LoadTilesCompressed
+	static const int s_cyclesLiteralRun = 46;		//Control byte, branch, loop exit, end check
+	static const int s_cyclesMatchRun = 100;		//Control byte, branch, offset read, source calc, end check
+	static const int s_cyclesPerByte = 22;			//move.b (an)+,(an)+ and dbra
+	static const int s_cyclesPerBlock = 420;		//Block setup and immediate DMA register writes
+
+	static const int s_hashBits = 12;
+	static const int s_maxChain = 64;
+
+	static u32 HashBytes(const u8* data)
+	{
+		return (((u32)data[0] << 16) | ((u32)data[1] << 8) | (u32)data[2]) * 2654435761u >> (32 - s_hashBits);
+	}
+
+	static void WriteLiterals(const u8* data, int count, std::vector<u8>& compressed, TileLZ::Stats& stats)
+	{
+		while (count > 0)
+		{
+			int run = std::min(count, s_maxLiterals);
+
+			compressed.push_back((u8)(run - 1));
+			compressed.insert(compressed.end(), data, data + run);
+			stats.decodeCycles += s_cyclesLiteralRun + (run * s_cyclesPerByte);
+
+			data += run;
+			count -= run;
+		}
+	}
+
+	void TileLZ::Encode(const std::vector<u8>& tiles, std::vector<u8>& compressed, Stats& stats)
+	{
+		compressed.clear();
+		compressed.reserve(tiles.size());
+
+		stats.numTiles = (int)tiles.size() / s_tileSizeBytes;
+		stats.rawSize = (int)tiles.size();
+		stats.decodeCycles = 0;
+
+		const int blockSize = s_blockTiles * s_tileSizeBytes;
+
+		std::vector<int> head(1 << s_hashBits);
+		std::vector<int> chain(blockSize);
+
+		for (int blockStart = 0; blockStart < tiles.size(); blockStart += blockSize)
+		{
+			//Matches never reach outside the block, the engine reuses its buffer per block
+			const u8* block = &tiles[blockStart];
+			int size = std::min(blockSize, (int)tiles.size() - blockStart);
+
+			std::fill(head.begin(), head.end(), -1);
+
+			int literalStart = 0;
+			int pos = 0;
+
+			auto InsertHash = [&](int at)
+			{
+				if (at + s_minMatch <= size)
+				{
+					u32 hash = HashBytes(block + at);
+					chain[at] = head[hash];
+					head[hash] = at;
+				}
+			};
+
+			while (pos < size)
+			{
+				int bestLength = 0;
+				int bestOffset = 0;
+
+				if (pos + s_minMatch <= size)
+				{
+					int maxLength = std::min(s_maxMatch, size - pos);
+					int candidate = head[HashBytes(block + pos)];
+
+					for (int i = 0; i < s_maxChain && candidate >= 0; i++)
+					{
+						//Overlapping matches are fine, both decoders copy forwards a byte at a time
+						int length = 0;
+						while (length < maxLength && block[candidate + length] == block[pos + length])
+						{
+							length++;
+						}
+
+						if (length > bestLength)
+						{
+							bestLength = length;
+							bestOffset = pos - candidate;
+
+							if (length == maxLength)
+								break;
+						}
+
+						candidate = chain[candidate];
+					}
+				}
+
+				if (bestLength >= s_minUsefulMatch)
+				{
+					WriteLiterals(block + literalStart, pos - literalStart, compressed, stats);
+
+					compressed.push_back((u8)(0x80 | (bestLength - s_minMatch)));
+					compressed.push_back((u8)(bestOffset >> 8));
+					compressed.push_back((u8)bestOffset);
+					stats.decodeCycles += s_cyclesMatchRun + (bestLength * s_cyclesPerByte);
+
+					for (int i = 0; i < bestLength; i++)
+					{
+						InsertHash(pos + i);
+					}
+
+					pos += bestLength;
+					literalStart = pos;
+				}
+				else
+				{
+					InsertHash(pos);
+					pos++;
+				}
+			}
+
+			WriteLiterals(block + literalStart, pos - literalStart, compressed, stats);
+			stats.decodeCycles += s_cyclesPerBlock;
+		}
+
+		stats.compressedSize = (int)compressed.size();
+	}
+
+	bool TileLZ::Decode(const std::vector<u8>& compressed, int numTiles, std::vector<u8>& tiles)
+	{
+		tiles.clear();
+		tiles.reserve(numTiles * s_tileSizeBytes);
+
+		const int blockSize = s_blockTiles * s_tileSizeBytes;
+		int pos = 0;
+
+		for (int tileIdx = 0; tileIdx < numTiles; tileIdx += s_blockTiles)
+		{
+			int blockStart = (int)tiles.size();
+			int blockEnd = blockStart + (std::min((int)s_blockTiles, numTiles - tileIdx) * s_tileSizeBytes);
+
+			while (tiles.size() < blockEnd)
+			{
+				if (pos >= compressed.size())
+					return false;
+
+				u8 control = compressed[pos++];
+
+				if (control & 0x80)
+				{
+					if (pos + 2 > compressed.size())
+						return false;
+
+					int length = (control & 0x7F) + s_minMatch;
+					int offset = (compressed[pos] << 8) | compressed[pos + 1];
+					pos += 2;
+
+					int source = (int)tiles.size() - offset;
+					if (offset == 0 || source < blockStart || offset > blockSize)
+						return false;
+
+					for (int i = 0; i < length; i++)
+					{
+						tiles.push_back(tiles[source + i]);
+					}
+				}
+				else
+				{
+					int length = control + 1;
+					if (pos + length > compressed.size())
+						return false;
+
+					tiles.insert(tiles.end(), compressed.begin() + pos, compressed.begin() + pos + length);
+					pos += length;
+				}
+			}
+
+			//The engine stops at the end of the block, a run can't cross it
+			if (tiles.size() != blockEnd)
+				return false;
+		}
+
+		return pos == compressed.size();
+	}
+}
@@ -0,0 +1,54 @@
+// ============================================================================================
+// LUMINARY - a game engine and framework for the SEGA Mega Drive
+// ============================================================================================
+// Matt Phillips - Big Evil Corporation Ltd - 17th October 2026
+// ============================================================================================
+// TileCompression.h - LZ tile compression, matching TILES_DecompressLZ in ENGINE/TILES.ASM
+// ============================================================================================
+
+#pragma once
+
+#include <ion/core/Types.h>
+
+#include <vector>
+
+namespace luminary
+{
+	enum class TileCompression
+	{
+		None,
+		LZ
+	};
+
+	//Byte oriented LZ, tuned for a simple 68000 decode loop over unaligned data. Tiles are compressed in
+	//independent blocks of s_blockTiles so the engine can decompress each to a small RAM buffer and DMA it.
+	//
+	//Control byte per run:
+	//	0nnnnnnn - n+1 literal bytes follow
+	//	1nnnnnnn - copy n+3 bytes from (dest - offset), big endian u16 offset follows, offset within the block
+	class TileLZ
+	{
+	public:
+		static const int s_blockTiles = 32;		//TILES_LZ_BLOCK_TILES
+		static const int s_tileSizeBytes = 32;	//SIZE_TILE_B
+
+		struct Stats
+		{
+			int numTiles;
+			int rawSize;
+			int compressedSize;
+
+			//Estimated 68000 cycles for TILES_DecompressLZ and VDP_LoadTilesCompressed, excluding DMA itself
+			int decodeCycles;
+
+			float GetRatio() const { return (rawSize > 0) ? ((float)compressedSize / (float)rawSize) : 1.0f; }
+			int GetCyclesPerTile() const { return (numTiles > 0) ? (decodeCycles / numTiles) : 0; }
+		};
+
+		//Compresses raw 4bpp tile data, a whole number of tiles
+		static void Encode(const std::vector<u8>& tiles, std::vector<u8>& compressed, Stats& stats);
+
+		//Reference decoder, mirrors TILES_DecompressLZ. Returns false if the data is malformed.
+		static bool Decode(const std::vector<u8>& compressed, int numTiles, std::vector<u8>& tiles);
+	};
+}
@@ -7,101 +7,380 @@
 // ============================================================================================
 
 #include "TilesetExporter.h"
-
-#include <ion/core/memory/Endian.h>
+#include "BinaryWriter.h"
 
 namespace luminary
 {
-	bool TilesetExporter::ExportTileset(const std::string& binFilename, const Tileset& tileset)
+	TilesetExporter::TilesetExporter()
+	{
+		m_compression = TileCompression::None;
+		m_compressionStats = TileLZ::Stats();
+		m_tileWidth = 0;
+		m_tileHeight = 0;
+	}
+
+	void TilesetExporter::SetCompression(TileCompression compression)
+	{
+		m_compression = compression;
+	}
+
+	static void GetTilePixels(const Tile& tile, std::vector<u8>& pixels)
+	{
+		int width = tile.GetWidth();
+		int height = tile.GetHeight();
+
+		pixels.resize(width * height);
+
+		for (int y = 0; y < height; y++)
+		{
+			for (int x = 0; x < width; x++)
+			{
+				pixels[(y * width) + x] = (u8)tile.GetPixelColour(x, y);
+			}
+		}
+	}
+
+	static void GetFlippedTilePixels(const std::vector<u8>& pixels, int width, int height, u16 flipFlags, std::vector<u8>& flipped)
+	{
+		flipped.resize(pixels.size());
+
+		for (int y = 0; y < height; y++)
+		{
+			for (int x = 0; x < width; x++)
+			{
+				int srcX = (flipFlags & Map::eFlipX) ? (width - 1 - x) : x;
+				int srcY = (flipFlags & Map::eFlipY) ? (height - 1 - y) : y;
+				flipped[(y * width) + x] = pixels[(srcY * width) + srcX];
+			}
+		}
+	}
+
+	static u64 HashPixels(const std::vector<u8>& pixels)
+	{
+		//FNV-1a
+		u64 hash = 0xcbf29ce484222325ull;
+
+		for (int i = 0; i < pixels.size(); i++)
+		{
+			hash ^= pixels[i];
+			hash *= 0x100000001b3ull;
+		}
+
+		return hash;
+	}
+
+	int TilesetExporter::DeduplicateTiles(const Tileset& tileset)
+	{
+		const Tile* firstTile = tileset.GetTile(0);
+		BeginUniqueTiles(firstTile ? firstTile->GetWidth() : 0, firstTile ? firstTile->GetHeight() : 0, tileset.GetCount());
+
+		std::vector<u8> pixels;
+
+		for (int i = 0; i < tileset.GetCount(); i++)
+		{
+			if (const Tile* tile = tileset.GetTile(i))
+			{
+				GetTilePixels(*tile, pixels);
+				AddUniqueTile(pixels);
+			}
+			else
+			{
+				TileRemap remap;
+				remap.tileId = InvalidTileId;
+				remap.flipFlags = 0;
+				m_tileRemap.push_back(remap);
+			}
+		}
+
+		return GetNumTilesSaved();
+	}
+
+	void TilesetExporter::BeginUniqueTiles(int width, int height, int maxTiles)
 	{
-		ion::io::File file(binFilename, ion::io::File::OpenMode::Write);
-		if (file.IsOpen())
+		m_tileWidth = width;
+		m_tileHeight = height;
+		m_uniqueTiles.clear();
+		m_tileRemap.clear();
+		m_tileRemap.reserve(maxTiles);
+		m_uniqueTilePixels.clear();
+		m_uniqueTileHashes.clear();
+	}
+
+	TilesetExporter::TileRemap TilesetExporter::AddUniqueTile(const std::vector<u8>& pixels)
+	{
+		const u16 orientations[] = { 0, Map::eFlipX, Map::eFlipY, Map::eFlipX | Map::eFlipY };
+
+		TileRemap remap;
+		remap.tileId = InvalidTileId;
+		remap.flipFlags = 0;
+
+		//If this tile in some orientation matches a unique tile, it's that tile flipped the same way
+		std::vector<u8> flipped;
+
+		for (int orientation = 0; orientation < 4 && remap.tileId == InvalidTileId; orientation++)
 		{
-			for (int i = 0; i < tileset.GetCount(); i++)
+			GetFlippedTilePixels(pixels, m_tileWidth, m_tileHeight, orientations[orientation], flipped);
+
+			auto range = m_uniqueTileHashes.equal_range(HashPixels(flipped));
+			for (auto it = range.first; it != range.second; ++it)
 			{
-				if (const Tile* tile = tileset.GetTile(i))
+				if (m_uniqueTilePixels[it->second] == flipped)
 				{
-					for (int y = 0; y < tile->GetHeight(); y++)
-					{
-						for (int x = 0; x < tile->GetWidth(); x += 2)
-						{
-							u8 nybble1 = (u8)tile->GetPixelColour(x, y) << 4;
-							u8 nybble2 = ((x + 1) < tile->GetWidth()) ? (u8)tile->GetPixelColour(x + 1, y) : 0;
-
-							u8 byte = nybble1 | nybble2;
-							file.Write(&byte, sizeof(u8));
-						}
-					}
+					remap.tileId = it->second;
+					remap.flipFlags = orientations[orientation];
+					break;
 				}
 			}
+		}
 
-			file.Close();
-			return true;
+		if (remap.tileId == InvalidTileId)
+		{
+			remap.tileId = m_uniqueTiles.size();
+			m_uniqueTileHashes.insert(std::make_pair(HashPixels(pixels), (int)m_uniqueTiles.size()));
+			m_uniqueTilePixels.push_back(pixels);
+			m_uniqueTiles.push_back(m_tileRemap.size());
 		}
 
-		return false;
+		m_tileRemap.push_back(remap);
+		return remap;
 	}
 
-	bool TilesetExporter::ExportStamps(const std::string& binFilename, const std::vector<Stamp>& stamps, const Tileset& tileset, u32 backgroundTileId)
+	u16 TilesetExporter::GetTileWord(TileId tileId, u16 tileFlags, u8 paletteId) const
+	{
+		//16 bit word:
+		//-------------------
+		//ABBC DEEE EEEE EEEE
+		//-------------------
+		//A = Low/high plane
+		//B = Palette ID
+		//C = Horizontal flip
+		//D = Vertical flip
+		//E = Tile ID
+
+		//Point to the unique tile, a flipped duplicate flips back by XORing its flips with the stamp's
+		if (tileId < m_tileRemap.size())
+		{
+			tileFlags ^= m_tileRemap[tileId].flipFlags;
+			tileId = m_tileRemap[tileId].tileId;
+		}
+
+		//Generate components
+		u16 tileIndex = tileId & 0x7FF;								//Bottom 11 bits = tile ID (index from 0)
+		u16 flipH = (tileFlags & Map::eFlipX) ? 1 << 11 : 0;		//12th bit = Flip X flag
+		u16 flipV = (tileFlags & Map::eFlipY) ? 1 << 12 : 0;		//13th bit = Flip Y flag
+		u16 palette = (paletteId & 0x3) << 13;						//14th+15th bits = Palette ID
+		u16 plane = (tileFlags & Map::eHighPlane) ? 1 << 15 : 0;	//16th bit = High plane flag
+
+		//Generate word
+		return tileIndex | flipV | flipH | palette | plane;
+	}
+
+	bool TilesetExporter::ExportTileset(const std::string& binFilename, const Tileset& tileset)
+	{
+		//4bpp, two pixels per byte
+		BinaryWriter writer;
+
+		if (const Tile* firstTile = tileset.GetTile(0))
+		{
+			writer.Reserve(tileset.GetCount() * ((firstTile->GetWidth() + 1) / 2) * firstTile->GetHeight());
+		}
+
+		//Unique tiles only if deduplicated
+		int numTiles = (m_tileRemap.size() > 0) ? m_uniqueTiles.size() : tileset.GetCount();
+		std::vector<u8> pixels;
+
+		for (int i = 0; i < numTiles; i++)
+		{
+			if (const Tile* tile = tileset.GetTile((m_tileRemap.size() > 0) ? m_uniqueTiles[i] : i))
+			{
+				GetTilePixels(*tile, pixels);
+				WriteTilePixels(writer, pixels, tile->GetWidth(), tile->GetHeight());
+			}
+		}
+
+		if (m_compression == TileCompression::LZ)
+		{
+			std::vector<u8> compressed;
+			TileLZ::Encode(writer.GetData(), compressed, m_compressionStats);
+
+			//Round trip through the reference decoder before it goes anywhere near the ROM
+			std::vector<u8> decompressed;
+			if (!TileLZ::Decode(compressed, m_compressionStats.numTiles, decompressed) || decompressed != writer.GetData())
+			{
+				ion::debug::Assert(false, "TilesetExporter::ExportTileset() - LZ round trip failed");
+				return false;
+			}
+
+			BinaryWriter compressedWriter(compressed.size());
+			compressedWriter.WriteBytes(compressed.data(), compressed.size());
+			return compressedWriter.Flush(binFilename);
+		}
+
+		return writer.Flush(binFilename);
+	}
+
+	void TilesetExporter::WriteTilePixels(BinaryWriter& writer, const std::vector<u8>& pixels, int width, int height)
+	{
+		for (int y = 0; y < height; y++)
+		{
+			for (int x = 0; x < width; x += 2)
+			{
+				u8 nybble1 = pixels[(y * width) + x] << 4;
+				u8 nybble2 = ((x + 1) < width) ? pixels[(y * width) + x + 1] : 0;
+
+				writer.WriteU8(nybble1 | nybble2);
+			}
+		}
+	}
+
+	void TilesetExporter::GetStampWords(const Stamp& stamp, const Tileset& tileset, u32 backgroundTileId, std::vector<u16>& words) const
+	{
+		words.resize(stamp.GetWidth() * stamp.GetHeight());
+
+		for (int y = 0; y < stamp.GetHeight(); y++)
+		{
+			for (int x = 0; x < stamp.GetWidth(); x++)
+			{
+				//If blank tile, use background tile
+				u32 tileId = stamp.GetTile(x, y);
+
+				if (tileId == InvalidTileId)
+				{
+					tileId = backgroundTileId;
+				}
+
+				const Tile* tile = tileset.GetTile(tileId);
+				ion::debug::Assert(tile, "TilesetExporter::ExportStamps() - Invalid tile");
+
+				words[(y * stamp.GetWidth()) + x] = GetTileWord(tileId, stamp.GetTileFlags(x, y), tile->GetPaletteId());
+			}
+		}
+	}
+
+	void TilesetExporter::GetFlippedStampWords(const std::vector<u16>& words, int width, int height, u16 flipFlags, std::vector<u16>& flipped)
 	{
-		ion::io::File file(binFilename, ion::io::File::OpenMode::Write);
-		if (file.IsOpen())
+		//Mirror the tile order, and flip each tile the same way
+		u16 tileFlips = ((flipFlags & Map::eFlipX) ? 1 << 11 : 0) | ((flipFlags & Map::eFlipY) ? 1 << 12 : 0);
+
+		flipped.resize(words.size());
+
+		for (int y = 0; y < height; y++)
 		{
-			for (int i = 0; i < stamps.size(); i++)
+			for (int x = 0; x < width; x++)
 			{
-				const Stamp& stamp = stamps[i];
+				int srcX = (flipFlags & Map::eFlipX) ? (width - 1 - x) : x;
+				int srcY = (flipFlags & Map::eFlipY) ? (height - 1 - y) : y;
+				flipped[(y * width) + x] = words[(srcY * width) + srcX] ^ tileFlips;
+			}
+		}
+	}
+
+	static u64 HashWords(const std::vector<u16>& words)
+	{
+		//FNV-1a
+		u64 hash = 0xcbf29ce484222325ull;
+
+		for (int i = 0; i < words.size(); i++)
+		{
+			hash ^= words[i];
+			hash *= 0x100000001b3ull;
+		}
 
-				for (int y = 0; y < stamp.GetWidth(); y++)
+		return hash;
+	}
+
+	int TilesetExporter::DeduplicateStamps(const std::vector<Stamp>& stamps, const Tileset& tileset, u32 backgroundTileId)
+	{
+		BeginUniqueStamps(stamps.size());
+
+		std::vector<u16> words;
+
+		for (int i = 0; i < stamps.size(); i++)
+		{
+			GetStampWords(stamps[i], tileset, backgroundTileId, words);
+			AddUniqueStamp(words, stamps[i].GetWidth(), stamps[i].GetHeight());
+		}
+
+		return GetNumStampsSaved();
+	}
+
+	void TilesetExporter::BeginUniqueStamps(int maxStamps)
+	{
+		m_uniqueStamps.clear();
+		m_stampRemap.clear();
+		m_stampRemap.reserve(maxStamps);
+		m_uniqueStampWords.clear();
+		m_uniqueStampSizes.clear();
+		m_uniqueStampHashes.clear();
+	}
+
+	TilesetExporter::StampRemap TilesetExporter::AddUniqueStamp(const std::vector<u16>& words, int width, int height)
+	{
+		const u16 orientations[] = { 0, Map::eFlipX, Map::eFlipY, Map::eFlipX | Map::eFlipY };
+
+		StampRemap remap;
+		remap.stampId = 0;
+		remap.flipFlags = 0;
+		bool found = false;
+
+		//If this stamp in some orientation matches a unique stamp, it's that stamp flipped the same way
+		std::vector<u16> flipped;
+
+		for (int orientation = 0; orientation < 4 && !found; orientation++)
+		{
+			GetFlippedStampWords(words, width, height, orientations[orientation], flipped);
+
+			auto range = m_uniqueStampHashes.equal_range(HashWords(flipped));
+			for (auto it = range.first; it != range.second; ++it)
+			{
+				if (m_uniqueStampSizes[it->second] == std::make_pair(width, height) && m_uniqueStampWords[it->second] == flipped)
 				{
-					for (int x = 0; x < stamp.GetHeight(); x++)
-					{
-						//16 bit word:
-						//-------------------
-						//ABBC DEEE EEEE EEEE
-						//-------------------
-						//A = Low/high plane
-						//B = Palette ID
-						//C = Horizontal flip
-						//D = Vertical flip
-						//E = Tile ID
-
-						u8 paletteId = 0;
-
-						//If blank tile, use background tile
-						u32 tileId = stamp.GetTile(x, y);
-						u16 tileFlags = stamp.GetTileFlags(x, y);
-
-						if (tileId == InvalidTileId)
-						{
-							tileId = backgroundTileId;
-						}
-
-						const Tile* tile = tileset.GetTile(tileId);
-						ion::debug::Assert(tile, "TilesetExporter::ExportStamps() - Invalid tile");
-
-						//Generate components
-						u16 tileIndex = tileId & 0x7FF;								//Bottom 11 bits = tile ID (index from 0)
-						u16 flipH = (tileFlags & Map::eFlipX) ? 1 << 11 : 0;		//12th bit = Flip X flag
-						u16 flipV = (tileFlags & Map::eFlipY) ? 1 << 12 : 0;		//13th bit = Flip Y flag
-						u16 palette = (tile->GetPaletteId() & 0x3) << 13;			//14th+15th bits = Palette ID
-						u16 plane = (tileFlags & Map::eHighPlane) ? 1 << 15 : 0;	//16th bit = High plane flag
-
-						//Generate word
-						u16 word = tileIndex | flipV | flipH | palette | plane;
-
-						//Endian flip
-						ion::memory::EndianSwap(word);
-
-						//Write
-						file.Write(&word, sizeof(u16));
-					}
+					remap.stampId = it->second;
+					remap.flipFlags = orientations[orientation];
+					found = true;
+					break;
 				}
 			}
+		}
+
+		if (!found)
+		{
+			remap.stampId = m_uniqueStamps.size();
+			m_uniqueStampHashes.insert(std::make_pair(HashWords(words), (int)m_uniqueStamps.size()));
+			m_uniqueStampWords.push_back(words);
+			m_uniqueStampSizes.push_back(std::make_pair(width, height));
+			m_uniqueStamps.push_back(m_stampRemap.size());
+		}
+
+		m_stampRemap.push_back(remap);
+		return remap;
+	}
+
+	bool TilesetExporter::ExportStamps(const std::string& binFilename, const std::vector<Stamp>& stamps, const Tileset& tileset, u32 backgroundTileId)
+	{
+		BinaryWriter writer;
 
-			file.Close();
-			return true;
+		if (stamps.size() > 0)
+		{
+			writer.Reserve(stamps.size() * stamps[0].GetWidth() * stamps[0].GetHeight() * sizeof(u16));
+		}
+
+		//Unique stamps only if deduplicated
+		int numStamps = (m_stampRemap.size() > 0) ? m_uniqueStamps.size() : stamps.size();
+		std::vector<u16> words;
+
+		for (int i = 0; i < numStamps; i++)
+		{
+			const Stamp& stamp = (m_stampRemap.size() > 0) ? stamps[m_uniqueStamps[i]] : stamps[i];
+
+			GetStampWords(stamp, tileset, backgroundTileId, words);
+
+			for (int j = 0; j < words.size(); j++)
+			{
+				writer.WriteU16(words[j]);
+			}
 		}
 
-		return false;
+		return writer.Flush(binFilename);
 	}
-}
\ No newline at end of file
+}
@@ -9,18 +9,111 @@
 #pragma once
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <ion/beehive/Tileset.h>
 #include <ion/beehive/Stamp.h>
 #include <ion/beehive/Map.h>
 
+#include "TileCompression.h"
+
 namespace luminary
 {
+	class BinaryWriter;
+
 	class TilesetExporter
 	{
 	public:
+		TilesetExporter();
+
+		//Compression for following ExportTileset calls. LZ tilesets need TILES_FLAG_COMPRESSED set in the scene's
+		//tile count, so MAP_PreLoad loads them with VDP_LoadTilesCompressed.
+		void SetCompression(TileCompression compression);
+
+		//Collapses tiles that are identical to, or H/V/HV flips of, an earlier tile. Following exports then write
+		//unique tiles only, and stamps are remapped to them with their flip bits adjusted. Returns tiles saved.
+		int DeduplicateTiles(const Tileset& tileset);
+
+		struct TileRemap
+		{
+			TileId tileId;
+			u16 flipFlags;
+		};
+
+		//DeduplicateTiles' matching step, on row major colour indices so it works without a tileset. Each added
+		//tile is mapped to the first unique tile it's identical to, or an H/V/HV flip of, else becomes a new
+		//unique tile. Remaps are recorded in add order, as original tile ids.
+		void BeginUniqueTiles(int width, int height, int maxTiles);
+		TileRemap AddUniqueTile(const std::vector<u8>& pixels);
+
+		//Stamp word for an original tile: its unique tile, the stamp's flips XORed with the remap's, and the palette
+		//of the original tile (duplicates are matched on pixels only, so the palette may differ from the unique tile's)
+		u16 GetTileWord(TileId tileId, u16 tileFlags, u8 paletteId) const;
+
+		//Collapses stamps that are identical to, or H/V/HV flips of, an earlier stamp, compared as exported (after
+		//DeduplicateTiles, if called first). Following ExportStamps calls write unique stamps only, and MapExporter
+		//takes GetStampRemap() to point the map at them with its stamp flip flags adjusted. Returns stamps saved.
+		int DeduplicateStamps(const std::vector<Stamp>& stamps, const Tileset& tileset, u32 backgroundTileId);
+
 		bool ExportTileset(const std::string& binFilename, const Tileset& tileset);
+
+		//Packs one tile's row major colour indices as 4bpp, two pixels per byte, as ExportTileset writes them
+		static void WriteTilePixels(BinaryWriter& writer, const std::vector<u8>& pixels, int width, int height);
 		bool ExportStamps(const std::string& binFilename, const std::vector<Stamp>& stamps, const Tileset& tileset, u32 backgroundTileId);
+
+		int GetNumUniqueTiles() const { return m_uniqueTiles.size(); }
+		int GetNumTilesSaved() const { return m_tileRemap.size() - m_uniqueTiles.size(); }
+
+		struct StampRemap
+		{
+			StampId stampId;
+			u16 flipFlags;
+		};
+
+		int GetNumUniqueStamps() const { return m_uniqueStamps.size(); }
+		int GetNumStampsSaved() const { return m_stampRemap.size() - m_uniqueStamps.size(); }
+
+		//By original stamp index, to unique stamp index and the flips that recreate the original
+		const std::vector<StampRemap>& GetStampRemap() const { return m_stampRemap; }
+
+		//DeduplicateStamps' matching step, on exported stamp words so it works without beehive stamps. Each added
+		//stamp is mapped to the first unique stamp of the same size it's identical to, or an X/Y/XY mirror of,
+		//else becomes a new unique stamp. Remaps are recorded in add order, as original stamp indices.
+		void BeginUniqueStamps(int maxStamps);
+		StampRemap AddUniqueStamp(const std::vector<u16>& words, int width, int height);
+
+		//Stamp words mirrored as flipFlags would draw them: tile order reversed and each tile's flip bits toggled
+		static void GetFlippedStampWords(const std::vector<u16>& words, int width, int height, u16 flipFlags, std::vector<u16>& flipped);
+
+		//Size, ratio and estimated decode cycles from the last LZ ExportTileset
+		const TileLZ::Stats& GetCompressionStats() const { return m_compressionStats; }
+
+	private:
+		void GetStampWords(const Stamp& stamp, const Tileset& tileset, u32 backgroundTileId, std::vector<u16>& words) const;
+
+		//Original tile ids to write, in order
+		std::vector<TileId> m_uniqueTiles;
+
+		//By original tile id, to unique tile index and the flips that recreate the original
+		std::vector<TileRemap> m_tileRemap;
+
+		//Unflipped pixels of each unique tile, and unique tile indices by pixel hash
+		std::vector<std::vector<u8>> m_uniqueTilePixels;
+		std::unordered_multimap<u64, int> m_uniqueTileHashes;
+		int m_tileWidth;
+		int m_tileHeight;
+
+		//Original stamp indices to write, in order
+		std::vector<int> m_uniqueStamps;
+		std::vector<StampRemap> m_stampRemap;
+
+		//Unflipped words and dimensions of each unique stamp, and unique stamp indices by word hash
+		std::vector<std::vector<u16>> m_uniqueStampWords;
+		std::vector<std::pair<int, int>> m_uniqueStampSizes;
+		std::unordered_multimap<u64, int> m_uniqueStampHashes;
+
+		TileCompression m_compression;
+		TileLZ::Stats m_compressionStats;
 	};
 }
\ No newline at end of file
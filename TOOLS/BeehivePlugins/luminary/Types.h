@@ -13,6 +13,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
 
 namespace luminary
 {
@@ -66,10 +67,17 @@ namespace luminary
 
 	struct Component
 	{
+		//Declared params and script funcs, from the shared definition if this is an entity's instance of it
+		const std::vector<Param>& GetParams() const { return definition ? definition->params : params; }
+		const std::vector<ScriptFunc>& GetScriptFuncs() const { return definition ? definition->scriptFuncs : scriptFuncs; }
+
 		std::string name;
 		SpawnData spawnData;
 		std::vector<Param> params;
 		std::vector<ScriptFunc> scriptFuncs;
+
+		//Parsed component this instance was created from, shared by all entities using it
+		std::shared_ptr<const Component> definition;
 	};
 
 	struct Entity
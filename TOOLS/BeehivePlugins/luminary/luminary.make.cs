@@ -6,11 +6,31 @@ class Luminary : IonLib
     public Luminary() : base("luminary")
     {
         AddTargets(Globals.IonTargetsDefault);
+
+        //Tests build as their own executable, keep TestMain's main() out of the lib
+        SourceFilesExcludeRegex.Add(@"[\\/]tests[\\/]");
+    }
+
+    [Configure]
+    public override void Configure(Project.Configuration conf, Target target)
+    {
+        base.Configure(conf, target);
+    }
+}
+
+[Generate]
+class LuminaryTests : IonExe
+{
+    public LuminaryTests() : base("luminary_tests")
+    {
+        AddTargets(Globals.IonTargetsDefault);
+        SourceRootPath = @"[project.SharpmakeCsPath]\tests";
     }
 
     [Configure]
     public override void Configure(Project.Configuration conf, Target target)
     {
         base.Configure(conf, target);
+        conf.AddPrivateDependency<Luminary>(target);
     }
 }
\ No newline at end of file
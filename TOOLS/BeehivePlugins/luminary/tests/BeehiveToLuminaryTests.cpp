@@ -0,0 +1,297 @@
+// ============================================================================================
+// LUMINARY - a game engine and framework for the SEGA Mega Drive
+// ============================================================================================
+// Matt Phillips - Big Evil Corporation Ltd - 17th October 2026
+// ============================================================================================
+// BeehiveToLuminaryTests.cpp - Beehive game object conversion tests
+// ============================================================================================
+
+#include "Test.h"
+
+#include "../BeehiveToLuminary.h"
+
+#include <beehive/PlatformConfig.h>
+
+#include <stdio.h>
+#include <thread>
+
+namespace luminary
+{
+	static void SetVariable(GameObjectVariable& variable, const std::string& name, const std::string& value, u8 size, int componentIdx, const std::string& componentName, const std::vector<std::string>& tags)
+	{
+		variable.m_name = name;
+		variable.m_value = value;
+		variable.m_size = size;
+		variable.m_componentIdx = componentIdx;
+		variable.m_componentName = componentName;
+		variable.m_tags = tags;
+	}
+
+	static void AddTypeVariable(GameObjectType& gameObjectType, const std::string& name, const std::string& value, u8 size, int componentIdx = -1, const std::string& componentName = "", const std::vector<std::string>& tags = {})
+	{
+		SetVariable(gameObjectType.AddVariable(), name, value, size, componentIdx, componentName, tags);
+	}
+
+	static void AddOverride(GameObject& gameObject, const std::string& name, const std::string& value, u8 size, int componentIdx = -1, const std::string& componentName = "", const std::vector<std::string>& tags = {})
+	{
+		SetVariable(gameObject.AddVariable(), name, value, size, componentIdx, componentName, tags);
+	}
+
+	static void AddScriptFunc(GameObjectType& gameObjectType, const std::string& name, const std::string& routine, int componentIdx, const std::vector<std::pair<std::string, std::string>>& params)
+	{
+		GameObjectScriptFunc& scriptFunc = gameObjectType.AddScriptFunction();
+		scriptFunc.name = name;
+		scriptFunc.routine = routine;
+		scriptFunc.returnType = "void";
+		scriptFunc.componentIdx = componentIdx;
+		scriptFunc.params = params;
+	}
+
+	//EPickup: entity params with a position tag, an ECScript component with a SCRIPTFUNC param, and an ECSprite component
+	static GameObjectType& CreatePickupType(Project& project)
+	{
+		GameObjectType& gameObjectType = *project.GetGameObjectType(project.AddGameObjectType());
+		gameObjectType.SetName("EPickup");
+		gameObjectType.SetDimensions(ion::Vector2i(16, 24));
+
+		AddTypeVariable(gameObjectType, "EPickup_Value", "5", eSizeWord);
+		AddTypeVariable(gameObjectType, "EPickup_SpawnX", "0", eSizeWord, -1, "", { "POSITION_X" });
+		AddTypeVariable(gameObjectType, "EPickup_SpawnY", "0", eSizeWord, -1, "", { "POSITION_Y" });
+		AddTypeVariable(gameObjectType, "EPickup_Flags", "0x01", eSizeByte);
+		AddTypeVariable(gameObjectType, "SDScript_FuncStart", "0", eSizeWord, 0, "ECScript", { "SCRIPTFUNC_OnStart" });
+		AddTypeVariable(gameObjectType, "SDScript_Data", "scriptdata_EPickup", eSizeLong, 0, "ECScript", { "SCRIPT_DATA" });
+		AddTypeVariable(gameObjectType, "SDSprite_Frame", "2", eSizeByte, 1, "ECSprite");
+		AddTypeVariable(gameObjectType, "SDSprite_Speed", "0x100", eSizeLong, 1, "ECSprite");
+
+		AddScriptFunc(gameObjectType, "Collect", "EPickup_Collect", -1, {});
+		AddScriptFunc(gameObjectType, "SetFrame", "ECSprite_SetFrame", 1, { { "s16", "frame:d0" } });
+
+		return gameObjectType;
+	}
+
+	//A prefab of two pickups, exported as EPrefab instances with a PREFAB_DATA param
+	static GameObjectType& CreatePrefabType(Project& project, const GameObjectType& childType)
+	{
+		GameObjectType& gameObjectType = *project.GetGameObjectType(project.AddGameObjectType());
+		gameObjectType.SetPrefabName("PickupPair");
+
+		for (int i = 0; i < 2; i++)
+		{
+			GameObjectType::PrefabChild child;
+			child.name = "Pickup" + std::to_string(i);
+			child.instanceId = i + 1;
+			child.typeId = childType.GetId();
+			child.spriteActorId = InvalidActorId;
+			child.relativePos = ion::Vector2i(i * 32, 0);
+			gameObjectType.AddPrefabChild(child);
+		}
+
+		beehive::CreatePrefabType(gameObjectType);
+		return gameObjectType;
+	}
+
+	static bool SpawnDataEqual(const SpawnData& lhs, const SpawnData& rhs)
+	{
+		return lhs.name == rhs.name && lhs.params == rhs.params;
+	}
+
+	static bool ScriptFuncsEqual(const std::vector<ScriptFunc>& lhs, const std::vector<ScriptFunc>& rhs)
+	{
+		if (lhs.size() != rhs.size())
+			return false;
+
+		for (int i = 0; i < lhs.size(); i++)
+		{
+			if (lhs[i].name != rhs[i].name || lhs[i].scope != rhs[i].scope || lhs[i].routine != rhs[i].routine
+				|| lhs[i].returnType != rhs[i].returnType || lhs[i].params != rhs[i].params)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	static bool EntitiesEqual(const Entity& lhs, const Entity& rhs)
+	{
+		if (lhs.typeName != rhs.typeName || lhs.id != rhs.id || !SpawnDataEqual(lhs.spawnData, rhs.spawnData)
+			|| lhs.spawnData.positionX != rhs.spawnData.positionX || lhs.spawnData.positionY != rhs.spawnData.positionY
+			|| lhs.spawnData.width != rhs.spawnData.width || lhs.spawnData.height != rhs.spawnData.height
+			|| !ScriptFuncsEqual(lhs.scriptFuncs, rhs.scriptFuncs) || lhs.components.size() != rhs.components.size())
+		{
+			return false;
+		}
+
+		for (int i = 0; i < lhs.components.size(); i++)
+		{
+			if (lhs.components[i].name != rhs.components[i].name || !SpawnDataEqual(lhs.components[i].spawnData, rhs.components[i].spawnData)
+				|| !ScriptFuncsEqual(lhs.components[i].scriptFuncs, rhs.components[i].scriptFuncs))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	LUMINARY_TEST(BeehiveToLuminary_TemplateMatchesConvertEntityInstance)
+	{
+		PlatformConfig platformConfig;
+		Project project(platformConfig);
+		GameObjectType& pickupType = CreatePickupType(project);
+		GameObjectType& prefabType = CreatePrefabType(project, pickupType);
+
+		ScriptAddressMap scriptAddresses;
+		scriptAddresses["EPickup"] = { { "OnStart", 0x0120 }, { "OnCollect", 0x0184 } };
+
+		std::vector<GameObject> gameObjects;
+
+		//Type defaults only
+		gameObjects.push_back(GameObject(1, pickupType.GetId(), ion::Vector2i(10, 20)));
+
+		//Named, with its own dimensions
+		gameObjects.push_back(GameObject(2, pickupType.GetId(), ion::Vector2i(300, 40)));
+		gameObjects.back().SetName("BonusPickup");
+		gameObjects.back().SetDimensions(ion::Vector2i(32, 32));
+
+		//Overridden entity and component params, the component override matched case insensitively
+		gameObjects.push_back(GameObject(3, pickupType.GetId(), ion::Vector2i(0, 0)));
+		AddOverride(gameObjects.back(), "EPickup_Value", "99", eSizeWord);
+		AddOverride(gameObjects.back(), "sdsprite_frame", "7", eSizeByte, 1, "ECSprite");
+
+		//Overridden SCRIPTFUNC param, pointing at another routine
+		gameObjects.push_back(GameObject(4, pickupType.GetId(), ion::Vector2i(64, 64)));
+		AddOverride(gameObjects.back(), "SDScript_FuncStart", "0", eSizeWord, 0, "ECScript", { "SCRIPTFUNC_OnCollect" });
+
+		//Overridden position tagged param, the tag still wins over the value
+		gameObjects.push_back(GameObject(5, pickupType.GetId(), ion::Vector2i(-8, 500)));
+		AddOverride(gameObjects.back(), "EPickup_SpawnX", "1234", eSizeWord, -1, "", { "POSITION_X" });
+
+		//Override from another component, taking the full conversion fallback
+		gameObjects.push_back(GameObject(6, pickupType.GetId(), ion::Vector2i(1, 2)));
+		AddOverride(gameObjects.back(), "SDSprite_Frame", "3", eSizeByte, 0, "ECScript");
+
+		//Prefab instances
+		gameObjects.push_back(GameObject(7, prefabType.GetId(), ion::Vector2i(128, 0)));
+		gameObjects.push_back(GameObject(8, prefabType.GetId(), ion::Vector2i(256, 16)));
+		gameObjects.back().SetName("SecondPair");
+
+		beehive::EntityTemplateCache cache(project, scriptAddresses);
+		std::vector<beehive::EntityTemplateCache::Instance> instances;
+		std::vector<Entity> expected(gameObjects.size());
+
+		for (int i = 0; i < gameObjects.size(); i++)
+		{
+			const GameObjectType& gameObjectType = *project.GetGameObjectType(gameObjects[i].GetTypeId());
+			beehive::ConvertEntityInstance(project, gameObjectType, gameObjects[i], scriptAddresses, expected[i]);
+			instances.push_back(std::make_pair(&gameObjectType, &gameObjects[i]));
+
+			Entity entity;
+			cache.ConvertEntityInstance(gameObjectType, gameObjects[i], entity);
+			TEST_CHECK(EntitiesEqual(entity, expected[i]));
+		}
+
+		//Batched, serial and threaded, in instance order
+		for (int maxThreads = 1; maxThreads <= 4; maxThreads += 3)
+		{
+			std::vector<Entity> entities;
+			cache.SetMaxThreads(maxThreads);
+			cache.ConvertEntityInstances(instances, entities);
+
+			TEST_CHECK_EQUAL(entities.size(), expected.size());
+			for (int i = 0; i < entities.size(); i++)
+			{
+				TEST_CHECK(EntitiesEqual(entities[i], expected[i]));
+			}
+		}
+
+		//Spot check the conversions themselves, so a bug shared by both paths still fails
+		TEST_CHECK_EQUAL(expected[0].spawnData.params[0].value, "5");
+		TEST_CHECK_EQUAL(expected[0].spawnData.params[1].value, std::to_string(10 + GameObject::spriteSheetBorderX));
+		TEST_CHECK_EQUAL(expected[0].components[0].spawnData.params[0].value, "0x0120");
+		TEST_CHECK_EQUAL(expected[0].components[1].scriptFuncs.size(), 1);
+		TEST_CHECK_EQUAL(expected[0].components[1].scriptFuncs[0].scope, "ECSprite");
+		TEST_CHECK_EQUAL(expected[1].spawnData.name, "BonusPickup");
+		TEST_CHECK_EQUAL(expected[2].spawnData.params[0].value, "99");
+		TEST_CHECK_EQUAL(expected[2].components[1].spawnData.params[0].value, "7");
+		TEST_CHECK_EQUAL(expected[3].components[0].spawnData.params[0].value, "0x0184");
+		TEST_CHECK_EQUAL(expected[4].spawnData.params[1].value, std::to_string(-8 + GameObject::spriteSheetBorderX));
+		TEST_CHECK_EQUAL(expected[6].typeName, "EPrefab");
+		TEST_CHECK_EQUAL(expected[6].spawnData.params[0].value, "prefabdata_PickupPair");
+		TEST_CHECK_EQUAL(expected[7].spawnData.name, "SecondPair");
+	}
+
+	LUMINARY_BENCHMARK(BeehiveToLuminary_ConvertEntityInstancesScaling)
+	{
+		//10k pickups, 1 in 4 with overridden params, converted on 1 to N threads
+		const int numInstances = 10000;
+
+		PlatformConfig platformConfig;
+		Project project(platformConfig);
+		GameObjectType& pickupType = CreatePickupType(project);
+
+		ScriptAddressMap scriptAddresses;
+		scriptAddresses["EPickup"] = { { "OnStart", 0x0120 }, { "OnCollect", 0x0184 } };
+
+		std::vector<GameObject> gameObjects;
+		gameObjects.reserve(numInstances);
+
+		for (int i = 0; i < numInstances; i++)
+		{
+			gameObjects.push_back(GameObject(i + 1, pickupType.GetId(), ion::Vector2i((i * 37) % 4096, (i * 11) % 1024)));
+
+			if ((i % 4) == 0)
+			{
+				AddOverride(gameObjects.back(), "EPickup_Value", std::to_string(i), eSizeWord);
+				AddOverride(gameObjects.back(), "SDSprite_Frame", std::to_string(i % 8), eSizeByte, 1, "ECSprite");
+			}
+		}
+
+		std::vector<beehive::EntityTemplateCache::Instance> instances;
+		for (int i = 0; i < gameObjects.size(); i++)
+		{
+			instances.push_back(std::make_pair(&pickupType, &gameObjects[i]));
+		}
+
+		beehive::EntityTemplateCache cache(project, scriptAddresses);
+		std::vector<Entity> serialEntities;
+
+		//Powers of two up to the hardware thread count
+		int maxThreads = std::max((int)std::thread::hardware_concurrency(), 1);
+		std::vector<int> threadCounts;
+		for (int numThreads = 1; numThreads < maxThreads; numThreads *= 2)
+		{
+			threadCounts.push_back(numThreads);
+		}
+
+		threadCounts.push_back(maxThreads);
+
+		double serialTime = 0.0;
+
+		for (int j = 0; j < threadCounts.size(); j++)
+		{
+			int numThreads = threadCounts[j];
+			std::vector<Entity> entities;
+			cache.SetMaxThreads(numThreads);
+
+			double startTime = test::GetTimeMs();
+			cache.ConvertEntityInstances(instances, entities);
+			double time = test::GetTimeMs() - startTime;
+
+			if (numThreads == 1)
+			{
+				serialTime = time;
+				serialEntities = entities;
+			}
+
+			//Same output, in the same order, whatever the thread count
+			TEST_CHECK_EQUAL(entities.size(), numInstances);
+			for (int i = 0; i < entities.size(); i++)
+			{
+				TEST_CHECK(EntitiesEqual(entities[i], serialEntities[i]));
+			}
+
+			printf("    %2d threads: %.1f ms (%.2fx)\n", numThreads, time, serialTime / time);
+		}
+	}
+}
@@ -0,0 +1,86 @@
+// ============================================================================================
+// LUMINARY - a game engine and framework for the SEGA Mega Drive
+// ============================================================================================
+// Matt Phillips - Big Evil Corporation Ltd - 17th October 2026
+// ============================================================================================
+// BinaryWriterTests.cpp - Buffered export writer tests and benchmark
+// ============================================================================================
+
+#include "Test.h"
+
+#include "../BinaryWriter.h"
+
+#include <ion/core/io/File.h>
+#include <ion/core/memory/Endian.h>
+
+#include <stdio.h>
+
+namespace luminary
+{
+	LUMINARY_TEST(BinaryWriter_WritesBigEndian)
+	{
+		BinaryWriter writer(16);
+		writer.WriteU8(0x12);
+		writer.WriteU16(0x3456);
+		writer.WriteU32(0x789ABCDE);
+
+		const u8 bytes[] = { 0xF0, 0x0D };
+		writer.WriteBytes(bytes, sizeof(bytes));
+
+		const std::vector<u8> expected = { 0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE, 0xF0, 0x0D };
+		TEST_CHECK_EQUAL(writer.GetSize(), expected.size());
+		TEST_CHECK(writer.GetData() == expected);
+
+		//Flush writes exactly the buffer
+		std::string filename = test::MakeTempDir("binary_writer") + "/OUT.BIN";
+		TEST_CHECK(writer.Flush(filename));
+
+		ion::io::File file(filename, ion::io::File::OpenMode::Read);
+		TEST_CHECK(file.IsOpen());
+		TEST_CHECK_EQUAL(file.GetSize(), (s64)expected.size());
+
+		std::vector<u8> fileData(expected.size());
+		file.Read(fileData.data(), fileData.size());
+		file.Close();
+		TEST_CHECK(fileData == expected);
+
+		//An empty writer still creates the file
+		TEST_CHECK(BinaryWriter().Flush(filename));
+		ion::io::File emptyFile(filename, ion::io::File::OpenMode::Read);
+		TEST_CHECK_EQUAL(emptyFile.GetSize(), 0);
+	}
+
+	LUMINARY_BENCHMARK(BinaryWriter_StampExport)
+	{
+		//A 1024 stamp 4x4 stampset's worth of tile words, written per word (the previous exporters)
+		//and through one buffered flush
+		const int numWords = 1024 * 4 * 4 * 16;
+		std::string tempDir = test::MakeTempDir("binary_writer_benchmark");
+
+		double startTime = test::GetTimeMs();
+		{
+			ion::io::File file(tempDir + "/PERWORD.BIN", ion::io::File::OpenMode::Write);
+			for (int i = 0; i < numWords; i++)
+			{
+				u16 word = (u16)i;
+				ion::memory::EndianSwap(word);
+				file.Write(&word, sizeof(u16));
+			}
+			file.Close();
+		}
+		double perWordTime = test::GetTimeMs() - startTime;
+
+		startTime = test::GetTimeMs();
+		{
+			BinaryWriter writer(numWords * sizeof(u16));
+			for (int i = 0; i < numWords; i++)
+			{
+				writer.WriteU16((u16)i);
+			}
+			writer.Flush(tempDir + "/BUFFERED.BIN");
+		}
+		double bufferedTime = test::GetTimeMs() - startTime;
+
+		printf("    %d words: per word write %.2f ms, buffered %.2f ms (%.1fx)\n", numWords, perWordTime, bufferedTime, (bufferedTime > 0.0) ? (perWordTime / bufferedTime) : 0.0);
+	}
+}
@@ -0,0 +1,39 @@
+// ============================================================================================
+// LUMINARY - a game engine and framework for the SEGA Mega Drive
+// ============================================================================================
+// Matt Phillips - Big Evil Corporation Ltd - 17th October 2026
+// ============================================================================================
+// CycleEstimatorTests.cpp - Static 68000 cycle estimate tests
+// ============================================================================================
+
+#include "Test.h"
+
+#include "../CycleEstimator.h"
+
+namespace luminary
+{
+	static CycleEstimator::Function EstimateCode(const std::vector<u8>& text)
+	{
+		CycleEstimator::Function function;
+		CycleEstimator().EstimateFunction(text, 0, (u32)text.size(), function);
+		return function;
+	}
+
+	LUMINARY_TEST(CycleEstimator_BccTimings)
+	{
+		//Branch bounds are per instruction, not per edge, so best takes the shorter path at the
+		//branch's minimum and worst the longer path at its maximum
+
+		//beq.s skipping a nop: 8..10, nop 4, rts 16
+		CycleEstimator::Function byteBranch = EstimateCode({ 0x67, 0x02, 0x4E, 0x71, 0x4E, 0x75 });
+		TEST_CHECK(byteBranch.complete);
+		TEST_CHECK_EQUAL(byteBranch.bestCycles, 24);
+		TEST_CHECK_EQUAL(byteBranch.worstCycles, 30);
+
+		//beq.w skipping a nop: 10..12 (never less than taken), nop 4, rts 16
+		CycleEstimator::Function wordBranch = EstimateCode({ 0x67, 0x00, 0x00, 0x04, 0x4E, 0x71, 0x4E, 0x75 });
+		TEST_CHECK(wordBranch.complete);
+		TEST_CHECK_EQUAL(wordBranch.bestCycles, 26);
+		TEST_CHECK_EQUAL(wordBranch.worstCycles, 32);
+	}
+}
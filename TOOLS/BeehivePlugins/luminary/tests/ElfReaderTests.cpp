@@ -0,0 +1,200 @@
+// ============================================================================================
+// LUMINARY - a game engine and framework for the SEGA Mega Drive
+// ============================================================================================
+// Matt Phillips - Big Evil Corporation Ltd - 17th October 2026
+// ============================================================================================
+// ElfReaderTests.cpp - ELF32 big endian object reader and demangler tests
+// ============================================================================================
+
+#include "Test.h"
+#include "TestElf.h"
+
+#include "../ElfReader.h"
+
+namespace luminary
+{
+	//A script object: OnStart calling out through the GOT with every GOT relocation type, plus data relocations
+	static std::vector<u8> BuildScriptObject()
+	{
+		//Section indices, after the null section (.rela.text is 2, .rela.data 4)
+		const u32 textIdx = 1;
+		const u32 dataIdx = 3;
+		const u32 symTabIdx = 5;
+		const u32 strTabIdx = 6;
+
+		std::vector<u8> text;
+		for (int i = 0; i < 32; i++)
+			text.push_back((u8)(0x40 + i));
+
+		std::vector<u8> strTab;
+		strTab.push_back(0);
+
+		std::vector<u8> symTab;
+		test::PushSymbol(symTab, 0, 0, 0, 0, 0);
+		test::PushSymbol(symTab, 0, 0, 0, ElfReader::STT_SECTION, textIdx);
+		test::PushSymbol(symTab, 0, 0, 0, ElfReader::STT_SECTION, dataIdx);
+		test::PushSymbol(symTab, test::AddString(strTab, "_ZN7EPickup7OnStartEv"), 0x00, 24, ElfReader::STT_FUNC, textIdx);
+		test::PushSymbol(symTab, test::AddString(strTab, "ENT_SetPosition"), 0, 0, ElfReader::STT_NOTYPE, 0);
+		test::PushSymbol(symTab, test::AddString(strTab, "ECSprite_SetFrame"), 0, 0, ElfReader::STT_NOTYPE, 0);
+		test::PushSymbol(symTab, test::AddString(strTab, "s_counter"), 0x04, 2, ElfReader::STT_OBJECT, dataIdx);
+
+		std::vector<u8> relaText;
+		test::PushRela(relaText, 0x02, 4, ElfReader::R_68K_GOT32, 0);
+		test::PushRela(relaText, 0x08, 5, ElfReader::R_68K_GOT16, 0);
+		test::PushRela(relaText, 0x0C, 4, ElfReader::R_68K_GOT8, 0);
+		test::PushRela(relaText, 0x10, 5, ElfReader::R_68K_GOT32O, 0);
+		test::PushRela(relaText, 0x16, 4, ElfReader::R_68K_GOT16O, 0);
+		test::PushRela(relaText, 0x1A, 5, ElfReader::R_68K_GOT8O, 0);
+		test::PushRela(relaText, 0x1C, 2, 1, 4);	//R_68K_32 to .data
+		test::PushRela(relaText, 0x1E, 99, ElfReader::R_68K_GOT16O, 0);	//Bad symbol index, dropped
+
+		std::vector<u8> data(8, 0);
+		std::vector<u8> relaData;
+		test::PushRela(relaData, 0x00, 4, ElfReader::R_68K_GOT32, 0);
+
+		return test::BuildElf(
+		{
+			{ ".text", 1, text, 0, 0 },
+			{ ".rela.text", 4, relaText, symTabIdx, textIdx },
+			{ ".data", 1, data, 0, 0 },
+			{ ".rela.data", 4, relaData, symTabIdx, dataIdx },
+			{ ".symtab", 2, symTab, strTabIdx, 3 },
+			{ ".strtab", 3, strTab, 0, 0 },
+			{ ".bss", 8, std::vector<u8>(), 0, 0 },
+		});
+	}
+
+	LUMINARY_TEST(ElfReader_ReadsSectionsSymbolsAndGOTRelocations)
+	{
+		ElfReader elf;
+		std::vector<u8> object = BuildScriptObject();
+		TEST_CHECK(elf.Read(object));
+		TEST_CHECK_EQUAL(elf.GetSize(), object.size());
+
+		//Sections
+		const std::vector<ElfReader::Section>& sections = elf.GetSections();
+		TEST_CHECK_EQUAL(sections.size(), 9);
+		TEST_CHECK_EQUAL(sections[1].name, ".text");
+		TEST_CHECK_EQUAL(sections[2].name, ".rela.text");
+		TEST_CHECK_EQUAL(sections[8].name, ".shstrtab");
+
+		const ElfReader::Section* text = elf.FindSection(".text");
+		TEST_CHECK(text != nullptr);
+		TEST_CHECK_EQUAL(text->size, 32);
+		TEST_CHECK(elf.FindSection(".rodata") == nullptr);
+
+		std::vector<u8> textData;
+		TEST_CHECK(elf.GetSectionData(".text", textData));
+		TEST_CHECK_EQUAL(textData.size(), 32);
+		TEST_CHECK_EQUAL(textData[0], 0x40);
+		TEST_CHECK_EQUAL(textData[31], 0x5F);
+		TEST_CHECK(!elf.GetSectionData(".rodata", textData));
+
+		//.symtab, section symbols named after their section
+		const std::vector<ElfReader::Symbol>& symbols = elf.GetSymbols();
+		TEST_CHECK_EQUAL(symbols.size(), 7);
+		TEST_CHECK_EQUAL(symbols[0].name, "");
+		TEST_CHECK_EQUAL(symbols[1].name, ".text");
+		TEST_CHECK_EQUAL(symbols[1].type, ElfReader::STT_SECTION);
+		TEST_CHECK_EQUAL(symbols[2].name, ".data");
+		TEST_CHECK_EQUAL(symbols[3].name, "_ZN7EPickup7OnStartEv");
+		TEST_CHECK_EQUAL(symbols[3].demangledName, "EPickup::OnStart()");
+		TEST_CHECK_EQUAL(symbols[3].type, ElfReader::STT_FUNC);
+		TEST_CHECK_EQUAL(symbols[3].size, 24);
+		TEST_CHECK_EQUAL(symbols[3].sectionIdx, 1);
+		TEST_CHECK_EQUAL(symbols[4].name, "ENT_SetPosition");
+		TEST_CHECK_EQUAL(symbols[4].demangledName, "ENT_SetPosition");
+		TEST_CHECK_EQUAL(symbols[4].sectionIdx, 0);
+		TEST_CHECK_EQUAL(symbols[6].type, ElfReader::STT_OBJECT);
+		TEST_CHECK_EQUAL(symbols[6].value, 4);
+
+		//.rela.text only, every GOT type in order, the bad symbol index dropped
+		const std::vector<ElfReader::Relocation>& relocations = elf.GetTextRelocations();
+		TEST_CHECK_EQUAL(relocations.size(), 7);
+
+		const u32 gotTypes[] = { 7, 8, 9, 10, 11, 12 };
+		const u32 gotOffsets[] = { 0x02, 0x08, 0x0C, 0x10, 0x16, 0x1A };
+
+		for (int i = 0; i < 6; i++)
+		{
+			TEST_CHECK_EQUAL(relocations[i].type, gotTypes[i]);
+			TEST_CHECK_EQUAL(relocations[i].offset, gotOffsets[i]);
+			TEST_CHECK_EQUAL(relocations[i].symbolIdx, (i & 1) ? 5 : 4);
+			TEST_CHECK(ElfReader::IsGOTRelocation(relocations[i].type));
+		}
+
+		TEST_CHECK_EQUAL(relocations[6].type, 1);
+		TEST_CHECK_EQUAL(relocations[6].symbolIdx, 2);
+		TEST_CHECK_EQUAL(relocations[6].addend, 4);
+		TEST_CHECK(!ElfReader::IsGOTRelocation(relocations[6].type));
+		TEST_CHECK(!ElfReader::IsGOTRelocation(6));
+		TEST_CHECK(!ElfReader::IsGOTRelocation(13));
+	}
+
+	LUMINARY_TEST(ElfReader_RejectsBadObjects)
+	{
+		std::vector<u8> object = BuildScriptObject();
+		ElfReader elf;
+
+		//Truncated header
+		TEST_CHECK(!elf.Read(std::vector<u8>(object.begin(), object.begin() + 0x20)));
+
+		//Little endian
+		std::vector<u8> bad = object;
+		bad[5] = 1;
+		TEST_CHECK(!elf.Read(bad));
+
+		//ELF64
+		bad = object;
+		bad[4] = 2;
+		TEST_CHECK(!elf.Read(bad));
+
+		//Section headers past the end
+		TEST_CHECK(!elf.Read(std::vector<u8>(object.begin(), object.end() - 1)));
+
+		//Still reads the good one after failures
+		TEST_CHECK(elf.Read(object));
+		TEST_CHECK_EQUAL(elf.GetTextRelocations().size(), 7);
+	}
+
+	LUMINARY_TEST(ElfReader_Demangle)
+	{
+		const std::pair<std::string, std::string> cases[] =
+		{
+			//Nested names, params only told apart as empty or not
+			{ "_ZN8ECSprite8SetFrameEs", "ECSprite::SetFrame(...)" },
+			{ "_ZN7EPickup7OnStartEv", "EPickup::OnStart()" },
+			{ "_ZN5Outer5Inner4FuncEii", "Outer::Inner::Func(...)" },
+
+			//Const member, internal linkage, plain names
+			{ "_ZNK8ECSprite8GetFrameEv", "ECSprite::GetFrame()" },
+			{ "_ZL11LocalHelperv", "LocalHelper()" },
+			{ "_ZL7s_count", "s_count" },
+			{ "_Z6Updatei", "Update(...)" },
+			{ "_ZNSt6vector4sizeEv", "std::vector::size()" },
+
+			//Constructors and destructors
+			{ "_ZN7EPickupC1Ev", "EPickup::EPickup()" },
+			{ "_ZN7EPickupC2Ev", "EPickup::EPickup()" },
+			{ "_ZN7EPickupD1Ev", "EPickup::~EPickup()" },
+			{ "_ZN7EPickupD0Ev", "EPickup::~EPickup()" },
+
+			//Templates, substitutions and operators keep the raw name
+			{ "_ZN7EPickup3GetIiEET_v", "_ZN7EPickup3GetIiEET_v" },
+			{ "_ZNS0_3GetEv", "_ZNS0_3GetEv" },
+			{ "_ZN7EPickupplERKS_", "_ZN7EPickupplERKS_" },
+			{ "_Z3MaxIiET_S0_S0_", "_Z3MaxIiET_S0_S0_" },
+
+			//Not mangled, or malformed
+			{ "ENT_SetPosition", "ENT_SetPosition" },
+			{ "_Z", "_Z" },
+			{ "_ZN8ECSprite", "_ZN8ECSprite" },
+			{ "_ZN99ECSpriteE", "_ZN99ECSpriteE" },
+		};
+
+		for (int i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+		{
+			TEST_CHECK_EQUAL(ElfReader::Demangle(cases[i].first), cases[i].second);
+		}
+	}
+}
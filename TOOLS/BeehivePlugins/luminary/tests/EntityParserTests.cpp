@@ -0,0 +1,442 @@
+// ============================================================================================
+// LUMINARY - a game engine and framework for the SEGA Mega Drive
+// ============================================================================================
+// Matt Phillips - Big Evil Corporation Ltd - 17th October 2026
+// ============================================================================================
+// EntityParserTests.cpp - EntityParser tests
+// ============================================================================================
+
+#include "Test.h"
+
+#include "../EntityParser.h"
+
+#include <ion/core/string/String.h>
+
+#include <chrono>
+#include <filesystem>
+#include <stdio.h>
+
+namespace luminary
+{
+	static const char* s_componentFile =
+		"    COMPONENT_SPAWN_DATA_BEGIN ECTest\n"
+		"SDTest_Value                            rs.w 1\n"
+		"    COMPONENT_SPAWN_DATA_END\n"
+		"\n"
+		"    ENTITY_COMPONENT_BEGIN ECTest\n"
+		"ECTest_State                            rs.w 1\n"
+		"    ENTITY_COMPONENT_END\n";
+
+	static const char* s_entityFile =
+		"    ENTITY_BEGIN ETest\n"
+		"ETest_Value                             rs.w 1\n"
+		"    ENT_COMPONENT ECTest\n"
+		"    ENTITY_END\n";
+
+	LUMINARY_TEST(EntityParser_ParsesEachBlockOnce)
+	{
+		std::string root = test::MakeTempDir("EntityParser_ParsesEachBlockOnce");
+		test::WriteTextFile(root + "/ENTITIES/ECTEST.ASM", s_componentFile);
+		test::WriteTextFile(root + "/ENTITIES/SUB/ETEST.asm", s_entityFile);
+
+		//Overlapping, repeated and unnormalised directory lists all name the same two files
+		const std::vector<std::vector<std::string>> directoryLists =
+		{
+			{ root },
+			{ root, root },
+			{ root, root + "/ENTITIES/SUB" },
+			{ root + "/ENTITIES/SUB", root },
+			{ root + "/", root + "/ENTITIES" },
+			{ root + "/ENTITIES/../ENTITIES", root + "/ENTITIES/SUB/" },
+		};
+
+		for (int i = 0; i < directoryLists.size(); i++)
+		{
+			EntityParser parser;
+			std::vector<Entity> entities;
+
+			TEST_CHECK(parser.ParseDirectories(directoryLists[i], entities));
+			TEST_CHECK_EQUAL(entities.size(), 1);
+			TEST_CHECK_EQUAL(entities[0].params.size(), 1);
+			TEST_CHECK_EQUAL(entities[0].components.size(), 1);
+			TEST_CHECK_EQUAL(parser.GetComponents().size(), 1);
+			TEST_CHECK_EQUAL(parser.GetComponents()[0].spawnData.params.size(), 1);
+		}
+	}
+
+	LUMINARY_TEST(EntityParser_EntitiesShareComponentDefinitions)
+	{
+		std::string root = test::MakeTempDir("EntityParser_EntitiesShareComponentDefinitions");
+		test::WriteTextFile(root + "/ECTEST.ASM", std::string(s_componentFile) +
+			"    ENTITY_COMPONENT_BEGIN ECOther\n"
+			"ECOther_State                           rs.b 1\n"
+			"    SCRIPT_FUNC ECOther_Reset,void,Reset\n"
+			"    ENTITY_COMPONENT_END\n");
+		test::WriteTextFile(root + "/ETEST.ASM", std::string(s_entityFile) +
+			"    ENTITY_BEGIN EOther\n"
+			"    ENT_COMPONENT ECTest\n"
+			"    ENT_COMPONENT_NAMED ECOther,m_other\n"
+			"    ENTITY_END\n");
+
+		EntityParser parser;
+		std::vector<Entity> entities;
+
+		TEST_CHECK(parser.ParseDirectories({ root }, entities));
+		TEST_CHECK_EQUAL(entities.size(), 2);
+		TEST_CHECK_EQUAL(entities[0].components.size(), 1);
+		TEST_CHECK_EQUAL(entities[1].components.size(), 2);
+
+		const Component& first = entities[0].components[0];
+		const Component& second = entities[1].components[0];
+		const Component& other = entities[1].components[1];
+
+		//Both entities point at the one parsed ECTest, without copies of its params
+		TEST_CHECK(first.definition != nullptr);
+		TEST_CHECK(first.definition == second.definition);
+		TEST_CHECK(first.params.empty() && first.scriptFuncs.empty());
+		TEST_CHECK_EQUAL(first.name, "ECTest");
+		TEST_CHECK_EQUAL(first.GetParams().size(), 1);
+		TEST_CHECK_EQUAL(first.GetParams()[0].name, "ECTest_State");
+		TEST_CHECK(first.GetParams()[0] == parser.GetComponents()[0].params[0]);
+
+		TEST_CHECK_EQUAL(other.name, "ECOther");
+		TEST_CHECK(other.definition != first.definition);
+		TEST_CHECK_EQUAL(other.GetScriptFuncs().size(), 1);
+		TEST_CHECK_EQUAL(other.GetScriptFuncs()[0].scope, "ECOther");
+
+		//Spawn data is each entity's own, to be filled per instance
+		TEST_CHECK_EQUAL(first.spawnData.params.size(), 1);
+		TEST_CHECK_EQUAL(first.spawnData.params[0].name, "SDTest_Value");
+		entities[0].components[0].spawnData.params[0].value = "0x1234";
+		TEST_CHECK(second.spawnData.params[0].value != "0x1234");
+
+		//Components built outside the parser keep their own data
+		Component standalone;
+		standalone.params.push_back(first.GetParams()[0]);
+		TEST_CHECK_EQUAL(standalone.GetParams().size(), 1);
+	}
+
+	LUMINARY_TEST(EntityParser_CacheRescansChangedFilesOnly)
+	{
+		std::string root = test::MakeTempDir("EntityParser_CacheRescansChangedFilesOnly");
+		std::string cacheFilename = root + "/entities.cache";
+
+		std::vector<std::string> filenames =
+		{
+			root + "/ECTEST.ASM",
+			root + "/ETEST.ASM",
+			root + "/EOTHER.ASM",
+		};
+
+		test::WriteTextFile(filenames[0], s_componentFile);
+		test::WriteTextFile(filenames[1], s_entityFile);
+		test::WriteTextFile(filenames[2], "    ENTITY_BEGIN EOther\n    ENT_COMPONENT ECTest\n    ENTITY_END\n");
+
+		//First parse tokenises everything and writes the cache
+		{
+			EntityParser parser;
+			parser.SetCacheFilename(cacheFilename);
+			std::vector<Entity> entities;
+			TEST_CHECK(parser.ParseFiles(filenames, entities));
+			TEST_CHECK_EQUAL(parser.GetNumFilesScanned(), 3);
+			TEST_CHECK_EQUAL(entities.size(), 2);
+		}
+
+		//A new session loads every file's blocks from the cache file
+		{
+			EntityParser parser;
+			parser.SetCacheFilename(cacheFilename);
+			std::vector<Entity> entities;
+			TEST_CHECK(parser.ParseFiles(filenames, entities));
+			TEST_CHECK_EQUAL(parser.GetNumFilesScanned(), 0);
+			TEST_CHECK_EQUAL(entities.size(), 2);
+		}
+
+		//Touched but unchanged, the content hash still matches
+		std::filesystem::path touched(filenames[2]);
+		std::filesystem::last_write_time(touched, std::filesystem::last_write_time(touched) + std::chrono::seconds(2));
+
+		{
+			EntityParser parser;
+			parser.SetCacheFilename(cacheFilename);
+			std::vector<Entity> entities;
+			TEST_CHECK(parser.ParseFiles(filenames, entities));
+			TEST_CHECK_EQUAL(parser.GetNumFilesScanned(), 0);
+		}
+
+		//Edit one entity, only its file is tokenised again
+		test::WriteTextFile(filenames[1], std::string(s_entityFile) + "    ENTITY_BEGIN ENew\n    ENTITY_END\n");
+
+		{
+			EntityParser parser;
+			parser.SetCacheFilename(cacheFilename);
+			std::vector<Entity> entities;
+			TEST_CHECK(parser.ParseFiles(filenames, entities));
+			TEST_CHECK_EQUAL(parser.GetNumFilesScanned(), 1);
+			TEST_CHECK_EQUAL(entities.size(), 3);
+		}
+
+		//A truncated or overwritten cache file is discarded, everything is tokenised again
+		std::string cacheContents = test::ReadTextFile(cacheFilename);
+		const std::vector<std::string> corruptCaches =
+		{
+			cacheContents.substr(0, cacheContents.size() / 2),
+			cacheContents.substr(0, cacheContents.size() - 1),
+			std::string(cacheContents.size(), 'x'),
+			"",
+		};
+
+		for (int i = 0; i < corruptCaches.size(); i++)
+		{
+			test::WriteTextFile(cacheFilename, corruptCaches[i]);
+
+			EntityParser parser;
+			parser.SetCacheFilename(cacheFilename);
+			std::vector<Entity> entities;
+			TEST_CHECK(parser.ParseFiles(filenames, entities));
+			TEST_CHECK_EQUAL(parser.GetNumFilesScanned(), 3);
+			TEST_CHECK_EQUAL(entities.size(), 3);
+			TEST_CHECK_EQUAL(parser.GetComponents().size(), 1);
+		}
+	}
+
+	//The scanner FindTextBlocks replaced: splits into line and word strings, then searches each line for every keyword
+	static int ReferenceContainsToken(const std::vector<std::string>& tokens, const std::string& string)
+	{
+		for (int i = 0; i < tokens.size(); i++)
+		{
+			if (ion::string::CompareNoCase(tokens[i], string))
+			{
+				return i;
+			}
+		}
+
+		return -1;
+	}
+
+	static void ReferenceFindTextBlocks(const std::string& contents, EntityParser::FileTextBlocks& textBlocks)
+	{
+		struct BlockType
+		{
+			const char* begin;
+			const char* end;
+			std::vector<EntityParser::TextBlock>* blocks;
+		};
+
+		//In the old scanner's precedence order
+		const BlockType blockTypes[] =
+		{
+			{ "ENTITY_SPAWN_DATA_BEGIN", "ENTITY_SPAWN_DATA_END", &textBlocks.entitySpawnTextBlocks },
+			{ "COMPONENT_SPAWN_DATA_BEGIN", "COMPONENT_SPAWN_DATA_END", &textBlocks.componentSpawnTextBlocks },
+			{ "ENTITY_BEGIN", "ENTITY_END", &textBlocks.entityTextBlocks },
+			{ "STATIC_ENTITY_BEGIN", "STATIC_ENTITY_END", &textBlocks.staticEntityTextBlocks },
+			{ "ENTITY_COMPONENT_BEGIN", "ENTITY_COMPONENT_END", &textBlocks.componentTextBlocks },
+		};
+
+		std::vector<std::string> lines;
+		ion::string::Tokenise(contents, lines, std::vector<char>({ '\r', '\n' }));
+
+		const BlockType* currentType = nullptr;
+		bool inMacroBlock = false;
+		EntityParser::TextBlock currentBlock;
+
+		for (int i = 0; i < lines.size(); i++)
+		{
+			std::vector<std::string> words;
+			ion::string::Tokenise(lines[i], words, std::vector<char>({ ' ', ',', '\t' }));
+
+			if (words.size() == 0 || words[0][0] == ';')
+				continue;
+
+			if (inMacroBlock)
+			{
+				inMacroBlock = ReferenceContainsToken(words, "endm") < 0;
+			}
+			else if (ReferenceContainsToken(words, "macro") >= 0)
+			{
+				inMacroBlock = true;
+			}
+			else if (currentType)
+			{
+				if (ReferenceContainsToken(words, currentType->end) >= 0)
+				{
+					currentType->blocks->push_back(currentBlock);
+					currentBlock = EntityParser::TextBlock();
+					currentType = nullptr;
+				}
+				else
+				{
+					currentBlock.block.push_back(words);
+				}
+			}
+			else
+			{
+				for (int j = 0; j < sizeof(blockTypes) / sizeof(blockTypes[0]) && !currentType; j++)
+				{
+					if (ReferenceContainsToken(words, blockTypes[j].begin) >= 0)
+					{
+						currentBlock.name = (words.size() >= 2) ? words[1] : "";
+						currentType = &blockTypes[j];
+					}
+				}
+			}
+		}
+	}
+
+	static bool TextBlocksEqual(const std::vector<EntityParser::TextBlock>& a, const std::vector<EntityParser::TextBlock>& b)
+	{
+		if (a.size() != b.size())
+			return false;
+
+		for (int i = 0; i < a.size(); i++)
+		{
+			if (a[i].name != b[i].name || a[i].block != b[i].block)
+				return false;
+		}
+
+		return true;
+	}
+
+	LUMINARY_BENCHMARK(EntityParser_FindTextBlocks)
+	{
+		//The framework's own entity sources, already in memory so only scanning is timed
+		std::vector<std::string> contents;
+
+		for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(test::GetRootDir() + "/FRAMEWK/ENTITIES"))
+		{
+			if (EntityParser::IsASMFile(entry.path().filename().string()))
+			{
+				contents.push_back(test::ReadTextFile(entry.path().string()));
+			}
+		}
+
+		TEST_CHECK(contents.size() > 0);
+
+		size_t numBytes = 0;
+		int numBlocks = 0;
+
+		for (int i = 0; i < contents.size(); i++)
+		{
+			EntityParser::FileTextBlocks reference;
+			EntityParser::FileTextBlocks scanned;
+			ReferenceFindTextBlocks(contents[i], reference);
+			EntityParser::FindTextBlocks(contents[i], scanned);
+
+			TEST_CHECK(TextBlocksEqual(reference.entityTextBlocks, scanned.entityTextBlocks));
+			TEST_CHECK(TextBlocksEqual(reference.staticEntityTextBlocks, scanned.staticEntityTextBlocks));
+			TEST_CHECK(TextBlocksEqual(reference.entitySpawnTextBlocks, scanned.entitySpawnTextBlocks));
+			TEST_CHECK(TextBlocksEqual(reference.componentTextBlocks, scanned.componentTextBlocks));
+			TEST_CHECK(TextBlocksEqual(reference.componentSpawnTextBlocks, scanned.componentSpawnTextBlocks));
+
+			numBytes += contents[i].size();
+			numBlocks += (int)(scanned.entityTextBlocks.size() + scanned.staticEntityTextBlocks.size() + scanned.entitySpawnTextBlocks.size() + scanned.componentTextBlocks.size() + scanned.componentSpawnTextBlocks.size());
+		}
+
+		const int numIterations = 200;
+
+		double startTime = test::GetTimeMs();
+
+		for (int iteration = 0; iteration < numIterations; iteration++)
+		{
+			for (int i = 0; i < contents.size(); i++)
+			{
+				EntityParser::FileTextBlocks textBlocks;
+				ReferenceFindTextBlocks(contents[i], textBlocks);
+			}
+		}
+
+		double referenceTime = test::GetTimeMs() - startTime;
+		startTime = test::GetTimeMs();
+
+		for (int iteration = 0; iteration < numIterations; iteration++)
+		{
+			for (int i = 0; i < contents.size(); i++)
+			{
+				EntityParser::FileTextBlocks textBlocks;
+				EntityParser::FindTextBlocks(contents[i], textBlocks);
+			}
+		}
+
+		double scanTime = test::GetTimeMs() - startTime;
+
+		printf("    %d files, %d KB, %d blocks, x%d\n", (int)contents.size(), (int)(numBytes / 1024), numBlocks, numIterations);
+		printf("    line/word split scanner: %.1f ms\n", referenceTime);
+		printf("    single pass scanner:     %.1f ms (%.1fx)\n", scanTime, referenceTime / scanTime);
+	}
+
+	static std::string MakeBenchmarkEntityFile(int index)
+	{
+		std::string name = std::to_string(index);
+		return
+			"    COMPONENT_SPAWN_DATA_BEGIN ECBench" + name + "\n"
+			"SDBench" + name + "_Value                  rs.w 1\n"
+			"    COMPONENT_SPAWN_DATA_END\n"
+			"\n"
+			"    ENTITY_COMPONENT_BEGIN ECBench" + name + "\n"
+			"ECBench" + name + "_State                  rs.w 1\n"
+			"ECBench" + name + "_Timer                  rs.l 1\n"
+			"    ENTITY_COMPONENT_END\n"
+			"\n"
+			"    ENTITY_SPAWN_DATA_BEGIN EBench" + name + "\n"
+			"SDEBench" + name + "_Speed                 rs.w 1\n"
+			"    ENTITY_SPAWN_DATA_END\n"
+			"\n"
+			"    ENTITY_BEGIN EBench" + name + "\n"
+			"EBench" + name + "_Value                   rs.w 1\n"
+			"EBench" + name + "_Flags                   rs.b 1\n"
+			"    ENT_COMPONENT ECBench" + name + "\n"
+			"    ENTITY_END\n";
+	}
+
+	static double TimeParse(const std::vector<std::string>& directories, int expectedEntities)
+	{
+		//Best of several runs, each from a fresh parser so nothing is cached
+		double bestTime = 0.0;
+
+		for (int run = 0; run < 3; run++)
+		{
+			EntityParser parser;
+			std::vector<Entity> entities;
+
+			double startTime = test::GetTimeMs();
+			bool parsed = parser.ParseDirectories(directories, entities);
+			double time = test::GetTimeMs() - startTime;
+
+			if (!parsed || entities.size() != expectedEntities)
+			{
+				test::Fail(__FILE__, __LINE__, "Unexpected parse result");
+				return 0.0;
+			}
+
+			if (run == 0 || time < bestTime)
+			{
+				bestTime = time;
+			}
+		}
+
+		return bestTime;
+	}
+
+	LUMINARY_BENCHMARK(EntityParser_ParseTimeIsLinear)
+	{
+		//N files, then the same N plus N more in a second directory
+		const int numFiles = 1000;
+
+		std::string root = test::MakeTempDir("EntityParser_ParseTimeIsLinear");
+		std::string firstDir = root + "/FIRST";
+		std::string secondDir = root + "/SECOND";
+
+		for (int i = 0; i < numFiles; i++)
+		{
+			test::WriteTextFile(firstDir + "/E" + std::to_string(i) + ".ASM", MakeBenchmarkEntityFile(i));
+			test::WriteTextFile(secondDir + "/E" + std::to_string(i) + ".ASM", MakeBenchmarkEntityFile(numFiles + i));
+		}
+
+		double singleTime = TimeParse({ firstDir }, numFiles);
+		double doubleTime = TimeParse({ firstDir, secondDir }, numFiles * 2);
+
+		printf("    %d files: %.1f ms\n", numFiles, singleTime);
+		printf("    %d files: %.1f ms\n", numFiles * 2, doubleTime);
+		printf("    ratio: %.2f (2.0 = linear)\n", doubleTime / singleTime);
+	}
+}
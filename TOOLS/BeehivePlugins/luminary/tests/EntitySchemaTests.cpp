@@ -0,0 +1,67 @@
+// ============================================================================================
+// LUMINARY - a game engine and framework for the SEGA Mega Drive
+// ============================================================================================
+// Matt Phillips - Big Evil Corporation Ltd - 17th October 2026
+// ============================================================================================
+// EntitySchemaTests.cpp - EntitySchema tests
+// ============================================================================================
+
+#include "Test.h"
+
+#include "../EntitySchema.h"
+
+#include <filesystem>
+#include <thread>
+
+namespace luminary
+{
+	static const char* s_entityFileA =
+		"    ENTITY_BEGIN ETestA\n"
+		"ETestA_Value                            rs.w 1\n"
+		"    ENTITY_END\n";
+
+	static const char* s_entityFileB =
+		"    ENTITY_BEGIN ETestB\n"
+		"ETestB_Value                            rs.w 1\n"
+		"    ENTITY_END\n";
+
+	static void WaitForSettle()
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(EntitySchema::s_settleTimeMs * 2));
+	}
+
+	LUMINARY_TEST(EntitySchema_RebuildsOnASMChangesOnly)
+	{
+#if defined(__linux__)
+		std::string root = test::MakeTempDir("EntitySchema_RebuildsOnASMChangesOnly");
+		test::WriteTextFile(root + "/ETESTA.ASM", s_entityFileA);
+
+		EntitySchema schema;
+		TEST_CHECK(schema.Open({ root }));
+		TEST_CHECK_EQUAL(schema.GetEntities().size(), 1);
+
+		//Swap files, other extensions and new empty directories don't rebuild
+		test::WriteTextFile(root + "/.ETESTA.ASM.swp", "swap");
+		test::WriteTextFile(root + "/NOTES.TXT", "notes");
+		std::filesystem::create_directories(root + "/EMPTY");
+		WaitForSettle();
+		TEST_CHECK(!schema.Update());
+
+		//A burst of ASM writes rebuilds once, after it settles
+		test::WriteTextFile(root + "/ETESTB.ASM", s_entityFileA);
+		test::WriteTextFile(root + "/ETESTB.ASM", s_entityFileB);
+		TEST_CHECK(!schema.Update());
+		WaitForSettle();
+		TEST_CHECK(schema.Update());
+		TEST_CHECK(!schema.Update());
+		TEST_CHECK_EQUAL(schema.GetEntities().size(), 2);
+
+		//Closed schema serves nothing
+		schema.Close();
+		TEST_CHECK_EQUAL(schema.GetEntities().size(), 0);
+		TEST_CHECK_EQUAL(schema.GetComponents().size(), 0);
+#else
+		test::Skip("change notifications are only watched on Linux");
+#endif
+	}
+}
@@ -0,0 +1,1084 @@
+// ============================================================================================
+// LUMINARY - a game engine and framework for the SEGA Mega Drive
+// ============================================================================================
+// Matt Phillips - Big Evil Corporation Ltd - 17th October 2026
+// ============================================================================================
+// MapStreamTests.cpp - Streams exported stamp maps through the engine's streaming loops
+// ============================================================================================
+
+#include "Test.h"
+
+#include "../MapExporter.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <map>
+#include <sstream>
+
+namespace luminary
+{
+	//Runs MAP_UpdateStreamingPlane's row and column loops, read from the engine source with its macros
+	//and constants, on a minimal 68000 interpreter covering only the instructions they use. This checks
+	//the streamer against the exporter's map format, it doesn't check asm68k accepts the source.
+	namespace asm68k
+	{
+		static std::string Trim(const std::string& string)
+		{
+			size_t start = string.find_first_not_of(" \t\r\n");
+			size_t end = string.find_last_not_of(" \t\r\n");
+			return (start == std::string::npos) ? "" : string.substr(start, end - start + 1);
+		}
+
+		static std::string ToLower(std::string string)
+		{
+			std::transform(string.begin(), string.end(), string.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+			return string;
+		}
+
+		//Lines with comments and surrounding whitespace stripped
+		static std::vector<std::string> ReadLines(const std::string& filename)
+		{
+			std::vector<std::string> lines;
+			std::stringstream stream(test::ReadTextFile(filename));
+			std::string line;
+
+			while (std::getline(stream, line))
+			{
+				lines.push_back(Trim(line.substr(0, line.find(';'))));
+			}
+
+			return lines;
+		}
+
+		//Splits on commas outside of parentheses
+		static std::vector<std::string> SplitOperands(const std::string& string)
+		{
+			std::vector<std::string> operands;
+			std::string operand;
+			int depth = 0;
+
+			for (int i = 0; i < string.size(); i++)
+			{
+				if (string[i] == '(')
+					depth++;
+				else if (string[i] == ')')
+					depth--;
+
+				if (string[i] == ',' && depth == 0)
+				{
+					operands.push_back(Trim(operand));
+					operand.clear();
+				}
+				else
+				{
+					operand += string[i];
+				}
+			}
+
+			if (Trim(operand).size() > 0)
+				operands.push_back(Trim(operand));
+
+			return operands;
+		}
+
+		static void Replace(std::string& string, const std::string& from, const std::string& to)
+		{
+			for (size_t pos = string.find(from); pos != std::string::npos; pos = string.find(from, pos + to.size()))
+			{
+				string.replace(pos, from.size(), to);
+			}
+		}
+
+		struct Instruction
+		{
+			std::string mnemonic;
+			char size;
+			std::vector<std::string> operands;
+			std::string source;
+		};
+
+		//Equates, macros and a range of code with macros expanded
+		class Source
+		{
+		public:
+			bool LoadConstants(const std::string& filename)
+			{
+				std::vector<std::string> lines = ReadLines(filename);
+
+				for (int i = 0; i < lines.size(); i++)
+				{
+					std::stringstream stream(lines[i]);
+					std::string name;
+					std::string directive;
+					std::string expression;
+					stream >> name >> directive;
+					std::getline(stream, expression);
+
+					if (ToLower(directive) == "equ")
+					{
+						m_constants[name] = Trim(expression);
+					}
+				}
+
+				return lines.size() > 0;
+			}
+
+			bool LoadMacros(const std::string& filename)
+			{
+				std::vector<std::string> lines = ReadLines(filename);
+
+				for (int i = 0; i < lines.size(); i++)
+				{
+					std::stringstream stream(lines[i]);
+					std::string name;
+					std::string directive;
+					std::string params;
+					stream >> name >> directive;
+					std::getline(stream, params);
+
+					if (ToLower(directive) == "macro")
+					{
+						if (name.back() == ':')
+							name.pop_back();
+
+						Macro& macro = m_macros[name];
+						macro.params = SplitOperands(params);
+						macro.lines.clear();
+
+						for (i++; i < lines.size() && ToLower(lines[i]) != "endm"; i++)
+						{
+							macro.lines.push_back(lines[i]);
+						}
+					}
+				}
+
+				return lines.size() > 0;
+			}
+
+			//Expands the lines from startLabel up to endLabel, which is left pointing past the end
+			bool LoadCode(const std::string& filename, const std::string& startLabel, const std::string& endLabel)
+			{
+				std::vector<std::string> lines = ReadLines(filename);
+				bool inRange = false;
+				bool foundEnd = false;
+
+				for (int i = 0; i < lines.size() && !foundEnd; i++)
+				{
+					if (lines[i] == startLabel + ":")
+						inRange = true;
+
+					if (inRange && lines[i] == endLabel + ":")
+						foundEnd = true;
+					else if (inRange && !AddLine(lines[i]))
+						return false;
+				}
+
+				m_labels[endLabel] = (int)m_code.size();
+				return foundEnd;
+			}
+
+			s64 Evaluate(const std::string& expression)
+			{
+				size_t pos = 0;
+				s64 value = ParseOr(expression, pos);
+				SkipSpaces(expression, pos);
+
+				if (pos != expression.size())
+					m_error = "Can't evaluate '" + expression + "'";
+
+				return value;
+			}
+
+			int FindLabel(const std::string& label) const
+			{
+				std::map<std::string, int>::const_iterator it = m_labels.find(label);
+				return (it != m_labels.end()) ? it->second : -1;
+			}
+
+			const std::vector<Instruction>& GetCode() const { return m_code; }
+			const std::string& GetError() const { return m_error; }
+
+		private:
+			struct Macro
+			{
+				std::vector<std::string> params;
+				std::vector<std::string> lines;
+			};
+
+			bool AddLine(const std::string& line)
+			{
+				if (line.empty())
+					return true;
+
+				std::string op = line.substr(0, line.find_first_of(" \t"));
+				std::string operands = Trim(line.substr(op.size()));
+
+				if (op.back() == ':')
+				{
+					m_labels[op.substr(0, op.size() - 1)] = (int)m_code.size();
+					return AddLine(operands);
+				}
+
+				std::map<std::string, Macro>::const_iterator macroIt = m_macros.find(op);
+				if (macroIt != m_macros.end())
+				{
+					const Macro& macro = macroIt->second;
+					std::vector<std::string> args = SplitOperands(operands);
+
+					if (args.size() != macro.params.size())
+					{
+						m_error = "Wrong arg count for macro: " + line;
+						return false;
+					}
+
+					//Longest param first, so none substitutes into another sharing its prefix
+					std::vector<int> paramOrder;
+					for (int i = 0; i < macro.params.size(); i++)
+						paramOrder.push_back(i);
+
+					std::sort(paramOrder.begin(), paramOrder.end(), [&](int a, int b) { return macro.params[a].size() > macro.params[b].size(); });
+
+					std::string uniqueSuffix = "_" + std::to_string(m_macroCount++);
+
+					for (int i = 0; i < macro.lines.size(); i++)
+					{
+						std::string expanded = macro.lines[i];
+						Replace(expanded, "\\@", uniqueSuffix);
+
+						for (int j = 0; j < paramOrder.size(); j++)
+							Replace(expanded, "\\" + macro.params[paramOrder[j]], args[paramOrder[j]]);
+
+						if (!AddLine(expanded))
+							return false;
+					}
+
+					return true;
+				}
+
+				Instruction instruction;
+				instruction.source = line;
+				instruction.mnemonic = ToLower(op);
+				instruction.size = 0;
+				instruction.operands = SplitOperands(operands);
+
+				size_t dotPos = instruction.mnemonic.find('.');
+				if (dotPos != std::string::npos)
+				{
+					instruction.size = instruction.mnemonic[dotPos + 1];
+					instruction.mnemonic = instruction.mnemonic.substr(0, dotPos);
+				}
+
+				m_code.push_back(instruction);
+				return true;
+			}
+
+			s64 ParseOr(const std::string& expr, size_t& pos)
+			{
+				s64 value = ParseAnd(expr, pos);
+				while (Accept(expr, pos, "|"))
+					value |= ParseAnd(expr, pos);
+				return value;
+			}
+
+			s64 ParseAnd(const std::string& expr, size_t& pos)
+			{
+				s64 value = ParseShift(expr, pos);
+				while (Accept(expr, pos, "&"))
+					value &= ParseShift(expr, pos);
+				return value;
+			}
+
+			s64 ParseShift(const std::string& expr, size_t& pos)
+			{
+				s64 value = ParseSum(expr, pos);
+
+				for (;;)
+				{
+					if (Accept(expr, pos, "<<"))
+						value <<= ParseSum(expr, pos);
+					else if (Accept(expr, pos, ">>"))
+						value >>= ParseSum(expr, pos);
+					else
+						return value;
+				}
+			}
+
+			s64 ParseSum(const std::string& expr, size_t& pos)
+			{
+				s64 value = ParseProduct(expr, pos);
+
+				for (;;)
+				{
+					if (Accept(expr, pos, "+"))
+						value += ParseProduct(expr, pos);
+					else if (Accept(expr, pos, "-"))
+						value -= ParseProduct(expr, pos);
+					else
+						return value;
+				}
+			}
+
+			s64 ParseProduct(const std::string& expr, size_t& pos)
+			{
+				s64 value = ParseUnary(expr, pos);
+
+				for (;;)
+				{
+					if (Accept(expr, pos, "*"))
+					{
+						value *= ParseUnary(expr, pos);
+					}
+					else if (Accept(expr, pos, "/"))
+					{
+						s64 divisor = ParseUnary(expr, pos);
+						value = divisor ? (value / divisor) : 0;
+					}
+					else
+					{
+						return value;
+					}
+				}
+			}
+
+			s64 ParseUnary(const std::string& expr, size_t& pos)
+			{
+				if (Accept(expr, pos, "-"))
+					return -ParseUnary(expr, pos);
+
+				if (Accept(expr, pos, "("))
+				{
+					s64 value = ParseOr(expr, pos);
+
+					if (!Accept(expr, pos, ")"))
+						m_error = "Unbalanced parentheses in '" + expr + "'";
+
+					return value;
+				}
+
+				SkipSpaces(expr, pos);
+				size_t start = pos;
+				while (pos < expr.size() && (std::isalnum((unsigned char)expr[pos]) || expr[pos] == '_' || expr[pos] == '$'))
+					pos++;
+
+				std::string token = expr.substr(start, pos - start);
+
+				if (token.empty())
+				{
+					m_error = "Can't evaluate '" + expr + "'";
+					return 0;
+				}
+
+				if (token[0] == '$')
+					return (s64)std::stoull(token.substr(1), nullptr, 16);
+
+				if (std::isdigit((unsigned char)token[0]))
+					return (s64)std::stoull(token, nullptr, 0);
+
+				std::map<std::string, std::string>::const_iterator it = m_constants.find(token);
+				if (it == m_constants.end())
+				{
+					m_error = "Unknown constant '" + token + "'";
+					return 0;
+				}
+
+				return Evaluate(it->second);
+			}
+
+			static void SkipSpaces(const std::string& expr, size_t& pos)
+			{
+				while (pos < expr.size() && std::isspace((unsigned char)expr[pos]))
+					pos++;
+			}
+
+			static bool Accept(const std::string& expr, size_t& pos, const char* token)
+			{
+				SkipSpaces(expr, pos);
+				size_t length = strlen(token);
+
+				if (expr.compare(pos, length, token) == 0)
+				{
+					pos += length;
+					return true;
+				}
+
+				return false;
+			}
+
+			std::map<std::string, std::string> m_constants;
+			std::map<std::string, Macro> m_macros;
+			std::map<std::string, int> m_labels;
+			std::vector<Instruction> m_code;
+			std::string m_error;
+			int m_macroCount = 0;
+		};
+
+		class Cpu
+		{
+		public:
+			static const u32 s_memorySize = 0x10000;
+			static const u32 s_vdpDataPort = 0xC00000;
+			static const u32 s_vdpControlPort = 0xC00004;
+
+			Cpu(Source& source)
+				: m_source(source)
+				, m_memory(s_memorySize, 0)
+			{
+				memset(d, 0, sizeof(d));
+				memset(a, 0, sizeof(a));
+			}
+
+			void WriteMemory(u32 address, u32 value, int bytes)
+			{
+				if (address == s_vdpDataPort && bytes == 2)
+				{
+					vdpData.push_back((u16)value);
+				}
+				else if (address == s_vdpControlPort && bytes == 4)
+				{
+					vdpControl = value;
+				}
+				else if (address + bytes > s_memorySize)
+				{
+					SetError("Write out of range");
+				}
+				else
+				{
+					for (int i = 0; i < bytes; i++)
+						m_memory[address + i] = (u8)(value >> ((bytes - 1 - i) * 8));
+				}
+			}
+
+			u32 ReadMemory(u32 address, int bytes)
+			{
+				u32 value = 0;
+
+				if (address + bytes > s_memorySize || (bytes > 1 && (address & 1)))
+				{
+					SetError("Read out of range or unaligned");
+					return 0;
+				}
+
+				for (int i = 0; i < bytes; i++)
+					value = (value << 8) | m_memory[address + i];
+
+				return value;
+			}
+
+			//Runs from startLabel until reaching endLabel
+			bool Run(const std::string& startLabel, const std::string& endLabel)
+			{
+				const std::vector<Instruction>& code = m_source.GetCode();
+				int endPc = m_source.FindLabel(endLabel);
+				m_pc = m_source.FindLabel(startLabel);
+
+				for (int steps = 0; m_error.empty() && m_pc != endPc; steps++)
+				{
+					if (m_pc < 0 || m_pc >= code.size() || steps > s_maxSteps)
+					{
+						SetError("Ran off the end of the code");
+						break;
+					}
+
+					const Instruction& instruction = code[m_pc++];
+					executed[instruction.mnemonic]++;
+					Execute(instruction);
+
+					if (!m_error.empty())
+						m_error += ": " + instruction.source;
+				}
+
+				return m_error.empty();
+			}
+
+			const std::string& GetError() const { return m_error; }
+
+			u32 d[8];
+			u32 a[8];
+			std::vector<u16> vdpData;
+			u32 vdpControl = 0;
+			std::map<std::string, int> executed;
+
+		private:
+			static const int s_maxSteps = 1000000;
+
+			struct Operand
+			{
+				enum Mode { eDataReg, eAddrReg, eIndirect, eIndexed, eImmediate };
+
+				Mode mode;
+				int reg;
+				int indexReg;
+				bool indexIsAddr;
+				bool indexIsLong;
+				u32 value;
+			};
+
+			static int RegNum(const std::string& name, char type)
+			{
+				if (name == "sp" && type == 'a')
+					return 7;
+
+				if (name.size() == 2 && name[0] == type && name[1] >= '0' && name[1] <= '7')
+					return name[1] - '0';
+
+				return -1;
+			}
+
+			Operand ParseOperand(const std::string& text)
+			{
+				std::string lower = ToLower(text);
+				Operand operand;
+				operand.reg = -1;
+				operand.indexReg = -1;
+				operand.indexIsAddr = false;
+				operand.indexIsLong = false;
+				operand.value = 0;
+
+				if (lower[0] == '#')
+				{
+					operand.mode = Operand::eImmediate;
+					operand.value = (u32)m_source.Evaluate(text.substr(1));
+
+					if (!m_source.GetError().empty())
+						SetError(m_source.GetError());
+				}
+				else if ((operand.reg = RegNum(lower, 'd')) >= 0)
+				{
+					operand.mode = Operand::eDataReg;
+				}
+				else if ((operand.reg = RegNum(lower, 'a')) >= 0)
+				{
+					operand.mode = Operand::eAddrReg;
+				}
+				else if (lower.find('(') != std::string::npos && lower.back() == ')')
+				{
+					size_t open = lower.find('(');
+					std::vector<std::string> parts = SplitOperands(lower.substr(open + 1, lower.size() - open - 2));
+					operand.value = (open > 0) ? (u32)m_source.Evaluate(text.substr(0, open)) : 0;
+					operand.reg = (parts.size() > 0) ? RegNum(parts[0], 'a') : -1;
+					operand.mode = (parts.size() > 1 || open > 0) ? Operand::eIndexed : Operand::eIndirect;
+
+					if (parts.size() > 1)
+					{
+						std::string index = parts[1];
+						operand.indexIsLong = index.size() > 2 && index.substr(index.size() - 2) == ".l";
+						index = index.substr(0, 2);
+						operand.indexIsAddr = (index[0] == 'a');
+						operand.indexReg = RegNum(index, index[0]);
+					}
+
+					if (operand.reg < 0 || parts.size() > 2 || (parts.size() > 1 && operand.indexReg < 0))
+						SetError("Unsupported addressing mode");
+				}
+				else
+				{
+					SetError("Unsupported operand");
+				}
+
+				return operand;
+			}
+
+			static u32 Mask(int bytes)
+			{
+				return (bytes == 4) ? 0xFFFFFFFF : ((1u << (bytes * 8)) - 1);
+			}
+
+			static u32 SignExtend(u32 value, int bytes)
+			{
+				return (bytes == 1) ? (u32)(s32)(s8)value : (bytes == 2) ? (u32)(s32)(s16)value : value;
+			}
+
+			u32 GetAddress(const Operand& operand)
+			{
+				u32 address = a[operand.reg] + operand.value;
+
+				if (operand.indexReg >= 0)
+				{
+					u32 index = operand.indexIsAddr ? a[operand.indexReg] : d[operand.indexReg];
+					address += operand.indexIsLong ? index : SignExtend(index, 2);
+				}
+
+				return address & 0x00FFFFFF;
+			}
+
+			u32 Read(const Operand& operand, int bytes)
+			{
+				switch (operand.mode)
+				{
+				case Operand::eDataReg:
+					return d[operand.reg] & Mask(bytes);
+				case Operand::eAddrReg:
+					return a[operand.reg] & Mask(bytes);
+				case Operand::eImmediate:
+					return operand.value & Mask(bytes);
+				default:
+					return ReadMemory(GetAddress(operand), bytes);
+				}
+			}
+
+			//Address registers take the whole register, sign extended from a word
+			void Write(const Operand& operand, u32 value, int bytes)
+			{
+				switch (operand.mode)
+				{
+				case Operand::eDataReg:
+					d[operand.reg] = (d[operand.reg] & ~Mask(bytes)) | (value & Mask(bytes));
+					break;
+				case Operand::eAddrReg:
+					a[operand.reg] = SignExtend(value, bytes);
+					break;
+				case Operand::eImmediate:
+					SetError("Write to immediate");
+					break;
+				default:
+					WriteMemory(GetAddress(operand), value, bytes);
+					break;
+				}
+			}
+
+			void SetNZ(u32 value, int bytes)
+			{
+				value &= Mask(bytes);
+				m_n = (value >> (bytes * 8 - 1)) & 1;
+				m_z = (value == 0);
+			}
+
+			void SetLogicFlags(u32 value, int bytes)
+			{
+				SetNZ(value, bytes);
+				m_v = false;
+				m_c = false;
+			}
+
+			bool TestCondition(const std::string& condition) const
+			{
+				if (condition == "ra") return true;
+				if (condition == "eq") return m_z;
+				if (condition == "ne") return !m_z;
+				if (condition == "mi") return m_n;
+				if (condition == "pl") return !m_n;
+				if (condition == "cs" || condition == "lo") return m_c;
+				if (condition == "cc" || condition == "hs") return !m_c;
+				if (condition == "hi") return !m_c && !m_z;
+				if (condition == "ls") return m_c || m_z;
+				if (condition == "vs") return m_v;
+				if (condition == "vc") return !m_v;
+				if (condition == "ge") return m_n == m_v;
+				if (condition == "lt") return m_n != m_v;
+				if (condition == "gt") return !m_z && (m_n == m_v);
+				if (condition == "le") return m_z || (m_n != m_v);
+				return false;
+			}
+
+			void Branch(const std::string& label)
+			{
+				m_pc = m_source.FindLabel(label);
+
+				if (m_pc < 0)
+					SetError("Unknown label '" + label + "'");
+			}
+
+			void SetError(const std::string& error)
+			{
+				if (m_error.empty())
+					m_error = error;
+			}
+
+			void Execute(const Instruction& instruction)
+			{
+				const std::string& mnemonic = instruction.mnemonic;
+				const std::vector<std::string>& operands = instruction.operands;
+				int bytes = (instruction.size == 'b') ? 1 : (instruction.size == 'l') ? 4 : 2;
+
+				if (mnemonic == "dbra" || mnemonic == "dbf")
+				{
+					int reg = RegNum(ToLower(operands[0]), 'd');
+					u16 counter = (u16)(d[reg] - 1);
+					d[reg] = (d[reg] & 0xFFFF0000) | counter;
+
+					if (counter != 0xFFFF)
+						Branch(operands[1]);
+
+					return;
+				}
+
+				if (mnemonic[0] == 'b' && mnemonic.size() == 3)
+				{
+					if (TestCondition(mnemonic.substr(1)))
+						Branch(operands[0]);
+
+					return;
+				}
+
+				if (mnemonic == "swap")
+				{
+					Operand reg = ParseOperand(operands[0]);
+					d[reg.reg] = (d[reg.reg] << 16) | (d[reg.reg] >> 16);
+					SetLogicFlags(d[reg.reg], 4);
+					return;
+				}
+
+				if (mnemonic == "tst")
+				{
+					SetLogicFlags(Read(ParseOperand(operands[0]), bytes), bytes);
+					return;
+				}
+
+				if (operands.size() != 2)
+				{
+					SetError("Unsupported instruction");
+					return;
+				}
+
+				Operand src = ParseOperand(operands[0]);
+				Operand dst = ParseOperand(operands[1]);
+
+				if (!m_error.empty())
+					return;
+
+				if (mnemonic == "moveq")
+				{
+					d[dst.reg] = SignExtend(src.value, 1);
+					SetLogicFlags(d[dst.reg], 4);
+				}
+				else if (mnemonic == "move" || mnemonic == "movea")
+				{
+					u32 value = Read(src, bytes);
+					Write(dst, value, bytes);
+
+					if (dst.mode != Operand::eAddrReg)
+						SetLogicFlags(value, bytes);
+				}
+				else if (mnemonic == "btst")
+				{
+					//Long on registers, byte in memory
+					int bitBytes = (dst.mode == Operand::eDataReg) ? 4 : 1;
+					m_z = ((Read(dst, bitBytes) >> (Read(src, 4) & (bitBytes * 8 - 1))) & 1) == 0;
+				}
+				else if (mnemonic == "mulu")
+				{
+					d[dst.reg] = (d[dst.reg] & 0xFFFF) * Read(src, 2);
+					SetLogicFlags(d[dst.reg], 4);
+				}
+				else if (mnemonic == "lsl" || mnemonic == "lsr")
+				{
+					u32 count = Read(src, 4) & 63;
+					u64 value = Read(dst, bytes);
+					u64 result = (mnemonic == "lsl") ? (value << count) : (value >> count);
+					Write(dst, (u32)result, bytes);
+					SetLogicFlags((u32)result, bytes);
+
+					if (count > 0)
+						m_c = (mnemonic == "lsl") ? ((value >> (bytes * 8 - count)) & 1) : ((value >> (count - 1)) & 1);
+				}
+				else if (dst.mode == Operand::eAddrReg && (mnemonic == "add" || mnemonic == "adda" || mnemonic == "sub" || mnemonic == "suba"))
+				{
+					//Whole register, word sources sign extended, flags untouched
+					u32 value = SignExtend(Read(src, bytes), bytes);
+					a[dst.reg] = (mnemonic[0] == 'a') ? (a[dst.reg] + value) : (a[dst.reg] - value);
+				}
+				else if (mnemonic == "add" || mnemonic == "addi" || mnemonic == "addq")
+				{
+					u32 mask = Mask(bytes);
+					u32 srcValue = Read(src, bytes);
+					u32 dstValue = Read(dst, bytes);
+					u32 result = (srcValue + dstValue) & mask;
+					u32 signBit = 1u << (bytes * 8 - 1);
+					Write(dst, result, bytes);
+					SetNZ(result, bytes);
+					m_c = ((u64)srcValue + dstValue) > mask;
+					m_v = ((srcValue ^ result) & (dstValue ^ result) & signBit) != 0;
+				}
+				else if (mnemonic == "sub" || mnemonic == "subi" || mnemonic == "subq" || mnemonic == "cmp" || mnemonic == "cmpi")
+				{
+					u32 srcValue = Read(src, bytes);
+					u32 dstValue = Read(dst, bytes);
+					u32 result = (dstValue - srcValue) & Mask(bytes);
+					u32 signBit = 1u << (bytes * 8 - 1);
+
+					if (mnemonic[0] == 's')
+						Write(dst, result, bytes);
+
+					SetNZ(result, bytes);
+					m_c = srcValue > dstValue;
+					m_v = ((dstValue ^ srcValue) & (dstValue ^ result) & signBit) != 0;
+				}
+				else if (mnemonic == "and" || mnemonic == "andi" || mnemonic == "or" || mnemonic == "ori" || mnemonic == "eor" || mnemonic == "eori")
+				{
+					u32 srcValue = Read(src, bytes);
+					u32 dstValue = Read(dst, bytes);
+					u32 result = (mnemonic[0] == 'a') ? (dstValue & srcValue) : (mnemonic[0] == 'o') ? (dstValue | srcValue) : (dstValue ^ srcValue);
+					Write(dst, result, bytes);
+					SetLogicFlags(result, bytes);
+				}
+				else
+				{
+					SetError("Unsupported instruction");
+				}
+			}
+
+			Source& m_source;
+			std::vector<u8> m_memory;
+			std::string m_error;
+			int m_pc = 0;
+			bool m_n = false;
+			bool m_z = false;
+			bool m_v = false;
+			bool m_c = false;
+		};
+	}
+
+	//Test map layout in memory
+	static const u32 s_stampMapAddr = 0x0100;
+	static const u32 s_stampDataAddr = 0x1000;
+	static const u32 s_vramTileBase = 0x0020;
+	static const u32 s_vdpWriteCommand = 0x40000003;
+
+	static const int s_mapWidthStamps = 4;
+	static const int s_mapHeightStamps = 2;
+
+	//Unique stamp tile words, varied index, flips, palette and priority
+	static u16 GetUniqueTile(int uniqueStamp, int x, int y, int width, int height)
+	{
+		u16 index = (u16)(((uniqueStamp * width * height) + (y * width) + x) & 0x07FF);
+		u16 flipX = ((x + y) % 3 == 0) ? 0x0800 : 0;
+		u16 flipY = ((x * y) % 5 == 1) ? 0x1000 : 0;
+		u16 palette = (u16)(((uniqueStamp + x) & 3) << 13);
+		u16 prio = (y % 7 == 0) ? 0x8000 : 0;
+		return index | flipX | flipY | palette | prio;
+	}
+
+	//Stamps as the artist placed them, 2 and 3 are flipped duplicates of the two unique stamps
+	static u16 GetOriginalTile(int stamp, int x, int y, int width, int height)
+	{
+		switch (stamp)
+		{
+		case 0:
+			return GetUniqueTile(0, x, y, width, height);
+		case 1:
+			return GetUniqueTile(1, x, y, width, height);
+		case 2:
+			return GetUniqueTile(0, width - 1 - x, y, width, height) ^ 0x0800;
+		default:
+			return GetUniqueTile(1, width - 1 - x, height - 1 - y, width, height) ^ 0x1800;
+		}
+	}
+
+	struct PlacedStamp
+	{
+		StampId stamp;
+		u16 flags;
+	};
+
+	//Mixes unflagged, flipped, high plane and remapped stamps, including a flipped duplicate placed
+	//flipped back so its exported longword has no flags
+	static const PlacedStamp s_testMap[s_mapHeightStamps][s_mapWidthStamps] =
+	{
+		{ { 0, 0 }, { 2, Map::eFlipX }, { 0, Map::eFlipY | Map::eHighPlane }, { 3, Map::eFlipX } },
+		{ { 1, Map::eFlipX | Map::eFlipY }, { 2, 0 }, { 1, Map::eHighPlane }, { 3, Map::eFlipX | Map::eFlipY } },
+	};
+
+	//What the VDP should receive for a map tile, from the stamps as placed
+	static u16 GetExpectedTile(int x, int y, int width, int height)
+	{
+		const PlacedStamp& placed = s_testMap[y / height][x / width];
+		int stampX = x % width;
+		int stampY = y % height;
+		u16 flips = 0;
+
+		if (placed.flags & Map::eFlipX)
+		{
+			stampX = width - 1 - stampX;
+			flips |= 0x0800;
+		}
+
+		if (placed.flags & Map::eFlipY)
+		{
+			stampY = height - 1 - stampY;
+			flips |= 0x1000;
+		}
+
+		u16 tile = GetOriginalTile(placed.stamp, stampX, stampY, width, height) ^ flips;
+
+		if (placed.flags & Map::eHighPlane)
+			tile |= 0x8000;
+
+		return (u16)(s_vramTileBase + tile);
+	}
+
+	static bool LoadStreamingLoops(asm68k::Source& source, std::string& error)
+	{
+		std::string engineDir = test::GetRootDir() + "/ENGINE/";
+		bool loaded = source.LoadConstants(engineDir + "BLDCONF.ASM")
+			&& source.LoadConstants(engineDir + "CONSTS.ASM")
+			&& source.LoadMacros(engineDir + "MACROS/MAP.ASM")
+			&& source.LoadMacros(engineDir + "MACROS/VDP.ASM")
+			&& source.LoadCode(engineDir + "MAP.ASM", "@StreamRow", "@RowDone")
+			&& source.LoadCode(engineDir + "MAP.ASM", "@StreamCol", "@ColDone");
+
+		error = loaded ? source.GetError() : "Couldn't find the streaming loops in ENGINE/MAP.ASM " + source.GetError();
+		return loaded && error.empty();
+	}
+
+	//Sets up the exported stamps and map, and registers as MAP_UpdateStreamingPlane has them at the loops
+	static void InitStreamer(asm68k::Cpu& cpu, int width, int height, int mapX, int mapY, int count)
+	{
+		u32 stampSizeBytes = width * height * 2;
+
+		for (int stamp = 0; stamp < 2; stamp++)
+		{
+			for (int y = 0; y < height; y++)
+			{
+				for (int x = 0; x < width; x++)
+				{
+					cpu.WriteMemory(s_stampDataAddr + (stamp * stampSizeBytes) + (((y * width) + x) * 2), GetUniqueTile(stamp, x, y, width, height), 2);
+				}
+			}
+		}
+
+		//Remapped by the exporter's stamp dedupe, from the stamps as placed
+		TilesetExporter exporter;
+		exporter.BeginUniqueStamps(4);
+
+		std::vector<u16> words(width * height);
+
+		for (int stamp = 0; stamp < 4; stamp++)
+		{
+			for (int y = 0; y < height; y++)
+			{
+				for (int x = 0; x < width; x++)
+				{
+					words[(y * width) + x] = GetOriginalTile(stamp, x, y, width, height);
+				}
+			}
+
+			exporter.AddUniqueStamp(words, width, height);
+		}
+
+		if (exporter.GetNumUniqueStamps() != 2)
+		{
+			test::Fail(__FILE__, __LINE__, "flipped duplicate stamps weren't folded into the first two");
+		}
+
+		const std::vector<TilesetExporter::StampRemap>& remap = exporter.GetStampRemap();
+
+		for (int y = 0; y < s_mapHeightStamps; y++)
+		{
+			for (int x = 0; x < s_mapWidthStamps; x++)
+			{
+				u32 stampWord = MapExporter::GetStampWord(s_testMap[y][x].stamp, s_testMap[y][x].flags, stampSizeBytes, remap);
+				cpu.WriteMemory(s_stampMapAddr + (((y * s_mapWidthStamps) + x) * 4), stampWord, 4);
+			}
+		}
+
+		cpu.d[1] = mapY;
+		cpu.d[2] = mapX;
+		cpu.d[3] = s_mapWidthStamps;
+		cpu.d[6] = count - 1;
+		cpu.d[7] = s_vdpWriteCommand;
+		cpu.a[0] = s_stampMapAddr;
+		cpu.a[1] = s_stampDataAddr;
+		cpu.a[2] = s_vramTileBase;
+		cpu.a[5] = asm68k::Cpu::s_vdpControlPort;
+		cpu.a[6] = asm68k::Cpu::s_vdpDataPort;
+	}
+
+	LUMINARY_TEST(MapStream_RowsMatchPlacedStamps)
+	{
+		asm68k::Source source;
+		std::string error;
+
+		if (!LoadStreamingLoops(source, error))
+		{
+			test::Fail(__FILE__, __LINE__, error);
+			return;
+		}
+
+		int width = (int)source.Evaluate("MAP_STREAM_STAMP_WIDTH");
+		int height = (int)source.Evaluate("MAP_STREAM_STAMP_HEIGHT");
+		int mapWidth = s_mapWidthStamps * width;
+
+		//Top, stamp edges and bottom, whole rows and a partial row starting mid stamp
+		const int rows[] = { 0, 1, height - 1, height, height + 13, (s_mapHeightStamps * height) - 1 };
+
+		for (int i = 0; i < sizeof(rows) / sizeof(rows[0]); i++)
+		{
+			for (int startX = 0; startX < width; startX += width - 5)
+			{
+				asm68k::Cpu cpu(source);
+				InitStreamer(cpu, width, height, startX, rows[i], mapWidth - startX);
+
+				if (!cpu.Run("@StreamRow", "@RowDone"))
+				{
+					test::Fail(__FILE__, __LINE__, cpu.GetError());
+					return;
+				}
+
+				TEST_CHECK_EQUAL(cpu.vdpData.size(), mapWidth - startX);
+
+				for (int x = startX; x < mapWidth; x++)
+				{
+					if (cpu.vdpData[x - startX] != GetExpectedTile(x, rows[i], width, height))
+					{
+						char message[128];
+						snprintf(message, sizeof(message), "Row %d tile %d: streamed 0x%04x, expected 0x%04x", rows[i], x, cpu.vdpData[x - startX], GetExpectedTile(x, rows[i], width, height));
+						test::Fail(__FILE__, __LINE__, message);
+						return;
+					}
+				}
+
+				//Both paths ran, flagged stamps out of line only
+				TEST_CHECK(cpu.executed["tst"] == mapWidth - startX);
+				TEST_CHECK(cpu.executed["swap"] > 0 && cpu.executed["swap"] < cpu.executed["tst"]);
+			}
+		}
+	}
+
+	LUMINARY_TEST(MapStream_ColumnsMatchPlacedStamps)
+	{
+		asm68k::Source source;
+		std::string error;
+
+		if (!LoadStreamingLoops(source, error))
+		{
+			test::Fail(__FILE__, __LINE__, error);
+			return;
+		}
+
+		int width = (int)source.Evaluate("MAP_STREAM_STAMP_WIDTH");
+		int height = (int)source.Evaluate("MAP_STREAM_STAMP_HEIGHT");
+		int mapHeight = s_mapHeightStamps * height;
+
+		//A column through each stamp, both edges of a stamp, and the right hand edge of the map
+		const int columns[] = { 0, width - 1, width, (2 * width) + 9, (3 * width) + 17, (s_mapWidthStamps * width) - 1 };
+
+		for (int i = 0; i < sizeof(columns) / sizeof(columns[0]); i++)
+		{
+			asm68k::Cpu cpu(source);
+			InitStreamer(cpu, width, height, columns[i], 0, mapHeight);
+
+			//Column loop takes X in d1 and Y in d2
+			std::swap(cpu.d[1], cpu.d[2]);
+
+			if (!cpu.Run("@StreamCol", "@ColDone"))
+			{
+				test::Fail(__FILE__, __LINE__, cpu.GetError());
+				return;
+			}
+
+			TEST_CHECK_EQUAL(cpu.vdpData.size(), mapHeight);
+
+			for (int y = 0; y < mapHeight; y++)
+			{
+				if (cpu.vdpData[y] != GetExpectedTile(columns[i], y, width, height))
+				{
+					char message[128];
+					snprintf(message, sizeof(message), "Column %d tile %d: streamed 0x%04x, expected 0x%04x", columns[i], y, cpu.vdpData[y], GetExpectedTile(columns[i], y, width, height));
+					test::Fail(__FILE__, __LINE__, message);
+					return;
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,612 @@
+// ============================================================================================
+// LUMINARY - a game engine and framework for the SEGA Mega Drive
+// ============================================================================================
+// Matt Phillips - Big Evil Corporation Ltd - 17th October 2026
+// ============================================================================================
+// ScriptCompilerTests.cpp - Script build pipeline tests
+// ============================================================================================
+
+#include "Test.h"
+#include "TestElf.h"
+
+#include "../ScriptCompiler.h"
+
+#include <algorithm>
+#include <stdlib.h>
+#include <filesystem>
+
+namespace luminary
+{
+	static ScriptFunc MakeScriptFunc(const std::string& scope, const std::string& name, const std::string& routine)
+	{
+		ScriptFunc scriptFunc;
+		scriptFunc.tableOffset = 0;
+		scriptFunc.scope = scope;
+		scriptFunc.name = name;
+		scriptFunc.routine = routine;
+		scriptFunc.returnType = "void";
+		return scriptFunc;
+	}
+
+	LUMINARY_TEST(ScriptCompiler_GlobalOffsetTableDedupesFuncs)
+	{
+		std::vector<Entity> entities(2);
+		entities[0].scriptFuncs.push_back(MakeScriptFunc("Entity", "GetPosition", "ENT_GetPosition"));
+		entities[0].scriptFuncs.push_back(MakeScriptFunc("Entity", "SetPosition", "ENT_SetPosition"));
+		entities[1].scriptFuncs.push_back(MakeScriptFunc("Entity", "GetPosition", "ENT_GetPosition"));
+
+		std::vector<Component> components(1);
+		components[0].scriptFuncs.push_back(MakeScriptFunc("Entity", "SetPosition", "ENT_SetPosition"));
+		components[0].scriptFuncs.push_back(MakeScriptFunc("ECSprite", "SetFrame", "ECSprite_SetFrame"));
+
+		std::string asmFilename = test::MakeTempDir("got") + "/SCRIPTGOT.ASM";
+		std::vector<ScriptFunc> table;
+		TEST_CHECK(ScriptTranspiler().GenerateGlobalOffsetTable(entities, components, table, asmFilename));
+
+		TEST_CHECK_EQUAL(table.size(), 3);
+		TEST_CHECK_EQUAL(table[0].routine, "ENT_GetPosition");
+		TEST_CHECK_EQUAL(table[1].routine, "ENT_SetPosition");
+		TEST_CHECK_EQUAL(table[2].routine, "ECSprite_SetFrame");
+		TEST_CHECK_EQUAL(table[2].tableOffset, 2);
+
+		GlobalOffsetTableIndex index(table);
+		TEST_CHECK_EQUAL(index.Find("ECSprite", "SetFrame"), 2);
+		TEST_CHECK_EQUAL(index.FindRoutine("ENT_SetPosition"), 1);
+
+		std::string asmText = test::ReadTextFile(asmFilename);
+		TEST_CHECK_EQUAL(std::count(asmText.begin(), asmText.end(), '\n'), 3);
+	}
+
+	LUMINARY_TEST(ScriptCompiler_GlobalOffsetTableKeepsPreviousIndices)
+	{
+		std::vector<ScriptFunc> previousTable =
+		{
+			MakeScriptFunc("Entity", "GetPosition", "ENT_GetPosition"),
+			MakeScriptFunc("Entity", "SetPosition", "ENT_SetPosition"),
+			MakeScriptFunc("ECSprite", "SetFrame", "ECSprite_SetFrame"),
+		};
+
+		std::string asmFilename = test::MakeTempDir("got_previous") + "/SCRIPTGOT.ASM";
+		std::vector<ScriptFunc> table;
+
+		//Kept funcs stay put, a new one takes the freed slot
+		std::vector<Entity> entities(1);
+		entities[0].scriptFuncs.push_back(MakeScriptFunc("ECSprite", "SetFrame", "ECSprite_SetFrame"));
+		entities[0].scriptFuncs.push_back(MakeScriptFunc("ECSprite", "SetAnim", "ECSprite_SetAnim"));
+		entities[0].scriptFuncs.push_back(MakeScriptFunc("Entity", "GetPosition", "ENT_GetPosition"));
+
+		TEST_CHECK(ScriptTranspiler().GenerateGlobalOffsetTable(entities, {}, previousTable, table, asmFilename));
+		TEST_CHECK_EQUAL(table.size(), 3);
+		TEST_CHECK_EQUAL(table[0].routine, "ENT_GetPosition");
+		TEST_CHECK_EQUAL(table[1].routine, "ECSprite_SetAnim");
+		TEST_CHECK_EQUAL(table[2].routine, "ECSprite_SetFrame");
+		TEST_CHECK_EQUAL(table[1].tableOffset, 1);
+
+		//A removed func leaves an unused slot, so later entries don't move
+		entities[0].scriptFuncs.erase(entities[0].scriptFuncs.begin() + 1);
+
+		TEST_CHECK(ScriptTranspiler().GenerateGlobalOffsetTable(entities, {}, previousTable, table, asmFilename));
+		TEST_CHECK_EQUAL(table.size(), 3);
+		TEST_CHECK_EQUAL(table[0].routine, "ENT_GetPosition");
+		TEST_CHECK_EQUAL(table[1].routine, "");
+		TEST_CHECK_EQUAL(table[2].routine, "ECSprite_SetFrame");
+
+		std::string asmText = test::ReadTextFile(asmFilename);
+		TEST_CHECK_EQUAL(std::count(asmText.begin(), asmText.end(), '\n'), 3);
+		TEST_CHECK(asmText.find("\t dc.l 0\t\t; Unused\n") != std::string::npos);
+
+		GlobalOffsetTableIndex index(table);
+		TEST_CHECK_EQUAL(index.Find("Entity", "SetPosition"), -1);
+		TEST_CHECK_EQUAL(index.FindRoutine("ECSprite_SetFrame"), 2);
+
+		//Trailing free slots are dropped
+		entities[0].scriptFuncs.erase(entities[0].scriptFuncs.begin());
+
+		TEST_CHECK(ScriptTranspiler().GenerateGlobalOffsetTable(entities, {}, previousTable, table, asmFilename));
+		TEST_CHECK_EQUAL(table.size(), 1);
+		TEST_CHECK_EQUAL(table[0].routine, "ENT_GetPosition");
+	}
+
+	LUMINARY_TEST(ScriptCompiler_RunCommandReturnsExitCode)
+	{
+#if defined _WIN32
+		test::Skip("uses POSIX shell commands");
+#else
+		ScriptCompiler compiler;
+		std::vector<std::string> output;
+
+		TEST_CHECK_EQUAL(compiler.RunCommand("echo hello", output), 0);
+		TEST_CHECK_EQUAL(output.size(), 1);
+		TEST_CHECK_EQUAL(output[0], "hello");
+
+		//Exit code, not the raw wait status
+		output.clear();
+		TEST_CHECK_EQUAL(compiler.RunCommand("exit 3", output), 3);
+
+		//Killed by a signal
+		output.clear();
+		TEST_CHECK_EQUAL(compiler.RunCommand("kill -9 $$", output), -1);
+#endif
+	}
+
+	LUMINARY_TEST(ScriptCompiler_UnitySourceIncludesRelativeToUnityDir)
+	{
+		std::string tempDir = test::MakeTempDir("unity");
+		std::filesystem::create_directories(tempDir + "/SCRIPTS/ENTITIES");
+		std::filesystem::create_directories(tempDir + "/BUILD");
+
+		std::vector<ScriptBuildJob> jobs(2);
+		jobs[0].entityName = "Player";
+		jobs[0].filename = tempDir + "/SCRIPTS/ENTITIES/PLAYER.cpp";
+		jobs[1].entityName = "Door";
+		jobs[1].filename = tempDir + "/SCRIPTS/./ENTITIES/../ENTITIES/DOOR.cpp";
+
+		std::string unityFilename = tempDir + "/BUILD/UNITY.cpp";
+		ScriptCompiler compiler;
+		TEST_CHECK(compiler.GenerateUnitySource(jobs, unityFilename));
+
+		std::string unitySource = test::ReadTextFile(unityFilename);
+		TEST_CHECK(unitySource.find("#include \"../SCRIPTS/ENTITIES/PLAYER.cpp\"") != std::string::npos);
+		TEST_CHECK(unitySource.find("#include \"../SCRIPTS/ENTITIES/DOOR.cpp\"") != std::string::npos);
+
+		//Entry points feed the SCRIPTFUNC params by entity type and func name
+		std::vector<ScriptEntryPointOffset> entryPoints = { { "Player", "OnStart", 0x10 }, { "Player", "OnUpdate", 0x40 }, { "Door", "OnUpdate", 0x80 } };
+		ScriptAddressMap scriptAddresses;
+		compiler.GetScriptAddresses(entryPoints, scriptAddresses);
+
+		TEST_CHECK_EQUAL(scriptAddresses["Player"].size(), 2);
+		TEST_CHECK_EQUAL(scriptAddresses["Player"][1].name, "OnUpdate");
+		TEST_CHECK_EQUAL(scriptAddresses["Player"][1].address, 0x40);
+		TEST_CHECK_EQUAL(scriptAddresses["Door"][0].address, 0x80);
+	}
+
+	static Component MakeRegisterCallComponent()
+	{
+		Component component;
+		component.name = "ECPhysics";
+
+		//short ApplyForce(short x:d1, short y:d2), void:reg Reset(), stack call Stop(short speed)
+		component.scriptFuncs.push_back(MakeScriptFunc("ECPhysics", "ApplyForce", "ECPhysics_ApplyForce"));
+		component.scriptFuncs.back().returnType = "short";
+		component.scriptFuncs.back().params = { { "short", "x:d1" }, { "short", "y:d2" } };
+
+		component.scriptFuncs.push_back(MakeScriptFunc("ECPhysics", "Reset", "ECPhysics_Reset"));
+		component.scriptFuncs.back().returnType = "void:reg";
+
+		component.scriptFuncs.push_back(MakeScriptFunc("ECPhysics", "Stop", "ECPhysics_Stop"));
+		component.scriptFuncs.back().params = { { "short", "speed" } };
+
+		//this is always in a0
+		component.scriptFuncs.push_back(MakeScriptFunc("ECPhysics", "Bad", "ECPhysics_Bad"));
+		component.scriptFuncs.back().params = { { "short", "value:a0" } };
+
+		return component;
+	}
+
+	static std::string GenerateRegisterCallHeader(const std::string& outputDir)
+	{
+		ScriptTranspiler transpiler;
+		if (!transpiler.GenerateComponentCppHeader({ MakeRegisterCallComponent() }, outputDir))
+		{
+			test::Fail(__FILE__, __LINE__, "could not write Components.h");
+			return "";
+		}
+
+		//Same path the transpiler writes to
+		return test::ReadTextFile(outputDir + "\\" + "Components.h");
+	}
+
+	LUMINARY_TEST(ScriptCompiler_RegisterCallWrappers)
+	{
+		std::string header = GenerateRegisterCallHeader(test::MakeTempDir("regcall"));
+
+		const char* expected[] =
+		{
+			"extern \"C\" void ECPhysics_ApplyForce();",
+			"extern \"C\" void ECPhysics_Reset();",
+
+			//Args pinned read/write, return in d0, routine from the GOT in any free address register
+			"\tinline __attribute__((always_inline)) short ApplyForce(short x, short y)\n"
+			"\t{\n"
+			"\t\tregister ECPhysics* reg_a0 asm(\"a0\") = this;\n"
+			"\t\tregister short reg_d1 asm(\"d1\") = (short)x;\n"
+			"\t\tregister short reg_d2 asm(\"d2\") = (short)y;\n"
+			"\t\tregister short reg_d0 asm(\"d0\");\n"
+			"\t\tasm volatile(\"jsr (%[routine])\"\n"
+			"\t\t\t: \"=r\"(reg_d0), \"+r\"(reg_a0), \"+r\"(reg_d1), \"+r\"(reg_d2)\n"
+			"\t\t\t: [routine] \"a\"(&ECPhysics_ApplyForce)\n"
+			"\t\t\t: \"a1\", \"cc\", \"memory\");\n"
+			"\t\treturn reg_d0;\n"
+			"\t}\n",
+
+			//Scratch registers that aren't operands are clobbered
+			"\t\t\t: [routine] \"a\"(&ECPhysics_Reset)\n"
+			"\t\t\t: \"d0\", \"d1\", \"a1\", \"cc\", \"memory\");\n",
+
+			"\tvoid Stop(short speed);\n",
+			"#error \"ECPhysics::Bad param value needs a unique register in d0-d7/a1-a4\"",
+		};
+
+		for (int i = 0; i < sizeof(expected) / sizeof(expected[0]); i++)
+		{
+			if (header.find(expected[i]) == std::string::npos)
+			{
+				test::Fail(__FILE__, __LINE__, std::string("generated header is missing:\n") + expected[i] + "\n--- header ---\n" + header);
+			}
+		}
+	}
+
+	LUMINARY_TEST(ScriptCompiler_RegisterCallCodegen)
+	{
+		//Compiles a call through the generated wrapper for the 68000 and checks the call sequence.
+		//Set LUMINARY_M68K_GCC to the compiler if m68k-elf-gcc isn't on the path.
+		const char* compilerEnv = getenv("LUMINARY_M68K_GCC");
+		std::string compiler = compilerEnv ? compilerEnv : "m68k-elf-gcc";
+
+		ScriptCompiler scriptCompiler;
+		std::vector<std::string> output;
+
+		if (scriptCompiler.RunCommand("\"" + compiler + "\" --version", output) != 0)
+		{
+			test::Skip(compiler + " not found");
+			return;
+		}
+
+		std::string tempDir = test::MakeTempDir("regcall_codegen");
+		test::WriteTextFile(tempDir + "/Components.h", GenerateRegisterCallHeader(tempDir));
+		test::WriteTextFile(tempDir + "/Call.cpp",
+			"#include <Common.h>\n"
+			"#include <Components.h>\n"
+			"short CallApplyForce(ECPhysics& physics, short x, short y) { return physics.ApplyForce(x, y); }\n");
+
+		std::string asmFilename = tempDir + "/Call.s";
+		output.clear();
+		int result = scriptCompiler.RunCommand("\"" + compiler + "\" -m68000 -O3 -fno-builtin -nostdlib -fpie -x c++ -S"
+			" -I\"" + test::GetRootDir() + "/INCLUDE\" -I\"" + tempDir + "\" \"" + tempDir + "/Call.cpp\" -o \"" + asmFilename + "\"", output);
+
+		std::string compilerOutput;
+		for (int i = 0; i < output.size(); i++)
+			compilerOutput += output[i] + "\n";
+
+		if (result != 0)
+		{
+			test::Fail(__FILE__, __LINE__, "compile failed:\n" + compilerOutput);
+			return;
+		}
+
+		//One jsr through an address register, args loaded straight into d1/d2, nothing pushed for the call
+		std::string code = test::ReadTextFile(asmFilename);
+		size_t jsrPos = code.find("jsr (%a");
+		TEST_CHECK(jsrPos != std::string::npos);
+		TEST_CHECK(code.find("jsr", jsrPos + 1) == std::string::npos);
+		TEST_CHECK(code.find(",%d1") != std::string::npos);
+		TEST_CHECK(code.find(",%d2") != std::string::npos);
+		TEST_CHECK(code.find("pea") == std::string::npos);
+		TEST_CHECK(code.find("ECPhysics_ApplyForce") != std::string::npos);
+	}
+
+	LUMINARY_TEST(ScriptCompiler_BuildReportFlagsSlowScripts)
+	{
+		//Mostly cached build, one rebuilt script far slower than the other misses
+		std::vector<ScriptBuildJob> jobs;
+
+		for (int i = 0; i < 8; i++)
+		{
+			ScriptBuildJob job = ScriptBuildJob();
+			job.entityName = "Cached" + std::to_string(i);
+			job.cacheHit = true;
+			job.success = true;
+			job.timings.cacheLookup = 2.0;
+			job.timings.link = 0.5;
+			jobs.push_back(job);
+		}
+
+		const char* missNames[] = { "Player", "Door, \"big\"", "Boss" };
+		const double missCompileTimes[] = { 100.0, 110.0, 1500.0 };
+
+		for (int i = 0; i < 3; i++)
+		{
+			ScriptBuildJob job = ScriptBuildJob();
+			job.entityName = missNames[i];
+			job.cacheHit = false;
+			job.success = true;
+			job.timings.cacheLookup = 2.0;
+			job.timings.compile = missCompileTimes[i];
+			job.timings.link = 0.5;
+			jobs.push_back(job);
+		}
+
+		std::string tempDir = test::MakeTempDir("build_report");
+		ScriptCompiler compiler;
+		TEST_CHECK(compiler.WriteBuildReport(jobs, "", tempDir + "/report.csv", tempDir + "/report.txt", 10.0));
+
+		//Only Boss is over 10x the compile median of the misses, nothing is compared against the cache hits
+		std::string csv = test::ReadTextFile(tempDir + "/report.csv");
+		TEST_CHECK(csv.find("\nCached0,1,1,0,") != std::string::npos);
+		TEST_CHECK(csv.find("\nPlayer,1,0,0,") != std::string::npos);
+		TEST_CHECK(csv.find("\n\"Door, \"\"big\"\"\",1,0,0,") != std::string::npos);
+		TEST_CHECK(csv.find("\nBoss,1,0,1,") != std::string::npos);
+
+		std::string summary = test::ReadTextFile(tempDir + "/report.txt");
+		TEST_CHECK(summary.find("SLOW (compile 13.6x median)") != std::string::npos);
+	}
+
+	LUMINARY_TEST(ScriptCompiler_CacheManifestSkipsPreprocessing)
+	{
+		//No compiler at compilerDir, so a lookup that falls back to preprocessing returns an empty key
+		std::string tempDir = test::MakeTempDir("cache_manifest");
+		std::string scriptsDir = tempDir + "/SCRIPTS";
+		std::string includeDir = tempDir + "/INCLUDE";
+		std::string cacheDir = tempDir + "/CACHE";
+		std::string compilerDir = "no_compiler";
+		std::vector<std::string> includeDirs = { scriptsDir, includeDir };
+		std::vector<std::string> defines = { "DEBUG=1" };
+
+		const std::pair<std::string, std::string> inputs[] =
+		{
+			{ scriptsDir + "/EPickup.cpp", "#include \"EPickup.h\"\nvoid EPickup::OnStart() {}\n" },
+			{ scriptsDir + "/EPickup.h", "#include <Common.h>\n#include <Components.h>\nstruct EPickup {};\n" },
+			{ scriptsDir + "/Components.h", "struct ECSprite {};\n" },
+			{ includeDir + "/Common.h", "typedef short s16;\n" },
+		};
+
+		for (int i = 0; i < 4; i++)
+		{
+			test::WriteTextFile(inputs[i].first, inputs[i].second);
+		}
+
+		ScriptBuildJob job = ScriptBuildJob();
+		job.entityName = "EPickup";
+		job.filename = inputs[0].first;
+
+		ScriptCompiler compiler;
+		compiler.SetCacheDirectory(cacheDir);
+
+		std::string compileCommand = compiler.GenerateCompileCommand("", "", compilerDir, includeDirs, defines);
+		std::string directKey = compiler.GetDirectCacheKey(job, compileCommand, includeDirs);
+		TEST_CHECK_EQUAL(directKey.size(), 16);
+
+		//Miss, falls back to preprocessing and records no manifest when that fails
+		TEST_CHECK_EQUAL(compiler.GetCacheKey(job, compilerDir, includeDirs, defines), "");
+		TEST_CHECK(!std::filesystem::exists(cacheDir + "/" + directKey + ".manifest"));
+
+		//Hit, the object key comes straight from the manifest
+		const std::string objectKey = "0123456789abcdef";
+		test::WriteTextFile(cacheDir + "/" + directKey + ".manifest", objectKey);
+		TEST_CHECK_EQUAL(compiler.GetCacheKey(job, compilerDir, includeDirs, defines), objectKey);
+
+		//Renamed outputs still hit
+		job.outname = tempDir + "/elsewhere";
+		TEST_CHECK_EQUAL(compiler.GetCacheKey(job, compilerDir, includeDirs, defines), objectKey);
+
+		//Editing any tracked input misses, restoring it hits again
+		for (int i = 0; i < 4; i++)
+		{
+			test::WriteTextFile(inputs[i].first, inputs[i].second + "// edited\n");
+			TEST_CHECK(compiler.GetDirectCacheKey(job, compileCommand, includeDirs) != directKey);
+			TEST_CHECK_EQUAL(compiler.GetCacheKey(job, compilerDir, includeDirs, defines), "");
+
+			test::WriteTextFile(inputs[i].first, inputs[i].second);
+			TEST_CHECK_EQUAL(compiler.GetCacheKey(job, compilerDir, includeDirs, defines), objectKey);
+		}
+
+		//Changed defines or include order change the command
+		TEST_CHECK_EQUAL(compiler.GetCacheKey(job, compilerDir, includeDirs, { "DEBUG=0" }), "");
+		TEST_CHECK_EQUAL(compiler.GetCacheKey(job, compilerDir, { includeDir, scriptsDir }, defines), "");
+
+		//A Common.h earlier in the include path shadows the old one
+		test::WriteTextFile(scriptsDir + "/Common.h", inputs[3].second);
+		TEST_CHECK_EQUAL(compiler.GetCacheKey(job, compilerDir, includeDirs, defines), "");
+		std::filesystem::remove(scriptsDir + "/Common.h");
+		TEST_CHECK_EQUAL(compiler.GetCacheKey(job, compilerDir, includeDirs, defines), objectKey);
+
+		//A damaged manifest misses
+		test::WriteTextFile(cacheDir + "/" + directKey + ".manifest", "0123456789abc");
+		TEST_CHECK_EQUAL(compiler.GetCacheKey(job, compilerDir, includeDirs, defines), "");
+
+		//No direct mode for a script that can't be read
+		job.filename = scriptsDir + "/Missing.cpp";
+		TEST_CHECK_EQUAL(compiler.GetDirectCacheKey(job, compileCommand, includeDirs), "");
+	}
+
+	static ScriptRelocation MakeRelocation(u32 address, u16 tableIdx, const std::string& name)
+	{
+		ScriptRelocation relocation;
+		relocation.address = address;
+		relocation.tableIdx = tableIdx;
+		relocation.name = name;
+		return relocation;
+	}
+
+	LUMINARY_TEST(ScriptCompiler_LinkProgramPatchesGOTWords)
+	{
+		const u16 globalOffsetTableSize = 0x0100;
+		const u16 binaryStartOffset = 0x0400;
+
+		std::vector<u8> binary(32, 0xAA);
+		std::vector<ScriptRelocation> relocationTable =
+		{
+			MakeRelocation(0x02, 0, "_GLOBAL_OFFSET_TABLE_"),
+			MakeRelocation(0x06, 0, "ENT_GetPosition"),
+			MakeRelocation(0x0A, 3, "ENT_SetPosition"),
+			MakeRelocation(0x1E, 255, "ECSprite_SetFrame"),
+		};
+
+		ScriptCompiler compiler;
+		TEST_CHECK_EQUAL(compiler.LinkProgram(binary, relocationTable, globalOffsetTableSize, binaryStartOffset), 32);
+
+		//Big endian words: PC relative offset back to the GOT, then entry offsets of a longword each
+		const u16 gotOffset = (u16)(-0x02 - binaryStartOffset - globalOffsetTableSize);
+		const std::pair<u32, u16> words[] =
+		{
+			{ 0x02, gotOffset },
+			{ 0x06, 0 * 4 },
+			{ 0x0A, 3 * 4 },
+			{ 0x1E, 255 * 4 },
+		};
+
+		TEST_CHECK_EQUAL(gotOffset, 0xFAFE);
+
+		std::vector<u8> expected(32, 0xAA);
+		for (int i = 0; i < 4; i++)
+		{
+			expected[words[i].first] = (u8)(words[i].second >> 8);
+			expected[words[i].first + 1] = (u8)(words[i].second & 0xFF);
+		}
+
+		TEST_CHECK(binary == expected);
+
+		//Nothing to patch, links as-is
+		std::vector<u8> unpatched(16, 0x4E);
+		TEST_CHECK_EQUAL(compiler.LinkProgram(unpatched, {}, globalOffsetTableSize, binaryStartOffset), 16);
+		TEST_CHECK(unpatched == std::vector<u8>(16, 0x4E));
+
+		//A word starting on the last byte, or past the end, is out of range
+		binary.assign(32, 0xAA);
+		TEST_CHECK_EQUAL(compiler.LinkProgram(binary, { MakeRelocation(31, 1, "ENT_GetPosition") }, globalOffsetTableSize, binaryStartOffset), 0);
+		TEST_CHECK_EQUAL(compiler.LinkProgram(binary, { MakeRelocation(32, 1, "ENT_GetPosition") }, globalOffsetTableSize, binaryStartOffset), 0);
+		TEST_CHECK(binary == std::vector<u8>(32, 0xAA));
+
+		std::vector<u8> empty;
+		TEST_CHECK_EQUAL(compiler.LinkProgram(empty, { MakeRelocation(0, 0, "_GLOBAL_OFFSET_TABLE_") }, globalOffsetTableSize, binaryStartOffset), 0);
+	}
+
+	//OnStart loading the GOT, then calling ENT_SetPosition and ECSprite_SetFrame through it
+	static std::vector<u8> BuildLinkObject()
+	{
+		const u32 textIdx = 1;
+		const u32 symTabIdx = 3;
+		const u32 strTabIdx = 4;
+
+		std::vector<u8> text;
+		for (int i = 0; i < 8; i++)
+			test::PushU16(text, 0x4E71);
+
+		std::vector<u8> strTab;
+		strTab.push_back(0);
+
+		std::vector<u8> symTab;
+		test::PushSymbol(symTab, 0, 0, 0, 0, 0);
+		test::PushSymbol(symTab, test::AddString(strTab, "_ZN7EPickup7OnStartEv"), 0x00, 16, ElfReader::STT_FUNC, textIdx);
+		test::PushSymbol(symTab, test::AddString(strTab, "_GLOBAL_OFFSET_TABLE_"), 0, 0, ElfReader::STT_NOTYPE, 0);
+		test::PushSymbol(symTab, test::AddString(strTab, "ENT_SetPosition"), 0, 0, ElfReader::STT_NOTYPE, 0);
+		test::PushSymbol(symTab, test::AddString(strTab, "ECSprite_SetFrame"), 0, 0, ElfReader::STT_NOTYPE, 0);
+
+		std::vector<u8> relaText;
+		test::PushRela(relaText, 0x02, 2, ElfReader::R_68K_GOT16O, 0);
+		test::PushRela(relaText, 0x06, 3, ElfReader::R_68K_GOT16O, 0);
+		test::PushRela(relaText, 0x0A, 4, ElfReader::R_68K_GOT16O, 0);
+
+		return test::BuildElf(
+		{
+			{ ".text", 1, text, 0, 0 },
+			{ ".rela.text", 4, relaText, symTabIdx, textIdx },
+			{ ".symtab", 2, symTab, strTabIdx, 1 },
+			{ ".strtab", 3, strTab, 0, 0 },
+		});
+	}
+
+	LUMINARY_TEST(ScriptCompiler_StableGlobalOffsetsReuseLinkedBinary)
+	{
+		std::string tempDir = test::MakeTempDir("got_reuse");
+		std::string cacheDir = tempDir + "/CACHE";
+		std::string asmFilename = tempDir + "/SCRIPTGOT.ASM";
+		std::string compilerDir = "no_compiler";
+		std::vector<std::string> includeDirs = { tempDir };
+		std::vector<std::string> defines;
+		const u16 globalOffsetTableSize = 0x0100;
+
+		std::vector<ScriptBuildJob> jobs(1);
+		jobs[0].entityName = "EPickup";
+		jobs[0].filename = tempDir + "/EPickup.cpp";
+		jobs[0].outname = tempDir + "/EPickup";
+		jobs[0].binaryStartOffset = 0x0400;
+		test::WriteTextFile(jobs[0].filename, "void EPickup::OnStart() {}\n");
+
+		//Seed the object cache and a manifest pointing at it, so every build is a cache hit with no compiler
+		ScriptCompiler compiler;
+		compiler.SetCacheDirectory(cacheDir);
+
+		const std::string objectKey = "0123456789abcdef";
+		std::vector<u8> object = BuildLinkObject();
+		std::string compileCommand = compiler.GenerateCompileCommand("", "", compilerDir, includeDirs, defines);
+		test::WriteTextFile(cacheDir + "/" + compiler.GetDirectCacheKey(jobs[0], compileCommand, includeDirs) + ".manifest", objectKey);
+		test::WriteTextFile(cacheDir + "/" + objectKey + ".o", std::string(object.begin(), object.end()));
+
+		std::vector<Entity> entities(1);
+		entities[0].scriptFuncs.push_back(MakeScriptFunc("ECSprite", "SetFrame", "ECSprite_SetFrame"));
+		entities[0].scriptFuncs.push_back(MakeScriptFunc("Entity", "SetPosition", "ENT_SetPosition"));
+
+		//First build links and stamps the .bin, then saves the table
+		std::vector<ScriptFunc> previousTable;
+		std::vector<ScriptFunc> table;
+		TEST_CHECK(!compiler.LoadGlobalOffsetTable(previousTable));
+		TEST_CHECK(ScriptTranspiler().GenerateGlobalOffsetTable(entities, {}, previousTable, table, asmFilename));
+		TEST_CHECK(compiler.BuildScripts(jobs, compilerDir, includeDirs, defines, table, globalOffsetTableSize));
+		TEST_CHECK(jobs[0].cacheHit);
+		TEST_CHECK(!jobs[0].linkReused);
+		TEST_CHECK_EQUAL(jobs[0].binarySize, 16);
+		TEST_CHECK(std::filesystem::exists(jobs[0].outname + ".link"));
+
+		std::vector<u8> linked = jobs[0].binary;
+		TEST_CHECK_EQUAL(linked[0x07], 1 * 4);
+		TEST_CHECK_EQUAL(linked[0x0B], 0 * 4);
+		TEST_CHECK(test::ReadTextFile(jobs[0].outname + ".bin") == std::string(linked.begin(), linked.end()));
+
+		TEST_CHECK(compiler.LoadGlobalOffsetTable(previousTable));
+		TEST_CHECK_EQUAL(previousTable.size(), 2);
+		TEST_CHECK_EQUAL(previousTable[1].scope, "Entity");
+		TEST_CHECK_EQUAL(previousTable[1].name, "SetPosition");
+		TEST_CHECK_EQUAL(previousTable[1].routine, "ENT_SetPosition");
+
+		//A new func ahead of the others shifts them, unless the previous table is passed
+		entities[0].scriptFuncs.insert(entities[0].scriptFuncs.begin(), MakeScriptFunc("Entity", "GetPosition", "ENT_GetPosition"));
+
+		std::vector<ScriptFunc> shiftedTable;
+		TEST_CHECK(ScriptTranspiler().GenerateGlobalOffsetTable(entities, {}, shiftedTable, asmFilename));
+		TEST_CHECK_EQUAL(shiftedTable[0].routine, "ENT_GetPosition");
+
+		TEST_CHECK(ScriptTranspiler().GenerateGlobalOffsetTable(entities, {}, previousTable, table, asmFilename));
+		TEST_CHECK_EQUAL(table.size(), 3);
+		TEST_CHECK_EQUAL(table[0].routine, "ECSprite_SetFrame");
+		TEST_CHECK_EQUAL(table[1].routine, "ENT_SetPosition");
+		TEST_CHECK_EQUAL(table[2].routine, "ENT_GetPosition");
+
+		//Same object and indices, the .bin is read back rather than relinked
+		const std::string marker(linked.size(), 'L');
+		test::WriteTextFile(jobs[0].outname + ".bin", marker);
+
+		TEST_CHECK(compiler.BuildScripts(jobs, compilerDir, includeDirs, defines, table, globalOffsetTableSize));
+		TEST_CHECK(jobs[0].linkReused);
+		TEST_CHECK_EQUAL(jobs[0].binarySize, 16);
+		TEST_CHECK(jobs[0].binary == std::vector<u8>(marker.begin(), marker.end()));
+
+		TEST_CHECK(compiler.LoadGlobalOffsetTable(previousTable));
+		TEST_CHECK_EQUAL(previousTable.size(), 3);
+
+		//Moved indices relink and restamp
+		TEST_CHECK(compiler.BuildScripts(jobs, compilerDir, includeDirs, defines, shiftedTable, globalOffsetTableSize));
+		TEST_CHECK(!jobs[0].linkReused);
+		TEST_CHECK_EQUAL(jobs[0].binary[0x07], 2 * 4);
+		TEST_CHECK_EQUAL(jobs[0].binary[0x0B], 1 * 4);
+		TEST_CHECK(test::ReadTextFile(jobs[0].outname + ".bin") == std::string(jobs[0].binary.begin(), jobs[0].binary.end()));
+
+		linked = jobs[0].binary;
+		TEST_CHECK(compiler.BuildScripts(jobs, compilerDir, includeDirs, defines, shiftedTable, globalOffsetTableSize));
+		TEST_CHECK(jobs[0].linkReused);
+		TEST_CHECK(jobs[0].binary == linked);
+
+		//So do a new GOT size or start offset, both move the GOT pointer
+		TEST_CHECK(compiler.BuildScripts(jobs, compilerDir, includeDirs, defines, shiftedTable, globalOffsetTableSize + 4));
+		TEST_CHECK(!jobs[0].linkReused);
+
+		jobs[0].binaryStartOffset = 0x0800;
+		TEST_CHECK(compiler.BuildScripts(jobs, compilerDir, includeDirs, defines, shiftedTable, globalOffsetTableSize + 4));
+		TEST_CHECK(!jobs[0].linkReused);
+
+		//Without a cache there's nothing to vouch for the .bin
+		ScriptCompiler uncachedCompiler;
+		TEST_CHECK(!uncachedCompiler.LoadGlobalOffsetTable(previousTable));
+		TEST_CHECK(previousTable.empty());
+	}
+}
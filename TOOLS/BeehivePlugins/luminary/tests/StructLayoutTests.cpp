@@ -0,0 +1,214 @@
+// ============================================================================================
+// LUMINARY - a game engine and framework for the SEGA Mega Drive
+// ============================================================================================
+// Matt Phillips - Big Evil Corporation Ltd - 17th October 2026
+// ============================================================================================
+// StructLayoutTests.cpp - ASM rs offset layout and packed ordering tests
+// ============================================================================================
+
+#include "Test.h"
+
+#include "../StructLayout.h"
+#include "../ScriptCompiler.h"
+
+namespace luminary
+{
+	//Offsets of the non-padding fields, in layout order
+	static std::vector<int> GetFieldOffsets(const StructLayout& layout)
+	{
+		std::vector<int> offsets;
+
+		for (int i = 0; i < layout.GetFields().size(); i++)
+		{
+			if (!layout.GetFields()[i].padding)
+			{
+				offsets.push_back(layout.GetFields()[i].offset);
+			}
+		}
+
+		return offsets;
+	}
+
+	static std::vector<std::string> GetFieldNames(const StructLayout& layout)
+	{
+		std::vector<std::string> names;
+
+		for (int i = 0; i < layout.GetFields().size(); i++)
+		{
+			names.push_back(layout.GetFields()[i].name);
+		}
+
+		return names;
+	}
+
+	LUMINARY_TEST(StructLayout_AlignsWordsAndLongs)
+	{
+		//rs.b, rs.w, rs.b, rs.l, rs.b, rs.w
+		StructLayout layout;
+		layout.AddField("flags", "EPickup_Flags", ParamSize::Byte);
+		layout.AddField("count", "EPickup_Count", ParamSize::Word);
+		layout.AddField("type", "EPickup_Type", ParamSize::Byte);
+		layout.AddField("score", "EPickup_Score", ParamSize::Long);
+		layout.AddField("sfx", "EPickup_SFX", ParamSize::Byte);
+		layout.AddField("timer", "EPickup_Timer", ParamSize::Word);
+		layout.Build(false);
+
+		TEST_CHECK(GetFieldOffsets(layout) == std::vector<int>({ 0, 2, 4, 6, 10, 12 }));
+		TEST_CHECK(GetFieldNames(layout) == std::vector<std::string>({ "flags", "padding0", "count", "type", "padding1", "score", "sfx", "padding2", "timer" }));
+		TEST_CHECK_EQUAL(layout.GetSize(), 14);
+		TEST_CHECK_EQUAL(layout.GetAsmSize(), 14);
+		TEST_CHECK_EQUAL(layout.GetPaddingSize(), 3);
+		TEST_CHECK(!layout.IsReordered());
+
+		//Consecutive bytes pack, and so do words after an even number of them
+		StructLayout bytes;
+		bytes.AddField("a", "A", ParamSize::Byte);
+		bytes.AddField("b", "B", ParamSize::Byte);
+		bytes.AddField("c", "C", ParamSize::Word);
+		bytes.AddField("d", "D", ParamSize::Long);
+		bytes.Build(false);
+
+		TEST_CHECK(GetFieldOffsets(bytes) == std::vector<int>({ 0, 1, 2, 4 }));
+		TEST_CHECK_EQUAL(bytes.GetSize(), 8);
+		TEST_CHECK_EQUAL(bytes.GetPaddingSize(), 0);
+
+		//Empty
+		StructLayout empty;
+		empty.Build(false);
+		TEST_CHECK_EQUAL(empty.GetSize(), 0);
+		TEST_CHECK(empty.GetFields().empty());
+	}
+
+	LUMINARY_TEST(StructLayout_OddTrailingSizes)
+	{
+		//ENTITY_COMPONENT_END doesn't align, the ASM size stays odd and only the C++ struct rounds up
+		StructLayout layout;
+		layout.AddField("speed", "ECMover_Speed", ParamSize::Word);
+		layout.AddField("dir", "ECMover_Dir", ParamSize::Byte);
+		layout.Build(false);
+
+		TEST_CHECK_EQUAL(layout.GetAsmSize(), 3);
+		TEST_CHECK_EQUAL(layout.GetSize(), 4);
+		TEST_CHECK_EQUAL(layout.GetPaddingSize(), 1);
+		TEST_CHECK_EQUAL(layout.GetFields().back().name, "padding0");
+		TEST_CHECK_EQUAL(layout.GetFields().back().offset, 3);
+
+		std::stringstream asserts;
+		layout.WriteCppOffsetAsserts(asserts, "ECMover", "ComponentBase", true);
+		TEST_CHECK(asserts.str().find("sizeof(ECMover) == sizeof(ComponentBase) + 4, \"ECMover size doesn't match ASM (3 bytes, rounded up to even)\"") != std::string::npos);
+		TEST_CHECK(asserts.str().find("__builtin_offsetof(ECMover, dir) == sizeof(ComponentBase) + 2,") != std::string::npos);
+		TEST_CHECK(asserts.str().find("padding0") == std::string::npos);
+
+		//A single byte, then three
+		StructLayout single;
+		single.AddField("state", "ECState_State", ParamSize::Byte);
+		single.Build(false);
+		TEST_CHECK_EQUAL(single.GetAsmSize(), 1);
+		TEST_CHECK_EQUAL(single.GetSize(), 2);
+
+		StructLayout three;
+		three.AddField("r", "R", ParamSize::Byte);
+		three.AddField("g", "G", ParamSize::Byte);
+		three.AddField("b", "B", ParamSize::Byte);
+		three.Build(false);
+		TEST_CHECK(GetFieldOffsets(three) == std::vector<int>({ 0, 1, 2 }));
+		TEST_CHECK_EQUAL(three.GetAsmSize(), 3);
+		TEST_CHECK_EQUAL(three.GetSize(), 4);
+
+		//Even sizes need nothing
+		StructLayout even;
+		even.AddField("x", "X", ParamSize::Long);
+		even.AddField("y", "Y", ParamSize::Byte);
+		even.AddField("z", "Z", ParamSize::Byte);
+		even.Build(false);
+		TEST_CHECK_EQUAL(even.GetAsmSize(), 6);
+		TEST_CHECK_EQUAL(even.GetSize(), 6);
+		TEST_CHECK_EQUAL(even.GetPaddingSize(), 0);
+	}
+
+	LUMINARY_TEST(StructLayout_PackedOrdering)
+	{
+		//Longs, words, then bytes, keeping declaration order within each size
+		StructLayout layout;
+		layout.AddField("flags", "EPickup_Flags", ParamSize::Byte);
+		layout.AddField("count", "EPickup_Count", ParamSize::Word);
+		layout.AddField("type", "EPickup_Type", ParamSize::Byte);
+		layout.AddField("score", "EPickup_Score", ParamSize::Long);
+		layout.AddField("sfx", "EPickup_SFX", ParamSize::Byte);
+		layout.AddField("timer", "EPickup_Timer", ParamSize::Word);
+		layout.Build(true);
+
+		TEST_CHECK(GetFieldNames(layout) == std::vector<std::string>({ "score", "count", "timer", "flags", "type", "sfx", "padding0" }));
+		TEST_CHECK(GetFieldOffsets(layout) == std::vector<int>({ 0, 4, 6, 8, 9, 10 }));
+		TEST_CHECK_EQUAL(layout.GetAsmSize(), 11);
+		TEST_CHECK_EQUAL(layout.GetSize(), 12);
+		TEST_CHECK_EQUAL(layout.GetPaddingSize(), 1);
+		TEST_CHECK(layout.IsReordered());
+
+		//Out of ASM order, the header must not compile
+		std::stringstream comment;
+		layout.WriteAsmOrderComment(comment, "EPickup");
+		TEST_CHECK_EQUAL(comment.str().find("#error \"EPickup packed layout doesn't match the ASM declaration order"), 0);
+		TEST_CHECK(comment.str().find("//\tEPickup_Score\trs.l 1\n//\tEPickup_Count\trs.w 1\n//\tEPickup_Timer\trs.w 1\n//\tEPickup_Flags\trs.b 1\n") != std::string::npos);
+
+		//Rebuilding keeps the padding count, not stacking a second pass of padding fields
+		layout.Build(true);
+		TEST_CHECK_EQUAL(layout.GetPaddingSize(), 1);
+		TEST_CHECK_EQUAL(layout.GetFields().size(), 7);
+
+		//ASM already in packed order, no error
+		StructLayout sorted;
+		sorted.AddField("score", "EPickup_Score", ParamSize::Long);
+		sorted.AddField("count", "EPickup_Count", ParamSize::Word);
+		sorted.AddField("flags", "EPickup_Flags", ParamSize::Byte);
+		sorted.Build(true);
+
+		TEST_CHECK(!sorted.IsReordered());
+		TEST_CHECK(GetFieldOffsets(sorted) == std::vector<int>({ 0, 4, 6 }));
+
+		std::stringstream sortedComment;
+		sorted.WriteAsmOrderComment(sortedComment, "EPickup");
+		TEST_CHECK(sortedComment.str().find("#error") == std::string::npos);
+
+		//Same sized fields never reorder
+		StructLayout words;
+		words.AddField("b", "B", ParamSize::Word);
+		words.AddField("a", "A", ParamSize::Word);
+		words.Build(true);
+		TEST_CHECK(!words.IsReordered());
+	}
+
+	LUMINARY_TEST(StructLayout_PackedHeaderErrorsUntilASMReordered)
+	{
+		std::string outputDir = test::MakeTempDir("packed_layout");
+
+		Component component;
+		component.name = "ECMover";
+		component.params.resize(2);
+		component.params[0].name = "ECMover_Dir";
+		component.params[0].size = ParamSize::Byte;
+		component.params[1].name = "ECMover_Speed";
+		component.params[1].size = ParamSize::Word;
+
+		ScriptTranspiler transpiler;
+		transpiler.SetPackedLayouts(true);
+
+		//Same path the transpiler writes to
+		TEST_CHECK(transpiler.GenerateComponentCppHeader({ component }, outputDir));
+		std::string header = test::ReadTextFile(outputDir + "\\" + "Components.h");
+		TEST_CHECK(header.find("#error \"ECMover packed layout") != std::string::npos);
+
+		std::swap(component.params[0], component.params[1]);
+		TEST_CHECK(transpiler.GenerateComponentCppHeader({ component }, outputDir));
+		header = test::ReadTextFile(outputDir + "\\" + "Components.h");
+		TEST_CHECK(header.find("#error") == std::string::npos);
+		TEST_CHECK(header.find("// ECMover expects its ASM params declared in this order:") != std::string::npos);
+
+		//Unpacked headers follow the ASM as-is, never erroring
+		std::swap(component.params[0], component.params[1]);
+		transpiler.SetPackedLayouts(false);
+		TEST_CHECK(transpiler.GenerateComponentCppHeader({ component }, outputDir));
+		header = test::ReadTextFile(outputDir + "\\" + "Components.h");
+		TEST_CHECK(header.find("#error") == std::string::npos);
+	}
+}
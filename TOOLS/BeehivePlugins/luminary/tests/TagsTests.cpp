@@ -0,0 +1,70 @@
+// ============================================================================================
+// LUMINARY - a game engine and framework for the SEGA Mega Drive
+// ============================================================================================
+// Matt Phillips - Big Evil Corporation Ltd - 17th October 2026
+// ============================================================================================
+// TagsTests.cpp - Param tag interning tests
+// ============================================================================================
+
+#include "Test.h"
+
+#include "../Tags.h"
+#include "../EntityParser.h"
+
+namespace luminary
+{
+	LUMINARY_TEST(Tags_ParsesPlainAndValuedTags)
+	{
+		tags::TagSet tagSet = tags::ParseTags({ "position_x", "SCRIPTFUNC_OnStart", "SCRIPTGLOBAL=counter", "UNSUPPORTED", "SCRIPTFUNC" });
+
+		std::string value;
+		TEST_CHECK(tagSet.HasTag(tags::TagType::PositionX));
+		TEST_CHECK(tagSet.FindTagValue(tags::TagType::ScriptFunc, value));
+		TEST_CHECK_EQUAL(value, "OnStart");
+		TEST_CHECK(tagSet.FindTagValue(tags::TagType::ScriptGlobal, value));
+		TEST_CHECK_EQUAL(value, "counter");
+		TEST_CHECK_EQUAL(tagSet.values.size(), 2);
+
+		//Plain tags don't match as prefixes
+		TEST_CHECK(!tags::ParseTags({ "SCRIPT_DATA_X" }).HasTag(tags::TagType::ScriptData));
+	}
+
+	LUMINARY_TEST(Tags_ResolvesESCRIPTFuncTags)
+	{
+		EntityParser parser;
+		std::vector<Entity> entities;
+		TEST_CHECK(parser.ParseFiles({ test::GetRootDir() + "/FRAMEWK/ENTITIES/ESCRIPT.ASM" }, entities));
+
+		const Component* script = nullptr;
+		for (int i = 0; i < parser.GetComponents().size(); i++)
+		{
+			if (parser.GetComponents()[i].name == "ECScript")
+				script = &parser.GetComponents()[i];
+		}
+
+		TEST_CHECK(script != nullptr);
+
+		const std::pair<std::string, std::string> funcs[] =
+		{
+			{ "SDScript_FuncStart", "OnStart" },
+			{ "SDScript_FuncShutdown", "OnShutdown" },
+			{ "SDScript_FuncUpdate", "OnUpdate" },
+		};
+
+		for (int i = 0; i < 3; i++)
+		{
+			const Param* param = nullptr;
+			for (int j = 0; j < script->spawnData.params.size(); j++)
+			{
+				if (script->spawnData.params[j].name == funcs[i].first)
+					param = &script->spawnData.params[j];
+			}
+
+			TEST_CHECK(param != nullptr);
+
+			std::string value;
+			TEST_CHECK(tags::ParseTags(param->tags).FindTagValue(tags::TagType::ScriptFunc, value));
+			TEST_CHECK_EQUAL(value, funcs[i].second);
+		}
+	}
+}
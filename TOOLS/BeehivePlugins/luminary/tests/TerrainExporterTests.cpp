@@ -0,0 +1,100 @@
+// ============================================================================================
+// LUMINARY - a game engine and framework for the SEGA Mega Drive
+// ============================================================================================
+// Matt Phillips - Big Evil Corporation Ltd - 17th October 2026
+// ============================================================================================
+// TerrainExporterTests.cpp - Terrain stamp dedupe tests and benchmark
+// ============================================================================================
+
+#include "Test.h"
+
+#include "../TerrainExporter.h"
+
+#include <algorithm>
+#include <stdio.h>
+
+namespace luminary
+{
+	//Exported longwords for a 4x4 stamp, layers interleaved per tile
+	static const int s_testStampStride = 4 * 4 * TerrainExporter::s_terrainLayers;
+
+	static std::vector<u32> MakeTerrainStamp(u32 seed)
+	{
+		std::vector<u32> stamp(s_testStampStride);
+
+		for (int i = 0; i < stamp.size(); i++)
+		{
+			stamp[i] = ((seed * 31 + i) % 7 == 0) ? ((0x1000u << 16) | (seed + i)) : 0;
+		}
+
+		return stamp;
+	}
+
+	LUMINARY_TEST(TerrainExporter_DedupesStamps)
+	{
+		std::vector<u32> stampA = MakeTerrainStamp(1);
+		std::vector<u32> stampB = MakeTerrainStamp(2);
+
+		//Differs from A in one layer of one tile only
+		std::vector<u32> stampC = stampA;
+		stampC[s_testStampStride - 1] ^= 0x00010000;
+
+		TerrainExporter exporter;
+		exporter.BeginUniqueStamps(s_testStampStride, 5);
+
+		TEST_CHECK_EQUAL(exporter.AddUniqueStamp(stampA.data()), 0);
+		TEST_CHECK_EQUAL(exporter.AddUniqueStamp(stampB.data()), 1);
+		TEST_CHECK_EQUAL(exporter.AddUniqueStamp(stampA.data()), 0);
+		TEST_CHECK_EQUAL(exporter.AddUniqueStamp(stampC.data()), 2);
+		TEST_CHECK_EQUAL(exporter.AddUniqueStamp(stampB.data()), 1);
+		TEST_CHECK_EQUAL(exporter.GetNumUniqueTerrainStamps(), 3);
+
+		//Stored in first seen order, as exported
+		const std::vector<u32>& uniqueData = exporter.GetUniqueStampData();
+		TEST_CHECK_EQUAL(uniqueData.size(), 3 * s_testStampStride);
+		TEST_CHECK(std::equal(stampA.begin(), stampA.end(), uniqueData.begin()));
+		TEST_CHECK(std::equal(stampB.begin(), stampB.end(), uniqueData.begin() + s_testStampStride));
+		TEST_CHECK(std::equal(stampC.begin(), stampC.end(), uniqueData.begin() + (2 * s_testStampStride)));
+
+		//Begin starts over
+		exporter.BeginUniqueStamps(s_testStampStride, 1);
+		TEST_CHECK_EQUAL(exporter.AddUniqueStamp(stampB.data()), 0);
+		TEST_CHECK_EQUAL(exporter.GetNumUniqueTerrainStamps(), 1);
+	}
+
+	LUMINARY_BENCHMARK(TerrainExporter_StampDedupe)
+	{
+		//8192 stamps, 1 in 4 unique, against the previous linear search over unique stamps
+		const int numStamps = 8192;
+		const int numUnique = numStamps / 4;
+
+		std::vector<std::vector<u32>> stamps;
+		for (int i = 0; i < numStamps; i++)
+		{
+			stamps.push_back(MakeTerrainStamp((u32)((i * 7919) % numUnique)));
+		}
+
+		double startTime = test::GetTimeMs();
+		std::vector<std::vector<u32>> uniqueStamps;
+		for (int i = 0; i < numStamps; i++)
+		{
+			if (std::find(uniqueStamps.begin(), uniqueStamps.end(), stamps[i]) == uniqueStamps.end())
+			{
+				uniqueStamps.push_back(stamps[i]);
+			}
+		}
+		double linearTime = test::GetTimeMs() - startTime;
+
+		startTime = test::GetTimeMs();
+		TerrainExporter exporter;
+		exporter.BeginUniqueStamps(s_testStampStride, numStamps);
+		for (int i = 0; i < numStamps; i++)
+		{
+			exporter.AddUniqueStamp(stamps[i].data());
+		}
+		double hashedTime = test::GetTimeMs() - startTime;
+
+		printf("    %d stamps, %d/%d unique: linear %.2f ms, hashed %.2f ms (%.1fx)\n", numStamps, (int)uniqueStamps.size(), exporter.GetNumUniqueTerrainStamps(),
+			linearTime, hashedTime, (hashedTime > 0.0) ? (linearTime / hashedTime) : 0.0);
+	}
+}
@@ -0,0 +1,74 @@
+// ============================================================================================
+// LUMINARY - a game engine and framework for the SEGA Mega Drive
+// ============================================================================================
+// Matt Phillips - Big Evil Corporation Ltd - 17th October 2026
+// ============================================================================================
+// Test.h - Minimal test and benchmark registry for the luminary tools
+// ============================================================================================
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace luminary
+{
+	namespace test
+	{
+		typedef void (*TestFunc)();
+
+		struct TestInfo
+		{
+			const char* name;
+			TestFunc func;
+			bool benchmark;
+		};
+
+		std::vector<TestInfo>& GetTests();
+
+		struct Registrar
+		{
+			Registrar(const char* name, TestFunc func, bool benchmark)
+			{
+				TestInfo info;
+				info.name = name;
+				info.func = func;
+				info.benchmark = benchmark;
+				GetTests().push_back(info);
+			}
+		};
+
+		//Marks the running test failed, or skipped (e.g. an optional toolchain isn't installed)
+		void Fail(const char* file, int line, const std::string& message);
+		void Skip(const std::string& reason);
+
+		//LUMINARY repository root, for tests reading engine source
+		std::string GetRootDir();
+
+		//Fresh empty directory for a test's files
+		std::string MakeTempDir(const std::string& name);
+
+		void WriteTextFile(const std::string& filename, const std::string& text);
+		std::string ReadTextFile(const std::string& filename);
+
+		//Milliseconds since first call, for benchmarks
+		double GetTimeMs();
+	}
+}
+
+#define LUMINARY_TEST(name) \
+	static void name(); \
+	static luminary::test::Registrar s_registrar_##name(#name, name, false); \
+	static void name()
+
+//Benchmarks only run with --benchmark, they print timings rather than check them
+#define LUMINARY_BENCHMARK(name) \
+	static void name(); \
+	static luminary::test::Registrar s_registrar_##name(#name, name, true); \
+	static void name()
+
+#define TEST_CHECK(cond) \
+	do { if (!(cond)) { luminary::test::Fail(__FILE__, __LINE__, #cond); return; } } while (0)
+
+#define TEST_CHECK_EQUAL(a, b) \
+	do { if (!((a) == (b))) { luminary::test::Fail(__FILE__, __LINE__, #a " == " #b); return; } } while (0)
@@ -0,0 +1,134 @@
+// ============================================================================================
+// LUMINARY - a game engine and framework for the SEGA Mega Drive
+// ============================================================================================
+// Matt Phillips - Big Evil Corporation Ltd - 17th October 2026
+// ============================================================================================
+// TestElf.h - In memory m68k-elf object builder for the object reader and linker tests
+// ============================================================================================
+
+#pragma once
+
+#include "../Types.h"
+
+#include <string>
+#include <vector>
+
+namespace luminary
+{
+	namespace test
+	{
+		//Minimal m68k-elf relocatable object writer, laid out as header, section data, section headers
+		struct TestElfSection
+		{
+			std::string name;
+			u32 type;
+			std::vector<u8> data;
+			u32 link;
+			u32 info;
+		};
+
+		inline void PushU16(std::vector<u8>& data, u16 value)
+		{
+			data.push_back((u8)(value >> 8));
+			data.push_back((u8)value);
+		}
+
+		inline void PushU32(std::vector<u8>& data, u32 value)
+		{
+			data.push_back((u8)(value >> 24));
+			data.push_back((u8)(value >> 16));
+			data.push_back((u8)(value >> 8));
+			data.push_back((u8)value);
+		}
+
+		inline u32 AddString(std::vector<u8>& strTab, const std::string& string)
+		{
+			u32 offset = (u32)strTab.size();
+			strTab.insert(strTab.end(), string.begin(), string.end());
+			strTab.push_back(0);
+			return offset;
+		}
+
+		inline void PushSymbol(std::vector<u8>& symTab, u32 nameOffset, u32 value, u32 size, u8 type, u16 sectionIdx)
+		{
+			PushU32(symTab, nameOffset);
+			PushU32(symTab, value);
+			PushU32(symTab, size);
+			symTab.push_back((u8)(0x10 | type));	//STB_GLOBAL
+			symTab.push_back(0);
+			PushU16(symTab, sectionIdx);
+		}
+
+		inline void PushRela(std::vector<u8>& relaTab, u32 offset, u32 symbolIdx, u8 type, s32 addend)
+		{
+			PushU32(relaTab, offset);
+			PushU32(relaTab, (symbolIdx << 8) | type);
+			PushU32(relaTab, (u32)addend);
+		}
+
+		inline std::vector<u8> BuildElf(const std::vector<TestElfSection>& sections)
+		{
+			//Null section first, section names last
+			std::vector<TestElfSection> allSections;
+			allSections.push_back({ "", 0, {}, 0, 0 });
+			allSections.insert(allSections.end(), sections.begin(), sections.end());
+			allSections.push_back({ ".shstrtab", 3, {}, 0, 0 });
+
+			std::vector<u8> shStrTab;
+			std::vector<u32> nameOffsets;
+			shStrTab.push_back(0);
+
+			for (int i = 0; i < allSections.size(); i++)
+			{
+				nameOffsets.push_back(allSections[i].name.empty() ? 0 : AddString(shStrTab, allSections[i].name));
+			}
+
+			allSections.back().data = shStrTab;
+
+			std::vector<u8> sectionData;
+			std::vector<u32> dataOffsets;
+
+			for (int i = 0; i < allSections.size(); i++)
+			{
+				dataOffsets.push_back(0x34 + (u32)sectionData.size());
+				sectionData.insert(sectionData.end(), allSections[i].data.begin(), allSections[i].data.end());
+
+				while (sectionData.size() & 3)
+					sectionData.push_back(0);
+			}
+
+			std::vector<u8> elf = { 0x7F, 'E', 'L', 'F', 1, 2, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+			PushU16(elf, 1);	//ET_REL
+			PushU16(elf, 4);	//EM_68K
+			PushU32(elf, 1);	//Version
+			PushU32(elf, 0);	//Entry
+			PushU32(elf, 0);	//Program headers
+			PushU32(elf, 0x34 + (u32)sectionData.size());
+			PushU32(elf, 0);	//Flags
+			PushU16(elf, 0x34);
+			PushU16(elf, 0);
+			PushU16(elf, 0);
+			PushU16(elf, 0x28);
+			PushU16(elf, (u16)allSections.size());
+			PushU16(elf, (u16)(allSections.size() - 1));
+
+			elf.insert(elf.end(), sectionData.begin(), sectionData.end());
+
+			for (int i = 0; i < allSections.size(); i++)
+			{
+				PushU32(elf, nameOffsets[i]);
+				PushU32(elf, allSections[i].type);
+				PushU32(elf, 0);	//Flags
+				PushU32(elf, 0);	//Address
+				PushU32(elf, (i == 0) ? 0 : dataOffsets[i]);
+				PushU32(elf, (u32)allSections[i].data.size());
+				PushU32(elf, allSections[i].link);
+				PushU32(elf, allSections[i].info);
+				PushU32(elf, 4);	//Alignment
+				PushU32(elf, (allSections[i].type == 2) ? 0x10 : (allSections[i].type == 4) ? 0x0C : 0);
+			}
+
+			return elf;
+		}
+	}
+}
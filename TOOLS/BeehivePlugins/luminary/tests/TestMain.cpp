@@ -0,0 +1,140 @@
+// ============================================================================================
+// LUMINARY - a game engine and framework for the SEGA Mega Drive
+// ============================================================================================
+// Matt Phillips - Big Evil Corporation Ltd - 17th October 2026
+// ============================================================================================
+// TestMain.cpp - Runs the luminary tool tests: luminary_tests [--benchmark] [--root dir] [name]
+// ============================================================================================
+
+#include "Test.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace luminary
+{
+	namespace test
+	{
+		static std::string s_rootDir;
+		static bool s_failed = false;
+		static bool s_skipped = false;
+
+		std::vector<TestInfo>& GetTests()
+		{
+			static std::vector<TestInfo> tests;
+			return tests;
+		}
+
+		void Fail(const char* file, int line, const std::string& message)
+		{
+			printf("    %s(%d): check failed: %s\n", file, line, message.c_str());
+			s_failed = true;
+		}
+
+		void Skip(const std::string& reason)
+		{
+			printf("    skipped: %s\n", reason.c_str());
+			s_skipped = true;
+		}
+
+		std::string GetRootDir()
+		{
+			return s_rootDir;
+		}
+
+		std::string MakeTempDir(const std::string& name)
+		{
+			std::filesystem::path path = std::filesystem::temp_directory_path() / "luminary_tests" / name;
+			std::filesystem::remove_all(path);
+			std::filesystem::create_directories(path);
+			return path.generic_string();
+		}
+
+		void WriteTextFile(const std::string& filename, const std::string& text)
+		{
+			std::filesystem::create_directories(std::filesystem::path(filename).parent_path());
+			std::ofstream stream(filename, std::ios::binary);
+			stream << text;
+		}
+
+		std::string ReadTextFile(const std::string& filename)
+		{
+			std::ifstream stream(filename, std::ios::binary);
+			std::stringstream text;
+			text << stream.rdbuf();
+			return text.str();
+		}
+
+		double GetTimeMs()
+		{
+			static const std::chrono::steady_clock::time_point s_start = std::chrono::steady_clock::now();
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - s_start).count();
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	using namespace luminary::test;
+
+	bool benchmarks = false;
+	const char* filter = nullptr;
+
+	//Default root is the first directory holding LUMINARY.ASM, up from this file or the working directory
+	for (std::filesystem::path path : { std::filesystem::absolute(__FILE__), std::filesystem::current_path() })
+	{
+		for (; s_rootDir.empty() && path.has_relative_path(); path = path.parent_path())
+		{
+			if (std::filesystem::exists(path / "LUMINARY.ASM"))
+				s_rootDir = path.generic_string();
+		}
+	}
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--benchmark") == 0)
+			benchmarks = true;
+		else if (strcmp(argv[i], "--root") == 0 && i + 1 < argc)
+			s_rootDir = argv[++i];
+		else
+			filter = argv[i];
+	}
+
+	if (s_rootDir.empty())
+	{
+		printf("warning: LUMINARY root not found, tests reading engine source will fail (pass --root dir)\n");
+	}
+
+	int numPassed = 0;
+	int numFailed = 0;
+	int numSkipped = 0;
+
+	for (int i = 0; i < GetTests().size(); i++)
+	{
+		const TestInfo& info = GetTests()[i];
+
+		if (info.benchmark != benchmarks || (filter && strstr(info.name, filter) == nullptr))
+			continue;
+
+		printf("%s\n", info.name);
+
+		s_failed = false;
+		s_skipped = false;
+		info.func();
+
+		if (s_failed)
+			numFailed++;
+		else if (s_skipped)
+			numSkipped++;
+		else
+			numPassed++;
+	}
+
+	printf("%d passed, %d failed, %d skipped\n", numPassed, numFailed, numSkipped);
+
+	return (numFailed > 0) ? 1 : 0;
+}
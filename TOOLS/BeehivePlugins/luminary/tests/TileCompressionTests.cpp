@@ -0,0 +1,342 @@
+// ============================================================================================
+// LUMINARY - a game engine and framework for the SEGA Mega Drive
+// ============================================================================================
+// Matt Phillips - Big Evil Corporation Ltd - 17th October 2026
+// ============================================================================================
+// TileCompressionTests.cpp - TileLZ encode/decode round trip and malformed stream tests
+// ============================================================================================
+
+#include "Test.h"
+
+#include "../TileCompression.h"
+
+#include <algorithm>
+
+namespace luminary
+{
+	static const int s_blockSize = TileLZ::s_blockTiles * TileLZ::s_tileSizeBytes;
+
+	//One control byte's run, as TILES_DecompressLZ reads it
+	struct LZRun
+	{
+		bool match;
+		int length;
+		int offset;
+	};
+
+	static std::vector<LZRun> ReadRuns(const std::vector<u8>& compressed)
+	{
+		std::vector<LZRun> runs;
+		int pos = 0;
+
+		while (pos < compressed.size())
+		{
+			LZRun run;
+			run.match = (compressed[pos] & 0x80) != 0;
+			run.length = (compressed[pos] & 0x7F) + (run.match ? 3 : 1);
+			run.offset = run.match ? ((compressed[pos + 1] << 8) | compressed[pos + 2]) : 0;
+
+			pos += 1 + (run.match ? 2 : run.length);
+			runs.push_back(run);
+		}
+
+		return runs;
+	}
+
+	//Decode loop cost from the TILES_DecompressLZ/VDP_LoadTilesCompressed instruction timings
+	static int GetDecodeCycles(const std::vector<u8>& compressed, int numTiles)
+	{
+		const int cyclesLiteralRun = 46;
+		const int cyclesMatchRun = 100;
+		const int cyclesPerByte = 22;
+		const int cyclesPerBlock = 420;
+
+		std::vector<LZRun> runs = ReadRuns(compressed);
+		int cycles = ((numTiles + TileLZ::s_blockTiles - 1) / TileLZ::s_blockTiles) * cyclesPerBlock;
+
+		for (int i = 0; i < runs.size(); i++)
+		{
+			cycles += (runs[i].match ? cyclesMatchRun : cyclesLiteralRun) + (runs[i].length * cyclesPerByte);
+		}
+
+		return cycles;
+	}
+
+	static std::vector<u8> MakeRandomTiles(int numTiles, u32 seed)
+	{
+		std::vector<u8> tiles(numTiles * TileLZ::s_tileSizeBytes);
+
+		for (int i = 0; i < tiles.size(); i++)
+		{
+			seed = (seed * 1664525u) + 1013904223u;
+			tiles[i] = (u8)(seed >> 24);
+		}
+
+		return tiles;
+	}
+
+	//A few distinct tiles repeated, with runs of flat colour, as typical map art
+	static std::vector<u8> MakeRepetitiveTiles(int numTiles)
+	{
+		std::vector<u8> tiles(numTiles * TileLZ::s_tileSizeBytes);
+
+		for (int i = 0; i < tiles.size(); i++)
+		{
+			int tile = (i / TileLZ::s_tileSizeBytes) % 5;
+			int row = (i % TileLZ::s_tileSizeBytes) / 4;
+			tiles[i] = (tile == 0) ? 0x00 : (u8)((tile * 0x11) + ((row & tile) ? 0x10 : 0));
+		}
+
+		return tiles;
+	}
+
+	static bool RoundTrips(const std::vector<u8>& tiles, std::vector<u8>& compressed, TileLZ::Stats& stats)
+	{
+		TileLZ::Encode(tiles, compressed, stats);
+
+		std::vector<u8> decompressed;
+		if (!TileLZ::Decode(compressed, stats.numTiles, decompressed))
+		{
+			test::Fail(__FILE__, __LINE__, "decode failed");
+			return false;
+		}
+
+		if (decompressed != tiles)
+		{
+			test::Fail(__FILE__, __LINE__, "round trip differs");
+			return false;
+		}
+
+		return true;
+	}
+
+	LUMINARY_TEST(TileLZ_RoundTripsRandomData)
+	{
+		//100 tiles, so the last block holds 4
+		std::vector<u8> tiles = MakeRandomTiles(100, 1);
+		std::vector<u8> compressed;
+		TileLZ::Stats stats;
+
+		if (!RoundTrips(tiles, compressed, stats))
+			return;
+
+		TEST_CHECK_EQUAL(stats.numTiles, 100);
+		TEST_CHECK_EQUAL(stats.rawSize, 100 * TileLZ::s_tileSizeBytes);
+		TEST_CHECK_EQUAL(stats.compressedSize, compressed.size());
+
+		//Incompressible, so mostly literal runs split at the 128 byte maximum
+		std::vector<LZRun> runs = ReadRuns(compressed);
+		int maxLiterals = 0;
+		int numMaxLiteralRuns = 0;
+
+		for (int i = 0; i < runs.size(); i++)
+		{
+			if (!runs[i].match)
+			{
+				maxLiterals = std::max(maxLiterals, runs[i].length);
+				numMaxLiteralRuns += (runs[i].length == 128) ? 1 : 0;
+			}
+		}
+
+		TEST_CHECK_EQUAL(maxLiterals, 128);
+		TEST_CHECK(numMaxLiteralRuns >= 20);
+		TEST_CHECK(stats.GetRatio() > 1.0f);
+
+		//Any whole number of tiles, including a single one
+		for (int numTiles = 1; numTiles <= 65; numTiles += 16)
+		{
+			if (!RoundTrips(MakeRandomTiles(numTiles, numTiles), compressed, stats))
+				return;
+		}
+
+		//Nothing in, nothing out
+		if (!RoundTrips(std::vector<u8>(), compressed, stats))
+			return;
+
+		TEST_CHECK(compressed.empty());
+	}
+
+	LUMINARY_TEST(TileLZ_RoundTripsRepetitiveData)
+	{
+		//70 tiles, so the last block holds 6
+		std::vector<u8> tiles = MakeRepetitiveTiles(70);
+		std::vector<u8> compressed;
+		TileLZ::Stats stats;
+
+		if (!RoundTrips(tiles, compressed, stats))
+			return;
+
+		TEST_CHECK(stats.GetRatio() < 0.25f);
+
+		//Every match stays within its block
+		std::vector<LZRun> runs = ReadRuns(compressed);
+		int blockPos = 0;
+
+		for (int i = 0; i < runs.size(); i++)
+		{
+			if (runs[i].match)
+			{
+				TEST_CHECK(runs[i].offset > 0);
+				TEST_CHECK(runs[i].offset <= blockPos);
+			}
+
+			blockPos = (blockPos + runs[i].length) % s_blockSize;
+		}
+
+		//A flat block is one literal then overlapping offset 1 matches at the 130 byte maximum
+		std::vector<u8> flat(TileLZ::s_blockTiles * TileLZ::s_tileSizeBytes, 0x33);
+		if (!RoundTrips(flat, compressed, stats))
+			return;
+
+		runs = ReadRuns(compressed);
+		TEST_CHECK_EQUAL(runs.size(), 9);
+		TEST_CHECK(!runs[0].match);
+		TEST_CHECK_EQUAL(runs[0].length, 1);
+
+		for (int i = 1; i < 8; i++)
+		{
+			TEST_CHECK(runs[i].match);
+			TEST_CHECK_EQUAL(runs[i].length, 130);
+			TEST_CHECK_EQUAL(runs[i].offset, 1);
+		}
+
+		//1 + (7 * 130) leaves 113
+		TEST_CHECK(runs[8].match);
+		TEST_CHECK_EQUAL(runs[8].length, s_blockSize - 1 - (7 * 130));
+		TEST_CHECK_EQUAL(compressed[2], 0xFF);
+
+		//A repeating 3 byte pattern overlaps at offset 3
+		std::vector<u8> pattern(TileLZ::s_tileSizeBytes * 2);
+		for (int i = 0; i < pattern.size(); i++)
+			pattern[i] = (u8)(0xA0 + (i % 3));
+
+		if (!RoundTrips(pattern, compressed, stats))
+			return;
+
+		runs = ReadRuns(compressed);
+		TEST_CHECK_EQUAL(runs.size(), 2);
+		TEST_CHECK_EQUAL(runs[0].length, 3);
+		TEST_CHECK_EQUAL(runs[1].offset, 3);
+		TEST_CHECK_EQUAL(runs[1].length, (TileLZ::s_tileSizeBytes * 2) - 3);
+	}
+
+	//Literal runs covering length bytes of 0x5A
+	static void PushLiterals(std::vector<u8>& compressed, int length)
+	{
+		while (length > 0)
+		{
+			int run = std::min(length, 128);
+			compressed.push_back((u8)(run - 1));
+			compressed.insert(compressed.end(), run, 0x5A);
+			length -= run;
+		}
+	}
+
+	static void PushMatch(std::vector<u8>& compressed, int length, int offset)
+	{
+		compressed.push_back((u8)(0x80 | (length - 3)));
+		compressed.push_back((u8)(offset >> 8));
+		compressed.push_back((u8)offset);
+	}
+
+	LUMINARY_TEST(TileLZ_DecodeRejectsMalformedStreams)
+	{
+		const int tileSize = TileLZ::s_tileSizeBytes;
+		std::vector<u8> tiles;
+
+		//One tile: a literal then an overlapping match
+		std::vector<u8> valid;
+		PushLiterals(valid, 1);
+		PushMatch(valid, tileSize - 1, 1);
+		TEST_CHECK(TileLZ::Decode(valid, 1, tiles));
+		TEST_CHECK(tiles == std::vector<u8>(tileSize, 0x5A));
+
+		//Truncated anywhere, including mid offset
+		for (int size = 0; size < valid.size(); size++)
+		{
+			std::vector<u8> truncated(valid.begin(), valid.begin() + size);
+			TEST_CHECK(!TileLZ::Decode(truncated, 1, tiles));
+		}
+
+		//Trailing bytes after the last tile
+		std::vector<u8> trailing = valid;
+		trailing.push_back(0x00);
+		TEST_CHECK(!TileLZ::Decode(trailing, 1, tiles));
+
+		//Offset 0
+		std::vector<u8> zeroOffset;
+		PushLiterals(zeroOffset, 1);
+		PushMatch(zeroOffset, tileSize - 1, 0);
+		TEST_CHECK(!TileLZ::Decode(zeroOffset, 1, tiles));
+
+		//Offset before the start of the data
+		std::vector<u8> beforeData;
+		PushLiterals(beforeData, 1);
+		PushMatch(beforeData, tileSize - 1, 2);
+		TEST_CHECK(!TileLZ::Decode(beforeData, 1, tiles));
+
+		//Two blocks, the second may only copy from itself
+		const int numTiles = TileLZ::s_blockTiles + 1;
+
+		std::vector<u8> twoBlocks;
+		PushLiterals(twoBlocks, s_blockSize);
+		PushLiterals(twoBlocks, 1);
+		PushMatch(twoBlocks, tileSize - 1, 1);
+		TEST_CHECK(TileLZ::Decode(twoBlocks, numTiles, tiles));
+		TEST_CHECK_EQUAL(tiles.size(), numTiles * tileSize);
+
+		std::vector<u8> previousBlock;
+		PushLiterals(previousBlock, s_blockSize);
+		PushMatch(previousBlock, tileSize, 1);
+		TEST_CHECK(!TileLZ::Decode(previousBlock, numTiles, tiles));
+
+		std::vector<u8> farPreviousBlock;
+		PushLiterals(farPreviousBlock, s_blockSize);
+		PushLiterals(farPreviousBlock, 4);
+		PushMatch(farPreviousBlock, tileSize - 4, 8);
+		TEST_CHECK(!TileLZ::Decode(farPreviousBlock, numTiles, tiles));
+
+		//A match or literal run crossing into the next block
+		std::vector<u8> matchAcross;
+		PushLiterals(matchAcross, s_blockSize - 8);
+		PushMatch(matchAcross, 16, 1);
+		PushLiterals(matchAcross, tileSize - 8);
+		TEST_CHECK(!TileLZ::Decode(matchAcross, numTiles, tiles));
+
+		std::vector<u8> literalsAcross;
+		PushLiterals(literalsAcross, s_blockSize - 8);
+		literalsAcross.push_back(15);
+		literalsAcross.insert(literalsAcross.end(), 16, 0x5A);
+		PushLiterals(literalsAcross, tileSize - 8);
+		TEST_CHECK(!TileLZ::Decode(literalsAcross, numTiles, tiles));
+	}
+
+	LUMINARY_TEST(TileLZ_CyclesPerTileMatchesDecodeLoop)
+	{
+		//One flat tile: block setup, a 1 byte literal run, then a 31 byte match
+		std::vector<u8> compressed;
+		TileLZ::Stats stats;
+		TileLZ::Encode(std::vector<u8>(TileLZ::s_tileSizeBytes, 0), compressed, stats);
+
+		TEST_CHECK_EQUAL(stats.decodeCycles, 420 + (46 + 22) + (100 + (31 * 22)));
+		TEST_CHECK_EQUAL(stats.GetCyclesPerTile(), stats.decodeCycles);
+
+		//Recounted from the stream, over several blocks
+		const std::vector<u8> inputs[] = { MakeRandomTiles(100, 7), MakeRepetitiveTiles(70), std::vector<u8>(40 * TileLZ::s_tileSizeBytes, 0x11) };
+
+		for (int i = 0; i < 3; i++)
+		{
+			TileLZ::Encode(inputs[i], compressed, stats);
+			TEST_CHECK_EQUAL(stats.decodeCycles, GetDecodeCycles(compressed, stats.numTiles));
+			TEST_CHECK_EQUAL(stats.GetCyclesPerTile(), stats.decodeCycles / stats.numTiles);
+		}
+
+		//Every output byte is copied once whichever run it's in, so runs and blocks are the only overhead
+		TileLZ::Encode(inputs[2], compressed, stats);
+		TEST_CHECK(stats.decodeCycles > stats.rawSize * 22);
+		TEST_CHECK(stats.decodeCycles < (stats.rawSize * 22) + (2 * 420) + (12 * 100));
+
+		TileLZ::Stats empty = TileLZ::Stats();
+		TEST_CHECK_EQUAL(empty.GetCyclesPerTile(), 0);
+	}
+}
@@ -0,0 +1,331 @@
+// ============================================================================================
+// LUMINARY - a game engine and framework for the SEGA Mega Drive
+// ============================================================================================
+// Matt Phillips - Big Evil Corporation Ltd - 17th October 2026
+// ============================================================================================
+// TilesetExporterTests.cpp - Tileset export tests and benchmark
+// ============================================================================================
+
+#include "Test.h"
+
+#include "../TilesetExporter.h"
+#include "../BinaryWriter.h"
+
+#include <ion/core/io/File.h>
+
+#include <stdio.h>
+
+namespace luminary
+{
+	static const int s_testTileSize = 8;
+
+	//Row major colour indices, varied per tile and asymmetric in both axes
+	static std::vector<u8> MakeTilePixels(u32 seed)
+	{
+		std::vector<u8> pixels(s_testTileSize * s_testTileSize);
+
+		for (int i = 0; i < pixels.size(); i++)
+		{
+			pixels[i] = (u8)(((seed * 7) + (i * 3) + (i / s_testTileSize)) & 0xF);
+		}
+
+		return pixels;
+	}
+
+	LUMINARY_TEST(TilesetExporter_WritesTilePixels4bpp)
+	{
+		std::vector<u8> pixels(s_testTileSize * s_testTileSize);
+		for (int i = 0; i < pixels.size(); i++)
+			pixels[i] = (u8)(i & 0xF);
+
+		BinaryWriter writer;
+		TilesetExporter::WriteTilePixels(writer, pixels, s_testTileSize, s_testTileSize);
+
+		//High nybble first, 4 bytes per row
+		TEST_CHECK_EQUAL(writer.GetSize(), 32);
+		TEST_CHECK_EQUAL(writer.GetData()[0], 0x01);
+		TEST_CHECK_EQUAL(writer.GetData()[3], 0x67);
+		TEST_CHECK_EQUAL(writer.GetData()[4], 0x89);
+		TEST_CHECK_EQUAL(writer.GetData()[31], 0xEF);
+
+		//An odd width pads the last byte of each row with colour 0
+		BinaryWriter oddWriter;
+		TilesetExporter::WriteTilePixels(oddWriter, { 1, 2, 3, 4, 5, 6 }, 3, 2);
+
+		const std::vector<u8> expected = { 0x12, 0x30, 0x45, 0x60 };
+		TEST_CHECK(oddWriter.GetData() == expected);
+	}
+
+	static std::vector<u8> FlipTilePixels(const std::vector<u8>& pixels, u16 flipFlags)
+	{
+		std::vector<u8> flipped(pixels.size());
+
+		for (int y = 0; y < s_testTileSize; y++)
+		{
+			for (int x = 0; x < s_testTileSize; x++)
+			{
+				int srcX = (flipFlags & Map::eFlipX) ? (s_testTileSize - 1 - x) : x;
+				int srcY = (flipFlags & Map::eFlipY) ? (s_testTileSize - 1 - y) : y;
+				flipped[(y * s_testTileSize) + x] = pixels[(srcY * s_testTileSize) + srcX];
+			}
+		}
+
+		return flipped;
+	}
+
+	LUMINARY_TEST(TilesetExporter_DedupesFlippedTiles)
+	{
+		//Asymmetric in both axes, so no flip of it matches another
+		std::vector<u8> tileA = MakeTilePixels(1);
+		std::vector<u8> tileB = MakeTilePixels(2);
+		TEST_CHECK(FlipTilePixels(tileA, Map::eFlipX) != tileA);
+		TEST_CHECK(FlipTilePixels(tileA, Map::eFlipY) != tileA);
+		TEST_CHECK(FlipTilePixels(tileA, Map::eFlipX | Map::eFlipY) != tileA);
+
+		//Original tile ids 0-6
+		const std::vector<u8> tiles[] =
+		{
+			tileA,
+			tileB,
+			tileA,
+			FlipTilePixels(tileA, Map::eFlipX),
+			FlipTilePixels(tileA, Map::eFlipY),
+			FlipTilePixels(tileA, Map::eFlipX | Map::eFlipY),
+			FlipTilePixels(tileB, Map::eFlipY),
+		};
+
+		const TilesetExporter::TileRemap expected[] =
+		{
+			{ 0, 0 },
+			{ 1, 0 },
+			{ 0, 0 },
+			{ 0, Map::eFlipX },
+			{ 0, Map::eFlipY },
+			{ 0, Map::eFlipX | Map::eFlipY },
+			{ 1, Map::eFlipY },
+		};
+
+		TilesetExporter exporter;
+		exporter.BeginUniqueTiles(s_testTileSize, s_testTileSize, 7);
+
+		for (int i = 0; i < 7; i++)
+		{
+			TilesetExporter::TileRemap remap = exporter.AddUniqueTile(tiles[i]);
+			TEST_CHECK_EQUAL(remap.tileId, expected[i].tileId);
+			TEST_CHECK_EQUAL(remap.flipFlags, expected[i].flipFlags);
+		}
+
+		TEST_CHECK_EQUAL(exporter.GetNumUniqueTiles(), 2);
+		TEST_CHECK_EQUAL(exporter.GetNumTilesSaved(), 5);
+
+		//Stamp words point at the first tile, flips XORed so the duplicate still draws as placed
+		const u16 flipH = 1 << 11;
+		const u16 flipV = 1 << 12;
+		const u16 highPlane = 1 << 15;
+
+		TEST_CHECK_EQUAL(exporter.GetTileWord(2, 0, 0), 0);
+		TEST_CHECK_EQUAL(exporter.GetTileWord(3, 0, 0), flipH);
+		TEST_CHECK_EQUAL(exporter.GetTileWord(4, 0, 0), flipV);
+		TEST_CHECK_EQUAL(exporter.GetTileWord(5, 0, 0), flipH | flipV);
+		TEST_CHECK_EQUAL(exporter.GetTileWord(6, 0, 0), 1 | flipV);
+
+		//Placed flipped, a flipped duplicate flips back
+		TEST_CHECK_EQUAL(exporter.GetTileWord(3, Map::eFlipX, 0), 0);
+		TEST_CHECK_EQUAL(exporter.GetTileWord(5, Map::eFlipX, 0), flipV);
+		TEST_CHECK_EQUAL(exporter.GetTileWord(4, Map::eFlipX | Map::eFlipY | Map::eHighPlane, 0), flipH | highPlane);
+
+		//Palette comes from the original tile, not the unique tile it was folded into
+		TEST_CHECK_EQUAL(exporter.GetTileWord(0, 0, 1), (1 << 13));
+		TEST_CHECK_EQUAL(exporter.GetTileWord(3, 0, 3), flipH | (3 << 13));
+		TEST_CHECK_EQUAL(exporter.GetTileWord(5, Map::eHighPlane, 2), flipH | flipV | (2 << 13) | highPlane);
+
+		//Ids past the remap (e.g. not deduplicated) are written as-is
+		TEST_CHECK_EQUAL(exporter.GetTileWord(9, Map::eFlipY, 0), 9 | flipV);
+
+		//Begin starts over
+		exporter.BeginUniqueTiles(s_testTileSize, s_testTileSize, 1);
+		TEST_CHECK_EQUAL(exporter.AddUniqueTile(tiles[3]).tileId, 0);
+		TEST_CHECK_EQUAL(exporter.AddUniqueTile(tiles[0]).flipFlags, Map::eFlipX);
+		TEST_CHECK_EQUAL(exporter.GetNumUniqueTiles(), 1);
+	}
+
+	LUMINARY_TEST(TilesetExporter_SymmetricTileMatchesUnflipped)
+	{
+		//Mirrored left to right, so identical and H flip both match - the unflipped match wins
+		std::vector<u8> symmetric(s_testTileSize * s_testTileSize);
+
+		for (int y = 0; y < s_testTileSize; y++)
+		{
+			for (int x = 0; x < s_testTileSize / 2; x++)
+			{
+				symmetric[(y * s_testTileSize) + x] = (u8)((x + y) & 0xF);
+				symmetric[(y * s_testTileSize) + (s_testTileSize - 1 - x)] = (u8)((x + y) & 0xF);
+			}
+		}
+
+		TilesetExporter exporter;
+		exporter.BeginUniqueTiles(s_testTileSize, s_testTileSize, 3);
+		exporter.AddUniqueTile(symmetric);
+
+		TilesetExporter::TileRemap remap = exporter.AddUniqueTile(symmetric);
+		TEST_CHECK_EQUAL(remap.tileId, 0);
+		TEST_CHECK_EQUAL(remap.flipFlags, 0);
+
+		remap = exporter.AddUniqueTile(FlipTilePixels(symmetric, Map::eFlipY));
+		TEST_CHECK_EQUAL(remap.tileId, 0);
+		TEST_CHECK_EQUAL(remap.flipFlags, Map::eFlipY);
+	}
+
+	//Exported words for a 4x2 stamp, varied tile index, flips and palette
+	static std::vector<u16> MakeStampWords(u16 firstTile)
+	{
+		std::vector<u16> words(4 * 2);
+
+		for (int i = 0; i < words.size(); i++)
+		{
+			u16 flips = ((i % 3) == 1) ? 0x0800 : ((i % 3) == 2) ? 0x1000 : 0;
+			words[i] = (u16)((firstTile + i) | flips | ((i & 3) << 13));
+		}
+
+		return words;
+	}
+
+	LUMINARY_TEST(TilesetExporter_FlipsStampWords)
+	{
+		//2x2, tile order mirrored and each tile's H/V bits toggled, palette and priority untouched
+		const std::vector<u16> words = { 0x0001, 0x0802, 0x9003, 0x5804 };
+		std::vector<u16> flipped;
+
+		TilesetExporter::GetFlippedStampWords(words, 2, 2, 0, flipped);
+		TEST_CHECK(flipped == words);
+
+		TilesetExporter::GetFlippedStampWords(words, 2, 2, Map::eFlipX, flipped);
+		TEST_CHECK(flipped == std::vector<u16>({ 0x0002, 0x0801, 0x5004, 0x9803 }));
+
+		TilesetExporter::GetFlippedStampWords(words, 2, 2, Map::eFlipY, flipped);
+		TEST_CHECK(flipped == std::vector<u16>({ 0x8003, 0x4804, 0x1001, 0x1802 }));
+
+		TilesetExporter::GetFlippedStampWords(words, 2, 2, Map::eFlipX | Map::eFlipY, flipped);
+		TEST_CHECK(flipped == std::vector<u16>({ 0x4004, 0x8803, 0x1002, 0x1801 }));
+
+		//Flipping twice is a no-op
+		std::vector<u16> restored;
+		TilesetExporter::GetFlippedStampWords(flipped, 2, 2, Map::eFlipX | Map::eFlipY, restored);
+		TEST_CHECK(restored == words);
+	}
+
+	LUMINARY_TEST(TilesetExporter_DedupesFlippedStamps)
+	{
+		std::vector<u16> stampA = MakeStampWords(0x10);
+		std::vector<u16> stampB = MakeStampWords(0x40);
+
+		std::vector<u16> mirrorX;
+		std::vector<u16> mirrorY;
+		std::vector<u16> mirrorXY;
+		TilesetExporter::GetFlippedStampWords(stampA, 4, 2, Map::eFlipX, mirrorX);
+		TilesetExporter::GetFlippedStampWords(stampA, 4, 2, Map::eFlipY, mirrorY);
+		TilesetExporter::GetFlippedStampWords(stampB, 4, 2, Map::eFlipX | Map::eFlipY, mirrorXY);
+
+		//Tile order mirrored but the tiles themselves unflipped, it doesn't draw as A flipped
+		std::vector<u16> reordered(stampA.size());
+		for (int y = 0; y < 2; y++)
+			for (int x = 0; x < 4; x++)
+				reordered[(y * 4) + x] = stampA[(y * 4) + (3 - x)];
+
+		TilesetExporter exporter;
+		exporter.BeginUniqueStamps(7);
+
+		const TilesetExporter::StampRemap expected[] =
+		{
+			{ 0, 0 },
+			{ 1, 0 },
+			{ 0, 0 },
+			{ 0, Map::eFlipX },
+			{ 0, Map::eFlipY },
+			{ 1, Map::eFlipX | Map::eFlipY },
+			{ 2, 0 },
+		};
+
+		const std::vector<u16>* stamps[] = { &stampA, &stampB, &stampA, &mirrorX, &mirrorY, &mirrorXY, &reordered };
+
+		for (int i = 0; i < 7; i++)
+		{
+			TilesetExporter::StampRemap remap = exporter.AddUniqueStamp(*stamps[i], 4, 2);
+			TEST_CHECK_EQUAL(remap.stampId, expected[i].stampId);
+			TEST_CHECK_EQUAL(remap.flipFlags, expected[i].flipFlags);
+		}
+
+		TEST_CHECK_EQUAL(exporter.GetNumUniqueStamps(), 3);
+		TEST_CHECK_EQUAL(exporter.GetNumStampsSaved(), 4);
+		TEST_CHECK_EQUAL(exporter.GetStampRemap().size(), 7);
+		TEST_CHECK_EQUAL(exporter.GetStampRemap()[3].flipFlags, Map::eFlipX);
+
+		//Same words in another shape is another stamp
+		TEST_CHECK_EQUAL(exporter.AddUniqueStamp(stampA, 2, 4).stampId, 3);
+		TEST_CHECK_EQUAL(exporter.AddUniqueStamp(stampA, 2, 4).stampId, 3);
+
+		//Begin starts over
+		exporter.BeginUniqueStamps(2);
+		TEST_CHECK_EQUAL(exporter.AddUniqueStamp(mirrorX, 4, 2).stampId, 0);
+		TEST_CHECK_EQUAL(exporter.AddUniqueStamp(stampA, 4, 2).flipFlags, Map::eFlipX);
+		TEST_CHECK_EQUAL(exporter.GetNumUniqueStamps(), 1);
+	}
+
+	LUMINARY_BENCHMARK(TilesetExporter_ExportTileset)
+	{
+		//2048 8x8 tiles, one File::Write per byte (the previous ExportTileset) against
+		//the BinaryWriter path, reserved up front and flushed once
+		const int numTiles = 2048;
+		const int tileBytes = (s_testTileSize / 2) * s_testTileSize;
+		std::string tempDir = test::MakeTempDir("tileset_export_benchmark");
+
+		std::vector<std::vector<u8>> tiles;
+		for (int i = 0; i < numTiles; i++)
+		{
+			tiles.push_back(MakeTilePixels((u32)i));
+		}
+
+		double startTime = test::GetTimeMs();
+		{
+			ion::io::File file(tempDir + "/PERBYTE.BIN", ion::io::File::OpenMode::Write);
+			for (int i = 0; i < numTiles; i++)
+			{
+				for (int y = 0; y < s_testTileSize; y++)
+				{
+					for (int x = 0; x < s_testTileSize; x += 2)
+					{
+						u8 nybble1 = tiles[i][(y * s_testTileSize) + x] << 4;
+						u8 nybble2 = tiles[i][(y * s_testTileSize) + x + 1];
+
+						u8 byte = nybble1 | nybble2;
+						file.Write(&byte, sizeof(u8));
+					}
+				}
+			}
+			file.Close();
+		}
+		double perByteTime = test::GetTimeMs() - startTime;
+
+		startTime = test::GetTimeMs();
+		{
+			BinaryWriter writer;
+			writer.Reserve(numTiles * tileBytes);
+
+			for (int i = 0; i < numTiles; i++)
+			{
+				TilesetExporter::WriteTilePixels(writer, tiles[i], s_testTileSize, s_testTileSize);
+			}
+
+			writer.Flush(tempDir + "/BUFFERED.BIN");
+		}
+		double bufferedTime = test::GetTimeMs() - startTime;
+
+		if (test::ReadTextFile(tempDir + "/PERBYTE.BIN") != test::ReadTextFile(tempDir + "/BUFFERED.BIN"))
+		{
+			test::Fail(__FILE__, __LINE__, "per byte and buffered tilesets differ");
+			return;
+		}
+
+		printf("    %d tiles (%d bytes): per byte write %.2f ms, BinaryWriter %.2f ms (%.1fx)\n", numTiles, numTiles * tileBytes, perByteTime, bufferedTime, (bufferedTime > 0.0) ? (perByteTime / bufferedTime) : 0.0);
+	}
+}